@@ -0,0 +1,179 @@
+#include "bench_data.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+#include "common.h"
+#include "psl.h"
+
+BenchDirectory::BenchDirectory() {
+    std::string pattern = (std::filesystem::temp_directory_path() / "denovofusion_bench.XXXXXX").string();
+    crash(mkdtemp(&pattern[0]) == nullptr, "failed to create temporary directory: " + pattern);
+    path_ = pattern;
+}
+
+BenchDirectory::~BenchDirectory() {
+    std::error_code error;
+    std::filesystem::remove_all(path_, error);
+}
+
+std::string source_path(const std::string& relative_path) {
+    return std::string(DENOVOFUSION_SOURCE_DIR) + "/" + relative_path;
+}
+
+size_t file_size(const std::string& filename) {
+    std::error_code error;
+    auto size = std::filesystem::file_size(filename, error);
+    return error ? 0 : size;
+}
+
+// Convert the PSL records to primary PAF records of the same alignments
+static void write_paf(const std::string& psl_file, const std::string& paf_file) {
+    std::vector<psl_t> psls;
+    psl_parse(psl_file, psls);
+    std::ofstream paf(paf_file);
+    for (const auto& psl : psls) {
+        paf << psl.qName << '\t' << psl.qSize << '\t' << psl.qStart << '\t' << psl.qEnd << '\t' << psl.strand << '\t'
+            << psl.tName << '\t' << psl.tSize << '\t' << psl.tStart << '\t' << psl.tEnd << '\t'
+            << psl.matches << '\t' << psl.qEnd - psl.qStart << '\t' << 60 << '\t'
+            << "tp:A:P\tNM:i:" << psl.misMatches << '\n';
+    }
+}
+
+const bench_input_t& test_input() {
+    static bench_input_t input;
+    static BenchDirectory directory;
+    if (input.psl.empty()) {
+        input.psl = source_path("test/test.psl");
+        input.assembly = source_path("test/test.fa");
+        input.realignment = source_path("test/test.sam");
+        input.gtf = source_path("test/test.gtf");
+        input.fastq1 = source_path("test/test.01.fastq.gz");
+        input.fastq2 = source_path("test/test.02.fastq.gz");
+        input.paf = directory.path() + "/test.paf";
+        write_paf(input.psl, input.paf);
+
+        std::unordered_set<std::string> contigs;
+        std::ifstream psl(input.psl);
+        std::string line;
+        while (std::getline(psl, line)) {
+            std::istringstream fields(line);
+            std::string field;
+            for (int i = 0; i < 10 && fields >> field; ++i) {}
+            contigs.insert(field);
+        }
+        input.contigs = contigs.size();
+    }
+    return input;
+}
+
+// Rename the contig of a (cut) contig name, e.g. k99_964195_3 -> k99_964195c2_3 in the second copy
+static std::string scaled_name(const std::string& name, const std::string& base, int copy) {
+    if (copy == 0 || name.compare(0, base.size(), base) != 0)
+        return name;
+    return base + "c" + std::to_string(copy) + name.substr(base.size());
+}
+
+bench_input_t scaled_input(int scale, const std::string& directory) {
+    const bench_input_t& test = test_input();
+    const std::string base = "k99_964195";   // the single assembled contig of the test data
+
+    bench_input_t input = test;
+    input.psl = directory + "/scaled.psl";
+    input.assembly = directory + "/scaled.fa";
+    input.realignment = directory + "/scaled.sam";
+    input.paf = directory + "/scaled.paf";
+    input.contigs = test.contigs * scale;
+
+    std::ofstream psl(input.psl), fasta(input.assembly), sam(input.realignment);
+    std::string line;
+    for (int copy = 0; copy < scale; ++copy) {
+        // PSL: the query name is the 10th column
+        std::ifstream test_psl(test.psl);
+        while (std::getline(test_psl, line)) {
+            std::vector<std::string> fields;
+            std::istringstream columns(line);
+            std::string field;
+            while (std::getline(columns, field, '\t'))
+                fields.push_back(field);
+            if (fields.size() > 9)
+                fields[9] = scaled_name(fields[9], base, copy);
+            for (size_t i = 0; i < fields.size(); ++i)
+                psl << (i > 0 ? "\t" : "") << fields[i];
+            psl << '\n';
+        }
+
+        std::ifstream test_fasta(test.assembly);
+        while (std::getline(test_fasta, line)) {
+            if (!line.empty() && line[0] == '>')
+                line = ">" + scaled_name(line.substr(1), base, copy);
+            fasta << line << '\n';
+        }
+
+        // SAM: the reads get a distinct name in each copy, the reference is the renamed contig
+        std::ifstream test_sam(test.realignment);
+        while (std::getline(test_sam, line)) {
+            if (line.empty() || line[0] == '@')
+                continue;
+            size_t qname_end = line.find('\t');
+            size_t flag_end = line.find('\t', qname_end + 1);
+            size_t rname_end = line.find('\t', flag_end + 1);
+            std::string qname = line.substr(0, qname_end);
+            std::string rname = line.substr(flag_end + 1, rname_end - flag_end - 1);
+            if (copy > 0)
+                qname += "c" + std::to_string(copy);
+            sam << qname << line.substr(qname_end, flag_end - qname_end) << '\t' << scaled_name(rname, base, copy) << line.substr(rname_end) << '\n';
+        }
+    }
+    psl.close();
+    write_paf(input.psl, input.paf);
+    return input;
+}
+
+options_t bench_options(const bench_input_t& input, const std::string& input_type, const std::string& output) {
+    options_t options = get_default_options();
+    options.input_type = input_type;
+    options.input_file = input_type == "blat" ? input.psl : input.paf;
+    options.input_assembly = input.assembly;
+    options.output = output;
+    options.prefix = "bench";
+    options.gtf_path = input.gtf;
+    options.input_fastq1 = {input.fastq1};
+    options.input_fastq2 = {input.fastq2};
+    options.read_length = 100;
+    options.threads = 4;
+    options.known_fusions = source_path("known_fusions.tsv");
+    options.log_level = "error";
+    return options;
+}
+
+// Stream buffer which discards everything
+class NullBuffer: public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+bool run_quiet(Pipeline& pipeline) {
+    NullBuffer null_buffer;
+    std::streambuf* stdout_buffer = std::cout.rdbuf(&null_buffer);
+    bool success = pipeline.run();
+    std::cout.rdbuf(stdout_buffer);
+    return success;
+}
+
+const bench_fixture_t& test_fixture() {
+    static std::unique_ptr<bench_fixture_t> fixture;
+    if (!fixture) {
+        fixture.reset(new bench_fixture_t());
+        fixture->options = bench_options(test_input(), "blat", fixture->output.path());
+        fixture->adapter = make_input_adapter("blat");
+        fixture->pipeline.reset(new Pipeline(fixture->options, *fixture->adapter));
+        fixture->pipeline->use_realignment(test_input().realignment);
+        crash(!run_quiet(*fixture->pipeline), "failed to run the pipeline on the test data");
+    }
+    return *fixture;
+}
@@ -0,0 +1,65 @@
+#ifndef BENCH_DATA_H
+#define BENCH_DATA_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "input_adapter.h"
+#include "options.h"
+#include "pipeline.h"
+
+// Input files of a benchmark run, the realignment replaces the bowtie2 step
+struct bench_input_t {
+    std::string psl;
+    std::string paf;
+    std::string assembly;
+    std::string realignment;
+    std::string gtf;
+    std::string fastq1;
+    std::string fastq2;
+    size_t contigs = 0;
+};
+
+// Temporary directory which is removed with all its content
+class BenchDirectory {
+public:
+    BenchDirectory();
+    ~BenchDirectory();
+    BenchDirectory(const BenchDirectory&) = delete;
+    BenchDirectory& operator=(const BenchDirectory&) = delete;
+    const std::string& path() const { return path_; }
+private:
+    std::string path_;
+};
+
+// Path of a file in the source tree, e.g. "test/test.psl"
+std::string source_path(const std::string& relative_path);
+
+// Size of a file in bytes
+size_t file_size(const std::string& filename);
+
+// The bundled test data
+const bench_input_t& test_input();
+
+// The test data replicated scale times with renamed contigs and reads, written to the directory
+bench_input_t scaled_input(int scale, const std::string& directory);
+
+// Options of a benchmark run, same as test.sh
+options_t bench_options(const bench_input_t& input, const std::string& input_type, const std::string& output);
+
+// A pipeline run on the test data, the intermediate results are used as input of the microbenchmarks
+struct bench_fixture_t {
+    BenchDirectory output;
+    options_t options;
+    std::unique_ptr<InputAdapter> adapter;
+    std::unique_ptr<Pipeline> pipeline;
+};
+const bench_fixture_t& test_fixture();
+
+// Run a pipeline with the standard output discarded
+bool run_quiet(Pipeline& pipeline);
+
+void register_macro_benchmarks(const std::vector<int>& scales);
+
+#endif //BENCH_DATA_H
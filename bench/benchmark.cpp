@@ -0,0 +1,218 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "bench_data.h"
+#include "common.h"
+#include "options.h"
+
+namespace bench {
+
+static double real_time() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double cpu_time() {
+    struct timespec time;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+bool State::keep_running() {
+    if (done_ == 0 && !running_)
+        resume_timing();
+    if (done_ < iterations_) {
+        ++done_;
+        return true;
+    }
+    pause_timing();
+    return false;
+}
+
+void State::pause_timing() {
+    if (!running_)
+        return;
+    real_seconds_ += real_time() - real_start_;
+    cpu_seconds_ += cpu_time() - cpu_start_;
+    running_ = false;
+}
+
+void State::resume_timing() {
+    if (running_)
+        return;
+    real_start_ = real_time();
+    cpu_start_ = cpu_time();
+    running_ = true;
+}
+
+
+struct benchmark_t {
+    std::string name;
+    function_t function;
+};
+
+static std::vector<benchmark_t>& benchmarks() {
+    static std::vector<benchmark_t> registered;
+    return registered;
+}
+
+int register_benchmark(const std::string& name, const function_t& function) {
+    benchmarks().push_back({name, function});
+    return 0;
+}
+
+struct report_t {
+    std::string name;
+    uint64_t iterations;
+    double real_ns;             // per iteration, median of the repetitions
+    double cpu_ns;
+    double items_per_second;
+    double bytes_per_second;
+};
+
+// Grow the number of iterations until a run takes the minimum time, then repeat it
+static report_t run_benchmark(const benchmark_t& benchmark, double min_time, int repetitions) {
+    uint64_t iterations = 1;
+    while (true) {
+        State state(iterations);
+        benchmark.function(state);
+        if (state.real_seconds() >= min_time || iterations >= 1000000000)
+            break;
+        double factor = state.real_seconds() > 0 ? 1.4 * min_time / state.real_seconds() : 10;
+        iterations = std::max<uint64_t>(iterations + 1, iterations * std::min(factor, 10.0));
+    }
+
+    std::vector<State> runs;
+    for (int i = 0; i < repetitions; ++i) {
+        runs.emplace_back(iterations);
+        benchmark.function(runs.back());
+    }
+    std::sort(runs.begin(), runs.end(), [](const State& a, const State& b) { return a.real_seconds() < b.real_seconds(); });
+    const State& median = runs[runs.size() / 2];
+
+    report_t report;
+    report.name = benchmark.name;
+    report.iterations = iterations;
+    report.real_ns = median.real_seconds() * 1e9 / iterations;
+    report.cpu_ns = median.cpu_seconds() * 1e9 / iterations;
+    report.items_per_second = median.real_seconds() > 0 ? median.items_processed() / median.real_seconds() : 0;
+    report.bytes_per_second = median.real_seconds() > 0 ? median.bytes_processed() / median.real_seconds() : 0;
+    return report;
+}
+
+static std::string human_rate(double rate, const std::string& unit) {
+    const char* prefixes[] = {"", "k", "M", "G", "T"};
+    int prefix = 0;
+    while (rate >= 1000 && prefix < 4) {
+        rate /= 1000;
+        ++prefix;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << rate << prefixes[prefix] << unit;
+    return out.str();
+}
+
+static void write_json(const std::string& filename, const std::vector<report_t>& reports) {
+    std::ofstream out(filename);
+    crash(!out, "failed to open benchmark report: " + filename);
+
+    char date[64];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"context\": {\"date\": \"" << date << "\", \"version\": \"" << DENOVOFUSION_VERSION
+        << "\", \"num_cpus\": " << std::thread::hardware_concurrency() << "},\n  \"benchmarks\": [";
+    for (size_t i = 0; i < reports.size(); ++i) {
+        const report_t& report = reports[i];
+        out << (i > 0 ? ",\n" : "\n")
+            << "    {\"name\": \"" << report.name << "\", \"iterations\": " << report.iterations
+            << ", \"real_time_ns\": " << report.real_ns << ", \"cpu_time_ns\": " << report.cpu_ns
+            << ", \"items_per_second\": " << report.items_per_second << ", \"bytes_per_second\": " << report.bytes_per_second << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+static void print_usage() {
+    std::cout << "Usage: denovofusion_bench [options]" << std::endl
+              << "  --filter <text>      only run the benchmarks whose name contains the text" << std::endl
+              << "  --min-time <sec>     minimum measured time of a run (Default: 0.5)" << std::endl
+              << "  --repetitions <n>    number of measured runs, the median is reported (Default: 3)" << std::endl
+              << "  --scale <n,...>      replication factors of the test data for the macro benchmarks (Default: 4)" << std::endl
+              << "  --json <file>        write the results as JSON" << std::endl
+              << "  --list               list the benchmarks and exit" << std::endl;
+}
+
+} // namespace bench
+
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string json_file;
+    double min_time = 0.5;
+    int repetitions = 3;
+    std::vector<int> scales = {4};
+    bool list = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--filter" && has_value) {
+            filter = argv[++i];
+        } else if (arg == "--json" && has_value) {
+            json_file = argv[++i];
+        } else if (arg == "--min-time" && has_value) {
+            float value;
+            crash(!str_to_float(argv[++i], value) || value <= 0, "invalid argument to --min-time");
+            min_time = value;
+        } else if (arg == "--repetitions" && has_value) {
+            crash(!str_to_int(argv[++i], repetitions) || repetitions < 1, "invalid argument to --repetitions");
+        } else if (arg == "--scale" && has_value) {
+            scales.clear();
+            std::istringstream values(argv[++i]);
+            std::string value;
+            while (std::getline(values, value, ',')) {
+                int scale;
+                crash(!str_to_int(value.c_str(), scale) || scale < 1, "invalid argument to --scale: " + value);
+                scales.push_back(scale);
+            }
+        } else if (arg == "--list") {
+            list = true;
+        } else {
+            bench::print_usage();
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    register_macro_benchmarks(scales);
+
+    std::vector<bench::report_t> reports;
+    if (!list)
+        std::cout << std::left << std::setw(44) << "Benchmark" << std::right << std::setw(14) << "Time/iter" << std::setw(14) << "CPU/iter"
+              << std::setw(12) << "Iterations" << std::setw(16) << "Items/s" << std::setw(14) << "Bytes/s" << std::endl;
+    for (const auto& benchmark : bench::benchmarks()) {
+        if (benchmark.name.find(filter) == std::string::npos)
+            continue;
+        if (list) {
+            std::cout << benchmark.name << std::endl;
+            continue;
+        }
+        bench::report_t report = bench::run_benchmark(benchmark, min_time, repetitions);
+        std::cout << std::left << std::setw(44) << report.name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(12) << report.real_ns << "ns" << std::setw(12) << report.cpu_ns << "ns" << std::setw(12) << report.iterations
+                  << std::setw(16) << bench::human_rate(report.items_per_second, "/s") << std::setw(14) << bench::human_rate(report.bytes_per_second, "B/s") << std::endl;
+        reports.push_back(report);
+    }
+
+    if (!json_file.empty())
+        bench::write_json(json_file, reports);
+    return 0;
+}
@@ -0,0 +1,63 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Minimal benchmark harness in the style of Google Benchmark: a benchmark function loops while
+// state.keep_running() and reports the number of processed items, the harness chooses the number of
+// iterations, repeats the measurement and reports the median
+namespace bench {
+
+class State {
+public:
+    explicit State(uint64_t iterations): iterations_(iterations) {}
+
+    // Returns true while iterations are left, the time is measured from the first to the last call
+    bool keep_running();
+
+    // Exclude setup work inside the loop from the measurement
+    void pause_timing();
+    void resume_timing();
+
+    void set_items_processed(uint64_t items) { items_processed_ = items; }
+    void set_bytes_processed(uint64_t bytes) { bytes_processed_ = bytes; }
+
+    uint64_t iterations() const { return iterations_; }
+    uint64_t items_processed() const { return items_processed_; }
+    uint64_t bytes_processed() const { return bytes_processed_; }
+    double real_seconds() const { return real_seconds_; }
+    double cpu_seconds() const { return cpu_seconds_; }
+
+private:
+    uint64_t iterations_;
+    uint64_t done_ = 0;
+    bool running_ = false;
+    double real_start_ = 0;
+    double cpu_start_ = 0;
+    double real_seconds_ = 0;
+    double cpu_seconds_ = 0;
+    uint64_t items_processed_ = 0;
+    uint64_t bytes_processed_ = 0;
+};
+
+typedef std::function<void(State&)> function_t;
+
+// Register a benchmark, returns a dummy value for static registration
+int register_benchmark(const std::string& name, const function_t& function);
+
+// Keep the compiler from optimizing away a computed value
+template <class T> inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace bench
+
+#define BENCHMARK_CONCAT2(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT2(a, b)
+#define BENCHMARK_NAMED(name, function) \
+    static int BENCHMARK_CONCAT(benchmark_registration_, __LINE__) = bench::register_benchmark(name, function)
+#define BENCHMARK(function) BENCHMARK_NAMED(#function, function)
+
+#endif //BENCHMARK_H
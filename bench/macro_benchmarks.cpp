@@ -0,0 +1,42 @@
+#include <memory>
+
+#include "bench_data.h"
+#include "benchmark.h"
+#include "common.h"
+
+// Run the whole pipeline on an input, the existing realignment replaces bowtie2
+static void run_pipeline(bench::State& state, const bench_input_t& input) {
+    size_t alignments = 0;
+    while (state.keep_running()) {
+        state.pause_timing();
+        BenchDirectory output;
+        options_t options = bench_options(input, "blat", output.path());
+        std::unique_ptr<InputAdapter> adapter = make_input_adapter(options.input_type);
+        Pipeline pipeline(options, *adapter);
+        pipeline.use_realignment(input.realignment);
+        state.resume_timing();
+
+        crash(!run_quiet(pipeline), "failed to run the pipeline on " + input.psl);
+        alignments = pipeline.input_alignments();
+    }
+    // Throughput in input alignments, the bytes cover the PSL and the realigned reads
+    state.set_items_processed(state.iterations() * alignments);
+    state.set_bytes_processed(state.iterations() * (file_size(input.psl) + file_size(input.realignment)));
+}
+
+void register_macro_benchmarks(const std::vector<int>& scales) {
+    bench::register_benchmark("pipeline/test", [](bench::State& state) {
+        run_pipeline(state, test_input());
+    });
+
+    for (int scale : scales) {
+        // The scaled input is written once and shared by all runs of the benchmark
+        auto directory = std::make_shared<BenchDirectory>();
+        auto input = std::make_shared<bench_input_t>();
+        bench::register_benchmark("pipeline/scaled_x" + std::to_string(scale), [scale, directory, input](bench::State& state) {
+            if (input->psl.empty())
+                *input = scaled_input(scale, directory->path());
+            run_pipeline(state, *input);
+        });
+    }
+}
@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "alignments_chosen.h"
+#include "annotation.h"
+#include "bench_data.h"
+#include "benchmark.h"
+#include "contig_pair_index.h"
+#include "coverage.h"
+#include "fasta.h"
+#include "filter_chain.h"
+#include "filter_homologs.h"
+#include "input_adapter.h"
+#include "paf.h"
+#include "psl.h"
+#include "realign_support.h"
+#include "sam.h"
+
+
+// Parsers of the input files
+
+static void parse_psl(bench::State& state) {
+    const std::string& filename = test_input().psl;
+    std::vector<psl_t> psls;
+    while (state.keep_running()) {
+        psl_parse(filename, psls);
+        bench::do_not_optimize(psls.data());
+    }
+    state.set_items_processed(state.iterations() * psls.size());
+    state.set_bytes_processed(state.iterations() * file_size(filename));
+}
+BENCHMARK_NAMED("parse/psl", parse_psl);
+
+static void parse_paf(bench::State& state) {
+    const std::string& filename = test_input().paf;
+    std::vector<paf_t> pafs;
+    while (state.keep_running()) {
+        paf_parse(filename, pafs);
+        bench::do_not_optimize(pafs.data());
+    }
+    state.set_items_processed(state.iterations() * pafs.size());
+    state.set_bytes_processed(state.iterations() * file_size(filename));
+}
+BENCHMARK_NAMED("parse/paf", parse_paf);
+
+// Chunked parsing of the input alignments through the adapters, with one thread and with all cores
+static void parse_alignments(bench::State& state, const std::string& input_type, const std::string& filename, int threads) {
+    std::unique_ptr<InputAdapter> adapter = make_input_adapter(input_type);
+    FastaIndex fasta;
+    size_t records = 0;
+    while (state.keep_running()) {
+        std::vector<alignment_t> alignments;
+        adapter->load(filename, fasta, threads, alignments);
+        records = alignments.size();
+        bench::do_not_optimize(alignments.data());
+    }
+    state.set_items_processed(state.iterations() * records);
+    state.set_bytes_processed(state.iterations() * file_size(filename));
+}
+
+static int all_cores() {
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+static void parse_psl_chunked(bench::State& state) {
+    parse_alignments(state, "blat", test_input().psl, 1);
+}
+BENCHMARK_NAMED("parse/psl_chunked", parse_psl_chunked);
+
+static void parse_psl_chunked_threads(bench::State& state) {
+    parse_alignments(state, "blat", test_input().psl, all_cores());
+}
+BENCHMARK_NAMED("parse/psl_chunked_threads", parse_psl_chunked_threads);
+
+static void parse_paf_chunked(bench::State& state) {
+    parse_alignments(state, "minimap2paf", test_input().paf, 1);
+}
+BENCHMARK_NAMED("parse/paf_chunked", parse_paf_chunked);
+
+static void parse_paf_chunked_threads(bench::State& state) {
+    parse_alignments(state, "minimap2paf", test_input().paf, all_cores());
+}
+BENCHMARK_NAMED("parse/paf_chunked_threads", parse_paf_chunked_threads);
+
+static void parse_sam(bench::State& state) {
+    const std::string& filename = test_input().realignment;
+    size_t reads = 0;
+    while (state.keep_running()) {
+        std::vector<sam_t> sams;
+        SamFileCls samFile(filename);
+        sam_t sam;
+        while (samFile.next(sam)) {
+            sams.push_back(sam);
+        }
+        reads = sams.size();
+        bench::do_not_optimize(sams.data());
+    }
+    state.set_items_processed(state.iterations() * reads);
+    state.set_bytes_processed(state.iterations() * file_size(filename));
+}
+BENCHMARK_NAMED("parse/sam", parse_sam);
+
+static void parse_fasta(bench::State& state) {
+    const std::string& filename = test_input().assembly;
+    size_t sequences = 0;
+    while (state.keep_running()) {
+        auto fasta_sequences = load_fasta_sequences(filename);
+        sequences = fasta_sequences.size();
+    }
+    state.set_items_processed(state.iterations() * sequences);
+    state.set_bytes_processed(state.iterations() * file_size(filename));
+}
+BENCHMARK_NAMED("parse/fasta", parse_fasta);
+
+// Opening the assembly with the cached .fai index and reading every contig from the mapped file
+static void parse_fasta_index(bench::State& state) {
+    const std::string& filename = test_input().assembly;
+    size_t sequences = 0;
+    while (state.keep_running()) {
+        FastaIndex fasta;
+        fasta.open(filename);
+        size_t bases = 0;
+        for (const auto& name : fasta.names()) {
+            bases += fasta.sequence(name).size();
+        }
+        bench::do_not_optimize(&bases);
+        sequences = fasta.size();
+    }
+    state.set_items_processed(state.iterations() * sequences);
+    state.set_bytes_processed(state.iterations() * file_size(filename));
+}
+BENCHMARK_NAMED("parse/fasta_index", parse_fasta_index);
+
+
+// Stage1: scoring of the alignment combinations of each contig
+
+static void calculate_scores(bench::State& state) {
+    const bench_fixture_t& fixture = test_fixture();
+    std::vector<alignment_t> alignments;
+    make_input_adapter(fixture.options.input_type)->load(fixture.options.input_file, fixture.pipeline->fasta(), fixture.options.threads, alignments);
+    std::vector<std::unordered_map<std::string, std::vector<alignment_t>>> groups;
+    for (const auto& group : index_by_qname(alignments)) {
+        groups.push_back({group});
+    }
+    while (state.keep_running()) {
+        for (const auto& group : groups) {
+            auto chosen = calculate_alignments_score(group, fixture.options);
+            bench::do_not_optimize(chosen.data());
+        }
+    }
+    state.set_items_processed(state.iterations() * groups.size());
+}
+BENCHMARK_NAMED("stage1/calculate_alignments_score", calculate_scores);
+
+
+// Stage3: support reads of the fusion overlaps
+
+struct support_maps_t {
+    std::unordered_map<std::string, std::vector<OverlapResultCls>> overlaps;
+    std::unordered_map<std::string, std::vector<sam_t>> reads;
+};
+
+static const support_maps_t& support_maps() {
+    static support_maps_t maps;
+    if (maps.reads.empty()) {
+        const bench_fixture_t& fixture = test_fixture();
+        for (const auto& overlap : fixture.pipeline->overlap_results())
+            maps.overlaps[overlap.query_id_].push_back(overlap);
+        for (const auto& sam : fixture.pipeline->sam_entries())
+            maps.reads[sam.rname].push_back(sam);
+    }
+    return maps;
+}
+
+static void count_split_reads(bench::State& state) {
+    const support_maps_t& maps = support_maps();
+    const options_t& options = test_fixture().options;
+    while (state.keep_running()) {
+        auto counts = countSplitReads(maps.overlaps, maps.reads, options);
+        bench::do_not_optimize(counts.size());
+    }
+    state.set_items_processed(state.iterations() * test_fixture().pipeline->sam_entries().size());
+}
+BENCHMARK_NAMED("stage3/count_split_reads", count_split_reads);
+
+static void count_span_read_pairs(bench::State& state) {
+    const support_maps_t& maps = support_maps();
+    while (state.keep_running()) {
+        auto counts = countSpanReadPairs(maps.overlaps, maps.reads);
+        bench::do_not_optimize(counts.size());
+    }
+    state.set_items_processed(state.iterations() * test_fixture().pipeline->sam_entries().size());
+}
+BENCHMARK_NAMED("stage3/count_span_read_pairs", count_span_read_pairs);
+
+// All four support counts of every contig, divided among the threads of the run
+static void count_support_reads(bench::State& state) {
+    const bench_fixture_t& fixture = test_fixture();
+    SupportContext context(fixture.pipeline->overlap_results(), fixture.pipeline->sam_entries());
+    while (state.keep_running()) {
+        support_reads_t support = context.count(fixture.options, fixture.options.threads);
+        bench::do_not_optimize(support.split_reads_count.size());
+    }
+    state.set_items_processed(state.iterations() * fixture.pipeline->sam_entries().size());
+}
+BENCHMARK_NAMED("stage3/support_context", count_support_reads);
+
+
+// Stage4: annotation, filters and coverage
+
+static void annotate(bench::State& state) {
+    const bench_fixture_t& fixture = test_fixture();
+    auto coordinations = keepOnlyTwoParts(fixture.pipeline->final_coordinations());
+    while (state.keep_running()) {
+        GeneAnnotator annotator(fixture.options.gtf_path);
+        auto annotations = annotator.annotateAlignments(coordinations);
+        bench::do_not_optimize(annotations.data());
+    }
+    state.set_items_processed(state.iterations() * coordinations.size());
+    state.set_bytes_processed(state.iterations() * file_size(fixture.options.gtf_path));
+}
+BENCHMARK_NAMED("stage4/annotation_gtf", annotate);
+
+static void filter_chain(bench::State& state) {
+    const bench_fixture_t& fixture = test_fixture();
+    const options_t& options = fixture.options;
+
+    // Copies of the test results with distinct breakpoints, so that they are no duplicates
+    std::vector<result_t> results;
+    for (const auto& result : fixture.pipeline->final_results()) {
+        for (unsigned int i = 0; i < 1000; ++i) {
+            results.push_back(result);
+            results.back().tend1 += i;
+        }
+    }
+
+    ContigPairIndex contig_pairs(fixture.pipeline->paired_alignments(), extractBaseQueryName);
+    FilterHomologs filter_homologs(results, contig_pairs, fixture.pipeline->query_coordinates());
+    while (state.keep_running()) {
+        state.pause_timing();
+        std::vector<result_t> batch = results;
+        FilterChain chain;
+        add_fusion_filters(chain, options, &filter_homologs);
+        state.resume_timing();
+
+        size_t kept = chain.apply(batch);
+        bench::do_not_optimize(kept);
+    }
+    state.set_items_processed(state.iterations() * results.size());
+}
+BENCHMARK_NAMED("stage4/filter_chain", filter_chain);
+
+static void coverage(bench::State& state) {
+    const bench_fixture_t& fixture = test_fixture();
+    while (state.keep_running()) {
+        std::unordered_map<std::string, float> averageCoverageMap;
+        std::unordered_map<std::string, std::unordered_map<int, int>> perBaseCoverageMap;
+        processCoverage(fixture.pipeline->sam_entries(), fixture.pipeline->overlap_results(), averageCoverageMap, perBaseCoverageMap);
+        bench::do_not_optimize(averageCoverageMap.size());
+    }
+    state.set_items_processed(state.iterations() * fixture.pipeline->sam_entries().size());
+}
+BENCHMARK_NAMED("stage4/coverage", coverage);
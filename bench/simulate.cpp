@@ -0,0 +1,141 @@
+#include <getopt.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "common.h"
+#include "options.h"
+#include "simulator.h"
+
+
+static void print_usage() {
+    sim_options_t defaults;
+    std::cout << std::endl
+              << "denovofusion_simulate Version: " << DENOVOFUSION_VERSION << std::endl
+              << "------------------------------------------------------------------------" << std::endl
+              << wrap_help2("Simulates de novo assembled contigs with planted fusions from a reference genome and a gene annotation. "
+                            "The contigs are written with their alignments in PSL (cut contigs), PAF and SAM format, together "
+                            "with paired-end reads of each depth and the list of the planted fusions.") << std::endl
+              << "------------------------------------------------------------------------" << std::endl
+              << "Usage: " << std::endl
+              << "denovofusion_simulate -r reference.fa -g annotation.gtf -o path/to/data [OPTIONS]" << std::endl
+              << "------------------------------------------------------------------------" << std::endl
+              << "Mandatory parameters" << std::endl
+              << wrap_help("-g", "--gtf") << std::endl
+              << wrap_help2("GTF annotation file, the fusions are planted into its genes.") << std::endl
+              << wrap_help("-o", "--output") << std::endl
+              << wrap_help2("Output directory.") << std::endl
+              << wrap_help("-r", "--reference") << std::endl
+              << wrap_help2("Reference genome in FASTA format.") << std::endl
+              << "Optional parameter" << std::endl
+              << wrap_help("-d", "--depths") << std::endl
+              << wrap_help2("Comma separated read depths, the reads of each depth are written to <depth>x/<prefix>_R1.fq and "
+                            "<depth>x/<prefix>_R2.fq. Default: 10,20,40,60,80") << std::endl
+              << wrap_help("-e", "--error-rate") << std::endl
+              << wrap_help2("Substitution rate of the reads. Default: " + std::to_string(defaults.error_rate)) << std::endl
+              << wrap_help("-f", "--fusions") << std::endl
+              << wrap_help2("Number of contigs with a planted fusion. Default: " + std::to_string(defaults.fusions)) << std::endl
+              << wrap_help("-F", "--fragment-length") << std::endl
+              << wrap_help2("Length of the fragments of the cut contigs for BLAT. Default: " + std::to_string(defaults.fragment_length)) << std::endl
+              << wrap_help("-h", "--help") << std::endl
+              << wrap_help2("Display this help message and exit.") << std::endl
+              << wrap_help("-i", "--insert-size") << std::endl
+              << wrap_help2("Mean insert size of the read pairs. Default: " + std::to_string(defaults.insert_size)) << std::endl
+              << wrap_help("-I", "--insert-size-sd") << std::endl
+              << wrap_help2("Standard deviation of the insert size. Default: " + std::to_string(defaults.insert_size_sd)) << std::endl
+              << wrap_help("-l", "--read-length") << std::endl
+              << wrap_help2("Read length. Default: " + std::to_string(defaults.read_length)) << std::endl
+              << wrap_help("-m", "--min-segment-length") << std::endl
+              << wrap_help2("Minimum length of the genomic segments of a contig, a fusion contig has two segments. Default: "
+                            + std::to_string(defaults.min_segment_length)) << std::endl
+              << wrap_help("-M", "--max-segment-length") << std::endl
+              << wrap_help2("Maximum length of the genomic segments of a contig. Default: " + std::to_string(defaults.max_segment_length)) << std::endl
+              << wrap_help("-n", "--contigs") << std::endl
+              << wrap_help2("Number of contigs, including the fusion contigs. Default: " + std::to_string(defaults.contigs)) << std::endl
+              << wrap_help("-p", "--prefix") << std::endl
+              << wrap_help2("Prefix of the output files and contig names. Default: " + defaults.prefix) << std::endl
+              << wrap_help("-s", "--seed") << std::endl
+              << wrap_help2("Seed of the random numbers, the same seed gives the same data. Default: " + std::to_string(defaults.seed)) << std::endl;
+}
+
+static sim_options_t parse_options(int argc, char** argv) {
+    sim_options_t options;
+
+    static struct option long_options[] = {
+            {"reference",          required_argument, nullptr, 'r'},
+            {"gtf",                required_argument, nullptr, 'g'},
+            {"output",             required_argument, nullptr, 'o'},
+            {"prefix",             required_argument, nullptr, 'p'},
+            {"contigs",            required_argument, nullptr, 'n'},
+            {"fusions",            required_argument, nullptr, 'f'},
+            {"depths",             required_argument, nullptr, 'd'},
+            {"read-length",        required_argument, nullptr, 'l'},
+            {"insert-size",        required_argument, nullptr, 'i'},
+            {"insert-size-sd",     required_argument, nullptr, 'I'},
+            {"error-rate",         required_argument, nullptr, 'e'},
+            {"min-segment-length", required_argument, nullptr, 'm'},
+            {"max-segment-length", required_argument, nullptr, 'M'},
+            {"fragment-length",    required_argument, nullptr, 'F'},
+            {"seed",               required_argument, nullptr, 's'},
+            {"help",               no_argument,       nullptr, 'h'},
+            {nullptr, 0, nullptr, 0}
+    };
+    const std::string valid_arguments = "r:g:o:p:n:f:d:l:i:I:e:m:M:F:s:h";
+
+    opterr = 0;
+    int c;
+    while ((c = getopt_long(argc, argv, valid_arguments.c_str(), long_options, nullptr)) != -1) {
+        switch (c) {
+            case 'r': options.reference = optarg; break;
+            case 'g': options.gtf_path = optarg; break;
+            case 'o': options.output = optarg; break;
+            case 'p': options.prefix = optarg; break;
+            case 'n': crash(!validate_int(optarg, options.contigs, 1), "invalid argument to -n"); break;
+            case 'f': crash(!validate_int(optarg, options.fusions), "invalid argument to -f"); break;
+            case 'd': {
+                options.depths.clear();
+                std::istringstream depths(optarg);
+                std::string depth;
+                while (std::getline(depths, depth, ',')) {
+                    unsigned int value;
+                    crash(!validate_int(depth.c_str(), value, 1), "invalid argument to -d: " + depth);
+                    options.depths.push_back(value);
+                }
+                break;
+            }
+            case 'l': crash(!validate_int(optarg, options.read_length, 1), "invalid argument to -l"); break;
+            case 'i': crash(!validate_int(optarg, options.insert_size, 1), "invalid argument to -i"); break;
+            case 'I': crash(!validate_int(optarg, options.insert_size_sd), "invalid argument to -I"); break;
+            case 'e': crash(!validate_float(optarg, options.error_rate, 0, 0.5), "invalid argument to -e"); break;
+            case 'm': crash(!validate_int(optarg, options.min_segment_length, 1), "invalid argument to -m"); break;
+            case 'M': crash(!validate_int(optarg, options.max_segment_length, 1), "invalid argument to -M"); break;
+            case 'F': crash(!validate_int(optarg, options.fragment_length, 1), "invalid argument to -F"); break;
+            case 's': crash(!validate_int(optarg, options.seed), "invalid argument to -s"); break;
+            case 'h':
+                print_usage();
+                exit(0);
+            default:
+                crash(valid_arguments.find(std::string(1, (char) optopt) + ":") != std::string::npos, "option -" + ((char) optopt) + " requires an argument");
+                crash(true, "unknown option: -" + ((char) optopt));
+        }
+    }
+
+    if (argc == 1) {
+        print_usage();
+        crash(true, "no arguments given");
+    }
+    crash(options.reference.empty(), "missing mandatory option -r");
+    crash(options.gtf_path.empty(), "missing mandatory option -g");
+    crash(options.output.empty(), "missing mandatory option -o");
+    crash(options.fusions > options.contigs, "the number of fusions (-f) exceeds the number of contigs (-n)");
+    crash(options.min_segment_length > options.max_segment_length, "the minimum segment length (-m) exceeds the maximum (-M)");
+    return options;
+}
+
+// Generator of simulated data sets with known fusions for benchmarks and regression tests
+int main(int argc, char** argv) {
+    sim_options_t options = parse_options(argc, argv);
+    Simulator simulator(options);
+    simulator.run();
+    return 0;
+}
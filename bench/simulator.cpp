@@ -0,0 +1,353 @@
+#include "simulator.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "alignment.h"
+#include "common.h"
+#include "fasta.h"
+#include "utils.h"
+
+// Segments of the same chromosome closer than this are not used as fusion partners
+const int MIN_FUSION_DISTANCE = 1000000;
+// BLAT does not report shorter alignments of a fragment
+const int MIN_PSL_ALIGNMENT = 20;
+
+static void log_message(const std::string& message) {
+    std::cout << get_time_string() << " " << message << std::endl;
+}
+
+// Value of an attribute in the last column of a GTF line, e.g. gene_name "FLI1";
+static std::string gtf_attribute(const std::string& attributes, const std::string& key) {
+    size_t pos = attributes.find(key + " \"");
+    if (pos == std::string::npos)
+        return "";
+    pos += key.size() + 2;
+    return attributes.substr(pos, attributes.find('"', pos) - pos);
+}
+
+Simulator::Simulator(const sim_options_t& options): options_(options), random_(options.seed) {}
+
+void Simulator::load_genes() {
+    std::ifstream gtf(options_.gtf_path);
+    crash(!gtf, "cannot open GTF file: " + options_.gtf_path);
+
+    std::string line;
+    while (std::getline(gtf, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::vector<std::string> fields;
+        std::istringstream columns(line);
+        std::string field;
+        while (std::getline(columns, field, '\t'))
+            fields.push_back(field);
+        if (fields.size() < 9 || fields[2] != "gene")
+            continue;
+
+        // Genes of chromosomes which are missing in the reference and mitochondrial genes are not used
+        const std::string& chromosome = fields[0];
+        if (reference_.count(chromosome) == 0 || chromosome == "MT" || chromosome == "chrM")
+            continue;
+
+        sim_gene_t gene;
+        gene.id = gtf_attribute(fields[8], "gene_id");
+        gene.name = gtf_attribute(fields[8], "gene_name");
+        if (gene.name.empty())
+            gene.name = gene.id;
+        gene.chromosome = chromosome;
+        gene.start = std::stoi(fields[3]) - 1;
+        gene.end = std::stoi(fields[4]);
+        gene.strand = fields[6][0];
+        genes_.push_back(gene);
+    }
+    crash(genes_.empty(), "no genes of the reference found in GTF file: " + options_.gtf_path);
+}
+
+// Segment of the given length which starts or ends at a random breakpoint within the gene, in the direction of transcription.
+// The 5' partner of a fusion ends at the breakpoint, the 3' partner starts there
+bool Simulator::random_segment(int gene, bool ends_at_breakpoint, int length, sim_segment_t& segment) {
+    const sim_gene_t& g = genes_[gene];
+    int breakpoint = std::uniform_int_distribution<int>(g.start, g.end - 1)(random_);
+    bool upstream = (g.strand == '-') != ends_at_breakpoint;
+
+    segment.chromosome = g.chromosome;
+    segment.tstart = upstream ? breakpoint - length : breakpoint;
+    segment.tend = segment.tstart + length;
+    segment.strand = g.strand == '-' ? '-' : '+';
+    segment.gene = gene;
+
+    const std::string& sequence = reference_[g.chromosome];
+    if (segment.tstart < 0 || segment.tend > (int) sequence.size())
+        return false;
+
+    // Assembled contigs do not span gaps of the reference
+    int unknown = std::count(sequence.begin() + segment.tstart, sequence.begin() + segment.tend, 'N');
+    return unknown <= length / 100;
+}
+
+std::string Simulator::segment_sequence(const sim_segment_t& segment) const {
+    std::string sequence = reference_.at(segment.chromosome).substr(segment.tstart, segment.tend - segment.tstart);
+    return segment.strand == '-' ? ReverseComplement(sequence) : sequence;
+}
+
+bool Simulator::make_fusion_contig(sim_contig_t& contig) {
+    std::uniform_int_distribution<int> random_gene(0, genes_.size() - 1);
+    std::uniform_int_distribution<int> random_length(options_.min_segment_length, options_.max_segment_length);
+
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        sim_segment_t five_prime, three_prime;
+        int gene1 = random_gene(random_);
+        int gene2 = random_gene(random_);
+        if (!random_segment(gene1, true, random_length(random_), five_prime) || !random_segment(gene2, false, random_length(random_), three_prime))
+            continue;
+        if (five_prime.chromosome == three_prime.chromosome &&
+            std::max(five_prime.tstart, three_prime.tstart) - std::min(five_prime.tend, three_prime.tend) < MIN_FUSION_DISTANCE)
+            continue;
+
+        five_prime.qstart = 0;
+        five_prime.qend = five_prime.tend - five_prime.tstart;
+        three_prime.qstart = five_prime.qend;
+        three_prime.qend = three_prime.qstart + three_prime.tend - three_prime.tstart;
+        contig.sequence = segment_sequence(five_prime) + segment_sequence(three_prime);
+        contig.segments = {five_prime, three_prime};
+        contig.fusion = true;
+        return true;
+    }
+    return false;
+}
+
+void Simulator::make_normal_contig(sim_contig_t& contig) {
+    std::uniform_int_distribution<int> random_gene(0, genes_.size() - 1);
+    std::uniform_int_distribution<int> random_length(options_.min_segment_length, 2 * options_.max_segment_length);
+
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        sim_segment_t segment;
+        if (!random_segment(random_gene(random_), random_() % 2 == 0, random_length(random_), segment))
+            continue;
+        segment.qstart = 0;
+        segment.qend = segment.tend - segment.tstart;
+        contig.sequence = segment_sequence(segment);
+        contig.segments = {segment};
+        contig.fusion = false;
+        return;
+    }
+    crash(true, "failed to place a contig in the genes, the reference is too short for the segment lengths");
+}
+
+// Reverse complement a contig, the assembler reports either strand
+void Simulator::flip(sim_contig_t& contig) const {
+    int length = contig.sequence.size();
+    contig.sequence = ReverseComplement(contig.sequence);
+    std::reverse(contig.segments.begin(), contig.segments.end());
+    for (auto& segment : contig.segments) {
+        segment.strand = segment.strand == '-' ? '+' : '-';
+        int qstart = length - segment.qend;
+        segment.qend = length - segment.qstart;
+        segment.qstart = qstart;
+    }
+}
+
+
+std::string Simulator::output_file(const std::string& suffix) const {
+    return options_.output + "/" + options_.prefix + suffix;
+}
+
+// The whole contigs for minimap2 and the contigs cut into fragments for BLAT
+void Simulator::write_assembly() const {
+    std::ofstream fasta(output_file(".fa"));
+    std::ofstream cut_fasta(output_file(".cut.fa"));
+    for (const auto& contig : contigs_) {
+        fasta << '>' << contig.name << '\n' << contig.sequence << '\n';
+        for (size_t start = 0, i = 1; start < contig.sequence.size(); start += options_.fragment_length, ++i)
+            cut_fasta << '>' << contig.name << '_' << i << '\n' << contig.sequence.substr(start, options_.fragment_length) << '\n';
+    }
+}
+
+void Simulator::write_psl() const {
+    std::ofstream psl(output_file(".psl"));
+    for (const auto& contig : contigs_) {
+        int length = contig.sequence.size();
+        for (int start = 0, i = 1; start < length; start += options_.fragment_length, ++i) {
+            int end = std::min(length, start + (int) options_.fragment_length);
+            for (const auto& segment : contig.segments) {
+                int qstart = std::max(start, segment.qstart);
+                int qend = std::min(end, segment.qend);
+                if (qend - qstart < MIN_PSL_ALIGNMENT)
+                    continue;
+
+                int aligned = qend - qstart;
+                int tstart = segment.strand == '+' ? segment.tstart + qstart - segment.qstart : segment.tend - (qend - segment.qstart);
+                int block_qstart = segment.strand == '+' ? qstart - start : end - qend;
+                psl << aligned << "\t0\t0\t0\t0\t0\t0\t0\t" << segment.strand << '\t' << contig.name << '_' << i << '\t' << end - start << '\t'
+                    << qstart - start << '\t' << qend - start << '\t' << segment.chromosome << '\t' << reference_.at(segment.chromosome).size() << '\t'
+                    << tstart << '\t' << tstart + aligned << "\t1\t" << aligned << ",\t" << block_qstart << ",\t" << tstart << ",\n";
+            }
+        }
+    }
+}
+
+void Simulator::write_paf() const {
+    std::ofstream paf(output_file(".paf"));
+    for (const auto& contig : contigs_) {
+        for (const auto& segment : contig.segments) {
+            int aligned = segment.qend - segment.qstart;
+            paf << contig.name << '\t' << contig.sequence.size() << '\t' << segment.qstart << '\t' << segment.qend << '\t' << segment.strand << '\t'
+                << segment.chromosome << '\t' << reference_.at(segment.chromosome).size() << '\t' << segment.tstart << '\t' << segment.tend << '\t'
+                << aligned << '\t' << aligned << "\t60\ttp:A:P\tNM:i:0\n";
+        }
+    }
+}
+
+// The first segment of a contig is the primary alignment, the others are supplementary with hard clips as reported by minimap2
+void Simulator::write_sam() const {
+    std::ofstream sam(output_file(".sam"));
+    sam << "@HD\tVN:1.6\tSO:unsorted\n";
+    for (const auto& chromosome : chromosomes_)
+        sam << "@SQ\tSN:" << chromosome << "\tLN:" << reference_.at(chromosome).size() << '\n';
+    sam << "@PG\tID:denovofusion_simulate\tPN:denovofusion_simulate\tVN:" << DENOVOFUSION_VERSION << '\n';
+
+    for (const auto& contig : contigs_) {
+        int length = contig.sequence.size();
+        for (size_t i = 0; i < contig.segments.size(); ++i) {
+            const sim_segment_t& segment = contig.segments[i];
+            bool reverse = segment.strand == '-';
+            int flag = (reverse ? 16 : 0) | (i > 0 ? 2048 : 0);
+            char clip = i > 0 ? 'H' : 'S';
+            int left_clip = reverse ? length - segment.qend : segment.qstart;
+            int right_clip = reverse ? segment.qstart : length - segment.qend;
+
+            std::string cigar;
+            if (left_clip > 0)
+                cigar += std::to_string(left_clip) + clip;
+            cigar += std::to_string(segment.qend - segment.qstart) + 'M';
+            if (right_clip > 0)
+                cigar += std::to_string(right_clip) + clip;
+
+            std::string sequence = i > 0 ? segment_sequence(segment) : (reverse ? ReverseComplement(contig.sequence) : contig.sequence);
+            sam << contig.name << '\t' << flag << '\t' << segment.chromosome << '\t' << segment.tstart + 1 << "\t60\t" << cigar << "\t*\t0\t0\t"
+                << sequence << "\t*\tNM:i:0\ttp:A:P\n";
+        }
+    }
+}
+
+// Planted fusions in the order of the contig, with the same coordinates as the fusion list
+void Simulator::write_truth() const {
+    std::ofstream truth(output_file(".truth.tsv"));
+    truth << "Contig\tGene1\tGene2\tGene_ID1\tGene_ID2\tChromosome1\tChromosome2\tStrand1\tStrand2\tTStart1\tTEnd1\tTStart2\tTEnd2\tContig_Breakpoint\n";
+    for (const auto& contig : contigs_) {
+        if (!contig.fusion)
+            continue;
+        const sim_segment_t& first = contig.segments[0];
+        const sim_segment_t& second = contig.segments[1];
+        truth << contig.name << '\t' << genes_[first.gene].name << '\t' << genes_[second.gene].name << '\t'
+              << genes_[first.gene].id << '\t' << genes_[second.gene].id << '\t'
+              << first.chromosome << '\t' << second.chromosome << '\t' << first.strand << '\t' << second.strand << '\t'
+              << first.tstart << '\t' << first.tend << '\t' << second.tstart << '\t' << second.tend << '\t' << first.qend << '\n';
+    }
+}
+
+// Paired reads sampled uniformly from the contigs at the given depth, in the layout of Simulated_data (<depth>x/<prefix>_R1.fq)
+void Simulator::write_reads(unsigned int depth) const {
+    std::string directory = options_.output + "/" + std::to_string(depth) + "x";
+    std::filesystem::create_directories(directory);
+    std::ofstream fastq1(directory + "/" + options_.prefix + "_R1.fq");
+    std::ofstream fastq2(directory + "/" + options_.prefix + "_R2.fq");
+    crash(!fastq1 || !fastq2, "cannot write FASTQ files to " + directory);
+
+    // Each depth has its own random numbers, so that the reads of a depth do not depend on the other depths
+    std::mt19937_64 random(options_.seed * 1000003ULL + depth);
+    std::normal_distribution<double> random_insert(options_.insert_size, options_.insert_size_sd);
+    std::geometric_distribution<int> random_error(options_.error_rate > 0 ? options_.error_rate : 1);
+    const int read_length = options_.read_length;
+    const std::string quality(read_length, 'I');
+    const char* bases = "ACGT";
+
+    auto add_errors = [&](std::string& read) {
+        if (options_.error_rate <= 0)
+            return;
+        for (int pos = random_error(random); pos < read_length; pos += 1 + random_error(random))
+            read[pos] = bases[(std::find(bases, bases + 4, read[pos]) - bases + 1 + random() % 3) % 4];
+    };
+
+    unsigned long long pair_id = 0;
+    std::string buffer1, buffer2;
+    for (const auto& contig : contigs_) {
+        int length = contig.sequence.size();
+        if (length < read_length)
+            continue;
+        unsigned long long pairs = std::llround((double) depth * length / (2.0 * read_length));
+        for (unsigned long long i = 0; i < pairs; ++i, ++pair_id) {
+            int insert = std::min(length, std::max(read_length, (int) std::lround(random_insert(random))));
+            int start = std::uniform_int_distribution<int>(0, length - insert)(random);
+            std::string fragment = contig.sequence.substr(start, insert);
+            if (random() % 2 == 1)
+                fragment = ReverseComplement(fragment);
+            std::string read1 = fragment.substr(0, read_length);
+            std::string read2 = ReverseComplement(fragment.substr(insert - read_length));
+            add_errors(read1);
+            add_errors(read2);
+
+            std::string name = "@" + contig.name + ":" + std::to_string(start) + ":" + std::to_string(pair_id);
+            buffer1 += name + "/1\n" + read1 + "\n+\n" + quality + "\n";
+            buffer2 += name + "/2\n" + read2 + "\n+\n" + quality + "\n";
+        }
+        if (buffer1.size() > (1 << 22)) {
+            fastq1 << buffer1;
+            fastq2 << buffer2;
+            buffer1.clear();
+            buffer2.clear();
+        }
+    }
+    fastq1 << buffer1;
+    fastq2 << buffer2;
+}
+
+
+void Simulator::run() {
+    log_message("Load reference: " + options_.reference);
+    FastaFileCls fasta(options_.reference, "cannot open reference FASTA file");
+    SequenceCls sequence("", "");
+    while (fasta.next(sequence)) {
+        chromosomes_.push_back(sequence.id);
+        reference_[sequence.id] = std::move(sequence.sequence);
+    }
+    crash(chromosomes_.empty(), "no sequences found in reference: " + options_.reference);
+
+    log_message("Load genes: " + options_.gtf_path);
+    load_genes();
+
+    // The fusion contigs are spread randomly among the normal contigs
+    log_message("Simulate " + std::to_string(options_.contigs) + " contigs with " + std::to_string(options_.fusions) + " fusions");
+    std::vector<bool> fusion(options_.contigs, false);
+    std::fill(fusion.begin(), fusion.begin() + std::min(options_.fusions, options_.contigs), true);
+    std::shuffle(fusion.begin(), fusion.end(), random_);
+    contigs_.resize(options_.contigs);
+    for (unsigned int i = 0; i < options_.contigs; ++i) {
+        sim_contig_t& contig = contigs_[i];
+        contig.name = options_.prefix + "_" + std::to_string(i + 1);
+        if (fusion[i]) {
+            crash(!make_fusion_contig(contig), "failed to place a fusion, the annotation has too few genes on distinct loci");
+        } else {
+            make_normal_contig(contig);
+        }
+        if (random_() % 2 == 1)
+            flip(contig);
+    }
+
+    std::filesystem::create_directories(options_.output);
+    log_message("Write contigs and alignments to " + options_.output);
+    write_assembly();
+    write_psl();
+    write_paf();
+    write_sam();
+    write_truth();
+
+    for (unsigned int depth : options_.depths) {
+        log_message("Write reads at " + std::to_string(depth) + "x depth");
+        write_reads(depth);
+    }
+    log_message("Done");
+}
@@ -0,0 +1,88 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Parameters of a simulated data set
+struct sim_options_t {
+    std::string reference;
+    std::string gtf_path;
+    std::string output;
+    std::string prefix = "sim";
+    unsigned int contigs = 100;             // number of contigs, including the fusion contigs
+    unsigned int fusions = 10;              // number of contigs with a planted fusion
+    std::vector<unsigned int> depths = {10, 20, 40, 60, 80};
+    unsigned int read_length = 100;
+    unsigned int insert_size = 300;
+    unsigned int insert_size_sd = 30;
+    float error_rate = 0.001;               // substitution rate of the reads
+    unsigned int min_segment_length = 2000; // length of the genomic segments which make up a contig
+    unsigned int max_segment_length = 15000;
+    unsigned int fragment_length = 1000;    // contigs are cut into fragments of this length for BLAT
+    unsigned int seed = 1;
+};
+
+// Gene of the annotation, 0-based half-open coordinates
+struct sim_gene_t {
+    std::string id;
+    std::string name;
+    std::string chromosome;
+    int start;
+    int end;
+    char strand;
+};
+
+// Part of a contig which is copied from the reference, the query coordinates are on the contig
+struct sim_segment_t {
+    std::string chromosome;
+    int tstart;
+    int tend;
+    char strand;
+    int qstart;
+    int qend;
+    int gene;       // index into the genes, -1 for none
+};
+
+struct sim_contig_t {
+    std::string name;
+    std::string sequence;
+    std::vector<sim_segment_t> segments;
+    bool fusion;
+};
+
+class Simulator {
+public:
+    explicit Simulator(const sim_options_t& options);
+
+    // Write the contigs, their alignments in PSL, PAF and SAM format, the truth and the reads of every depth
+    void run();
+
+private:
+    void load_genes();
+    bool random_segment(int gene, bool ends_at_breakpoint, int length, sim_segment_t& segment);
+    std::string segment_sequence(const sim_segment_t& segment) const;
+    bool make_fusion_contig(sim_contig_t& contig);
+    void make_normal_contig(sim_contig_t& contig);
+    void flip(sim_contig_t& contig) const;
+
+    void write_assembly() const;
+    void write_psl() const;
+    void write_paf() const;
+    void write_sam() const;
+    void write_truth() const;
+    void write_reads(unsigned int depth) const;
+
+    std::string output_file(const std::string& suffix) const;
+
+    sim_options_t options_;
+    std::mt19937_64 random_;
+    std::unordered_map<std::string, std::string> reference_;
+    std::vector<std::string> chromosomes_;      // in the order of the reference
+    std::vector<sim_gene_t> genes_;
+    std::vector<sim_contig_t> contigs_;
+};
+
+#endif //SIMULATOR_H
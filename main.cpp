@@ -2,13 +2,17 @@
 // AUTHOR "Xinwei Zhao <zhaoxi@uni-muenster.de>"
 
 
+#include "src/batch.h"
+#include "src/log.h"
 #include "src/options.h"
-#include "src/run_blat.h"
-#include "src/run_minimap2sam.h"
-#include "src/run_minimap2paf.h"
+#include "src/pipeline.h"
+#include "src/recover_known_fusion.h"
+#include "src/sweep.h"
 
 #include <iostream>
+#include <memory>
 #include <string>
+#include <unistd.h>
 
 
 
@@ -18,20 +22,48 @@
 // present the rough structure for the programm
 int main(int argc, char** argv) {
 
+    // Subcommand to compile the known fusions TSV into a packed database which is memory-mapped at startup
+    if (argc > 1 && std::string(argv[1]) == "compile-known-fusions") {
+        crash(argc != 4, "usage: DenovoFusion compile-known-fusions <known_fusions.tsv> <known_fusions.db>");
+        crash(access(argv[2], R_OK), "file not found/readable: " + std::string(argv[2]));
+        compile_known_fusions(argv[2], argv[3]);
+        return 0;
+    }
+
+    // Subcommand to evaluate a grid of filter settings on the candidates of a Stage4 checkpoint
+    if (argc > 1 && std::string(argv[1]) == "sweep") {
+        try {
+            return sweep_main(argc - 1, argv + 1);
+        } catch (const std::exception& e) {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
     // Parse command line options to determine the alignment method to use, which is the basic step for the programm
     options_t options = option_parser(argc, argv);
 
-    // Call the corresponding analysis function according to the user input method, the input type determines the calculation
-    // in which form, we support PSL, PAF and SAM input form
-    std::string alignment_method = options.input_type;
-    if (alignment_method == "blat") {
-        run_blat(options);
-    } else if (alignment_method == "minimap2sam") {
-        run_minimap2sam(options);
-    } else if (alignment_method == "minimap2paf") {
-        run_minimap2paf(options);
-    } else {
-        std::cerr << "Invalid alignment method: " << alignment_method << "please check you input with -m, we support blat, minimap2sam and minimap2paf as input" << std::endl;
+    // Batch mode: all samples of the sample sheet are processed in this process with the shared reference data
+    if (!options.sample_sheet.empty()) {
+        return run_batch(options) ? 0 : 1;
+    }
+
+    // Build the input adapter according to the user input method, the input type only determines how the alignments
+    // are loaded, we support PSL, PAF and SAM input form
+    std::unique_ptr<InputAdapter> adapter = make_input_adapter(options.input_type);
+    if (!adapter) {
+        std::cerr << "Invalid alignment method: " << options.input_type << "please check you input with -m, we support blat, minimap2sam and minimap2paf as input" << std::endl;
+        return 1;
+    }
+
+    Logger::configure(options);
+    Pipeline pipeline(options, *adapter);
+    try {
+        if (!pipeline.run()) {
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
         return 1;
     }
     return 0;
@@ -15,6 +15,176 @@ std::vector<int> splitIndices(const std::string& indices) {
     return idx;
 }
 
+bool parse_sam_span(const sam_t& sam, sam_span_t& span) {
+    // Step 1: Parse optional fields for mismatch (NM:i:)
+    for (const auto &field : sam.optional) {
+        if (field.find("NM:i:") == 0) {
+            span.mismatch = std::stoi(field.substr(5));  // Adjust below after parsing CIGAR
+        }
+    }
+
+    // Reset variables
+    int current_qpos = 0;
+    int current_tpos = sam.pos - 1;
+    int num = 0;
+    bool qstart_set = false;
+    bool is_reverse = (sam.flag & 16); // Negative strand (FLAG 16)
+    bool is_softclip_or_hardclip_in_front = false; // Flag to check if softclip or hardclip is before the match
+
+    // Check if S or H comes before M in the CIGAR string
+    if (!is_reverse) {
+        // Forward strand: Check if S or H comes before M
+        if (sam.cigar.find('S') < sam.cigar.find('M') || sam.cigar.find('H') < sam.cigar.find('M')) {
+            is_softclip_or_hardclip_in_front = true;
+        }
+    } else {
+        // Reverse strand: Check if S or H comes before M (we reverse the CIGAR string once)
+        std::string reversed_cigar = sam.cigar;
+        std::reverse(reversed_cigar.begin(), reversed_cigar.end());  // Reverse the string once
+
+        // Check if S or H comes before M in the reversed CIGAR string
+        if (reversed_cigar.find('S') < reversed_cigar.find('M') || reversed_cigar.find('H') < reversed_cigar.find('M')) {
+            is_softclip_or_hardclip_in_front = true;
+        }
+    }
+
+    // Parse the CIGAR string
+    std::string parsed_cigar = sam.cigar;
+
+    // If the strand is reverse, reverse each number and character in the CIGAR
+    if (is_reverse) {
+        std::string reversed_cigar;
+        std::string current_number = "";  // To store the numeric part
+        std::vector<std::pair<std::string, char>> segments; // To store number-operation pairs
+
+        // Traverse the CIGAR string from left to right and extract segments
+        for (int i = 0; i < parsed_cigar.size(); ++i) {
+            char ch = parsed_cigar[i];
+
+            if (isdigit(ch)) {
+                current_number += ch;  // Accumulate the number part
+            } else if (isalpha(ch)) {
+                // Once we encounter a character (M, S, etc.), we have a full segment
+                if (!current_number.empty()) {
+                    segments.push_back({current_number, ch});  // Store the number and operation pair
+                    current_number.clear();  // Reset the number for the next segment
+                }
+            }
+        }
+
+        // Check if there's an unpaired number at the end of the string
+        if (!current_number.empty()) {
+            std::cerr << "Error: Unpaired number in CIGAR string!\n";
+            return false;
+        }
+
+        // Reconstruct the reversed CIGAR string
+        for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
+            reversed_cigar += it->first + it->second; // Append number and operation
+        }
+
+        parsed_cigar = reversed_cigar; // Update the reversed CIGAR string
+    }
+
+    // Parse CIGAR string
+    for (char ch : parsed_cigar) {
+        if (isdigit(ch)) {
+            num = num * 10 + (ch - '0');
+        } else {
+            if (ch == 'M' || ch == '=' || ch == 'X') {
+                if (!qstart_set) {
+                    span.qstart = current_qpos; // Set qstart if not set already
+                    qstart_set = true;
+                }
+                current_qpos += num;  // Add match length to query position
+                current_tpos += num;  // Add match length to target position
+                span.matches += num;  // Assume all M are matches until adjusted by NM:i:
+                span.num_bases_aligned += num;
+            } else if (ch == 'I') {
+                if (!qstart_set) {
+                    span.qstart = current_qpos; // Set qstart if not set already
+                    qstart_set = true;
+                }
+                current_qpos += num;  // Add insert length only to query position
+                span.qnuminsert += num;
+            } else if (ch == 'D') {
+                current_tpos += num; // Add delete length to target position
+                span.tnuminsert += num;
+            } else if (ch == 'S' || ch == 'H') {
+                // Softclip or hardclip: move qpos if before M
+                if (is_softclip_or_hardclip_in_front) {
+                    current_qpos += num;
+                }
+            }
+            num = 0; // Reset num after processing each operation
+        }
+    }
+
+    // Calculate qend
+    span.qend = current_qpos;
+    span.tend = current_tpos;
+
+    // Adjust matches and mismatch based on NM:i: (if no 'X' operator is present)
+    if (sam.cigar.find('X') == std::string::npos) {
+        span.mismatch = span.mismatch - span.qnuminsert - span.tnuminsert;  // Remove insertions and deletions from NM count
+        span.matches -= span.mismatch;  // Subtract mismatches from matches
+    }
+    return true;
+}
+
+alignment_key_t alignment_key(const psl_t& psl) {
+    alignment_key_t key;
+    key.query = psl.qName;
+    key.query_len = psl.qSize;
+    key.qstart = psl.qStart;
+    key.qend = psl.qEnd;
+    key.matches = psl.matches;
+    key.mismatch = psl.misMatches;
+    key.identity = alignment_t::calcIdentity(psl.qStart, psl.qEnd, psl.tStart, psl.tEnd, psl.qNumInsert, psl.misMatches,
+                                             psl.matches + psl.misMatches + psl.repMatches);
+    key.score = alignment_t::calcScore(psl.matches, psl.qNumInsert, psl.tNumInsert, psl.qSize);
+    return key;
+}
+
+alignment_key_t alignment_key(const paf_t& paf) {
+    // The tags which the PAF constructor of alignment_t reads
+    auto tag = [&paf](const char* name) {
+        auto field = paf.optional_fields.find(name);
+        return field == paf.optional_fields.end() ? 0 : std::stoi(field->second.substr(2));
+    };
+    int qnuminsert = tag("XI");
+    int tnuminsert = tag("XT");
+
+    alignment_key_t key;
+    key.query = paf.query_name;
+    key.query_len = paf.query_length;
+    key.qstart = paf.query_start;
+    key.qend = paf.query_end;
+    key.matches = paf.match_length;
+    key.mismatch = tag("NM");
+    key.identity = alignment_t::calcIdentity(paf.query_start, paf.query_end, paf.target_start, paf.target_end, qnuminsert,
+                                             key.mismatch, paf.match_length);
+    key.score = alignment_t::calcScore(paf.match_length, qnuminsert, tnuminsert, paf.query_length);
+    return key;
+}
+
+alignment_key_t alignment_key(const sam_t& sam, int query_length) {
+    sam_span_t span;
+    alignment_key_t key;
+    key.query = sam.qname;
+    key.query_len = query_length;
+    if (parse_sam_span(sam, span)) {
+        key.identity = alignment_t::calcIdentity(span.qstart, span.qend, sam.pos - 1, span.tend, span.qnuminsert,
+                                                 span.mismatch, span.matches);
+        key.score = alignment_t::calcScore(span.matches, span.qnuminsert, span.tnuminsert, query_length);
+    }
+    key.qstart = span.qstart;
+    key.qend = span.qend;
+    key.matches = span.matches;
+    key.mismatch = span.mismatch;
+    return key;
+}
+
 // Alignment class
 double alignment_t::setIdentity(int qstart, int qend, int tstart, int tend, int qnuminsert, int mismatch, int num_bases_aligned) {
     return calcIdentity(qstart, qend, tstart, tend, qnuminsert, mismatch, num_bases_aligned) ;
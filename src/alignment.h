@@ -16,6 +16,33 @@
 
 
 
+// Fields of an input record which Stage1 groups, settles and scores the alignments of a query by
+struct alignment_key_t {
+    std::string query;
+    int query_len = 0;
+    int qstart = 0;
+    int qend = 0;
+    int matches = 0;
+    int mismatch = 0;
+    double identity = 0.0;
+    double score = 0.0;
+};
+
+// Spans of a SAM record on the query and the target, as the alignment_t of the record takes them
+struct sam_span_t {
+    int qstart = 0;
+    int qend = 0;
+    int tend = 0;
+    int num_bases_aligned = 0;
+    int mismatch = 0;
+    int qnuminsert = 0;
+    int tnuminsert = 0;
+    int matches = 0;
+};
+
+// False if the CIGAR string can not be parsed, the span then holds the mismatches only
+bool parse_sam_span(const sam_t& sam, sam_span_t& span);
+
 // class alignment
 class alignment_t {
 public:
@@ -49,6 +76,8 @@ public:
     std::vector<std::string> splice_sites;
     char orient;
     int contig;
+    // Position in the input of an alignment which the external sort reduced to its scoring fields, -1 otherwise
+    long long input_record = -1;
 
 
     // Added constructors to allow direct initialization of query, qstart, and qend
@@ -139,11 +168,11 @@ public:
 
 
 // New constructor from SAM
-alignment_t(const std::string &method, const sam_t &sam, const std::unordered_map<std::string, std::string>& fasta_sequences)
+alignment_t(const std::string &method, const sam_t &sam, int query_length)
     : method_(method),
       query(sam.qname),
       target(sam.rname),
-      query_len(0),  // To be calculated from fasta_sequences
+      query_len(query_length),  // Contig length, looked up in the assembly index
       target_len(0),  // Target length is not given in SAM
       query_strand((sam.flag & 16) ? '-' : '+'),
       qstart(0),
@@ -160,136 +189,21 @@ alignment_t(const std::string &method, const sam_t &sam, const std::unordered_ma
       qbaseinsert(0),
       blockcount(1) {
 
-    // Step 1: Extract contig length
-    auto it = fasta_sequences.find(query);
-    if (it != fasta_sequences.end()) {
-        query_len = it->second.length();
-    } else {
-        std::cerr << "Warning: Could not find contig length for query: " << query << std::endl;
-        query_len = 0;
+    // Spans of the query and the target from the CIGAR string, mismatches from the NM tag
+    sam_span_t span;
+    bool parsed = parse_sam_span(sam, span);
+    qstart = span.qstart;
+    qend = span.qend;
+    tend = span.tend;
+    num_bases_aligned = span.num_bases_aligned;
+    mismatch = span.mismatch;
+    qnuminsert = span.qnuminsert;
+    tnuminsert = span.tnuminsert;
+    matches = span.matches;
+    if (!parsed) {
+        return;
     }
 
-    // Step 2: Parse optional fields for mismatch (NM:i:)
-    for (const auto &field : sam.optional) {
-        if (field.find("NM:i:") == 0) {
-            int nm = std::stoi(field.substr(5));
-            mismatch = nm;  // Adjust below after parsing CIGAR
-        }
-    }
-
-     // Reset variables
-int current_qpos = 0;
-int current_tpos = tstart;
-int num = 0;
-bool qstart_set = false;
-bool is_reverse = (sam.flag & 16); // Negative strand (FLAG 16)
-bool is_softclip_or_hardclip_in_front = false; // Flag to check if softclip or hardclip is before the match
-
-// Check if S or H comes before M in the CIGAR string
-if (!is_reverse) {
-    // Forward strand: Check if S or H comes before M
-    if (sam.cigar.find('S') < sam.cigar.find('M') || sam.cigar.find('H') < sam.cigar.find('M')) {
-        is_softclip_or_hardclip_in_front = true;
-    }
-} else {
-    // Reverse strand: Check if S or H comes before M (we reverse the CIGAR string once)
-    std::string reversed_cigar = sam.cigar;
-    std::reverse(reversed_cigar.begin(), reversed_cigar.end());  // Reverse the string once
-
-    // Check if S or H comes before M in the reversed CIGAR string
-    if (reversed_cigar.find('S') < reversed_cigar.find('M') || reversed_cigar.find('H') < reversed_cigar.find('M')) {
-        is_softclip_or_hardclip_in_front = true;
-    }
-}
-
-
-        // Parse the CIGAR string
-        std::string parsed_cigar = sam.cigar;
-
-        // If the strand is reverse, reverse each number and character in the CIGAR
-        if (is_reverse) {
-            std::string reversed_cigar;
-            std::string current_number = "";  // To store the numeric part
-            std::vector<std::pair<std::string, char>> segments; // To store number-operation pairs
-
-            // Traverse the CIGAR string from left to right and extract segments
-            for (int i = 0; i < parsed_cigar.size(); ++i) {
-                char ch = parsed_cigar[i];
-
-                if (isdigit(ch)) {
-                    current_number += ch;  // Accumulate the number part
-                } else if (isalpha(ch)) {
-                    // Once we encounter a character (M, S, etc.), we have a full segment
-                    if (!current_number.empty()) {
-                        segments.push_back({current_number, ch});  // Store the number and operation pair
-                        current_number.clear();  // Reset the number for the next segment
-                    }
-                }
-            }
-
-            // Check if there's an unpaired number at the end of the string
-            if (!current_number.empty()) {
-                std::cerr << "Error: Unpaired number in CIGAR string!\n";
-                return;
-            }
-
-            // Reconstruct the reversed CIGAR string
-            for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
-                reversed_cigar += it->first + it->second; // Append number and operation
-            }
-
-            parsed_cigar = reversed_cigar; // Update the reversed CIGAR string
-        }
-
-
-
-
-
-        // Parse CIGAR string
-        for (char ch : parsed_cigar) {
-            if (isdigit(ch)) {
-                num = num * 10 + (ch - '0');
-            } else {
-                if (ch == 'M' || ch == '=' || ch == 'X') {
-                    if (!qstart_set) {
-                        qstart = current_qpos; // Set qstart if not set already
-                        qstart_set = true;
-                    }
-                    current_qpos += num;  // Add match length to query position
-                    current_tpos += num;  // Add match length to target position
-                    matches += num;  // Assume all M are matches until adjusted by NM:i:
-                    num_bases_aligned += num;
-                } else if (ch == 'I') {
-                    if (!qstart_set) {
-                        qstart = current_qpos; // Set qstart if not set already
-                        qstart_set = true;
-                    }
-                    current_qpos += num;  // Add insert length only to query position
-                    qnuminsert += num;
-                } else if (ch == 'D') {
-                    current_tpos += num; // Add delete length to target position
-                    tnuminsert += num;
-                } else if (ch == 'S' || ch == 'H') {
-                    // Softclip or hardclip: move qpos if before M
-                    if (is_softclip_or_hardclip_in_front) {
-                        current_qpos += num;
-                    }
-                }
-                num = 0; // Reset num after processing each operation
-            }
-        }
-
-        // Calculate qend
-        qend = current_qpos;
-        tend = current_tpos;
-
-        // Adjust matches and mismatch based on NM:i: (if no 'X' operator is present)
-        if (sam.cigar.find('X') == std::string::npos) {
-            mismatch = mismatch - qnuminsert - tnuminsert;  // Remove insertions and deletions from NM count
-            matches -= mismatch;  // Subtract mismatches from matches
-        }
-
-
     // Step 5: Calculate identity and score
     identity = setIdentity(qstart, qend, tstart, tend, qnuminsert, mismatch, matches);
     score = setScore(matches, mismatch, qnuminsert, tnuminsert, query_len);
@@ -314,11 +228,11 @@ if (!is_reverse) {
 
     double setIdentity(int qstart, int qend, int tstart, int tend, int qnuminsert, int mismatch, int num_bases_aligned);
 
-    double calcIdentity(int qstart, int qend, int tstart, int tend, int qnuminsert, int mismatch, int num_bases_aligned);
+    static double calcIdentity(int qstart, int qend, int tstart, int tend, int qnuminsert, int mismatch, int num_bases_aligned);
 
     int setScore(int match, int mismatch, int qnuminsert, int tnuminsert, int query_len);
 
-    int calcScore(int match, int qnuminsert, int tnuminsert, int query_len);
+    static int calcScore(int match, int qnuminsert, int tnuminsert, int query_len);
 
 
     int numExonsOverlapped() const;
@@ -377,8 +291,20 @@ std::string ReverseComplement(const std::string &sequence);
 // Calculate the end positions of alignment blocks within a PslEntry based on the start positions and sizes.
 void calculate_ends(psl_t& entry);
 
+// Fields of a record which Stage1 groups and settles the alignments of a query by, the same as the alignment_t of
+// the record holds
+alignment_key_t alignment_key(const psl_t& psl);
+alignment_key_t alignment_key(const paf_t& paf);
+alignment_key_t alignment_key(const sam_t& sam, int query_length);
+
 // Index PSL entries by their query name for quicker access and manipulation within data processing routines.
 std::unordered_map<std::string, std::vector<alignment_t>> index_by_qname(const std::vector<alignment_t>& entries);
 
+// Query coordinates of the input alignments of one query, kept for the homolog filter instead of the alignments
+struct query_coordinates_t {
+    std::string query;
+    std::vector<std::pair<int, int>> coordinates;   // qstart and qend of each alignment
+};
+
 
 #endif // ALIGNMENT_H
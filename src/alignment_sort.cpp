@@ -0,0 +1,295 @@
+#include "alignment_sort.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <variant>
+#include <vector>
+
+#include "checkpoint.h"
+#include "common.h"
+#include "thread_pool.h"
+
+// Approximate memory of an input record, including the contents of its strings and vectors
+struct record_bytes_t {
+    size_t operator()(const std::monostate&) const {
+        return 0;
+    }
+    size_t operator()(const psl_t& psl) const {
+        return psl.strand.size() + psl.qName.size() + psl.tName.size() +
+               (psl.blockSizes.size() + psl.qStarts.size() + psl.tStarts.size() + psl.qEnds.size() + psl.tEnds.size()) * sizeof(int);
+    }
+    size_t operator()(const paf_t& paf) const {
+        size_t bytes = paf.query_name.size() + paf.target_name.size() + paf.cigar.size();
+        for (const auto& field : paf.optional_fields) {
+            bytes += 2 * sizeof(std::string) + field.first.size() + field.second.size();
+        }
+        return bytes;
+    }
+    size_t operator()(const sam_t& sam) const {
+        size_t bytes = sam.qname.size() + sam.rname.size() + sam.cigar.size() + sam.rnext.size() + sam.seq.size() +
+                       sam.qual.size() + sam.tp_label.size();
+        for (const auto& field : sam.optional) {
+            bytes += sizeof(std::string) + field.size();
+        }
+        return bytes;
+    }
+};
+
+static size_t record_bytes(const input_record_t& record) {
+    return sizeof(input_record_t) + record.key.query.size() + std::visit(record_bytes_t(), record.record);
+}
+
+static void sort_run(std::vector<input_record_t>& run) {
+    std::stable_sort(run.begin(), run.end(), [](const input_record_t& a, const input_record_t& b) { return a.key.query < b.key.query; });
+}
+
+
+// The key of an input record with the position of the record in the input. The runs which do not fit in memory hold
+// these records only, the chosen alignments are read again by restore_alignments.
+struct sort_record_t {
+    alignment_key_t key;
+    uint64_t input_record;
+};
+
+static sort_record_t make_record(input_record_t& record, uint64_t input_record) {
+    return {std::move(record.key), input_record};
+}
+
+static input_record_t make_input_record(sort_record_t& record) {
+    input_record_t input;
+    input.key = std::move(record.key);
+    input.position = static_cast<long long>(record.input_record);
+    return input;
+}
+
+static size_t record_bytes(const sort_record_t& record) {
+    return sizeof(sort_record_t) + record.key.query.size();
+}
+
+static void sort_run(std::vector<sort_record_t>& run) {
+    std::stable_sort(run.begin(), run.end(), [](const sort_record_t& a, const sort_record_t& b) { return a.key.query < b.key.query; });
+}
+
+// The runs are written with the serialization of the checkpoints, the number of records first. Returns false if the
+// run could not be written completely.
+static bool write_run(const std::string& filename, const std::vector<sort_record_t>& run) {
+    CheckpointWriter writer(filename, "SortRun", 0);
+    writer.write(static_cast<uint64_t>(run.size()));
+    for (const auto& record : run) {
+        writer.write(record.key.query);
+        writer.write(record.key.query_len);
+        writer.write(record.key.qstart);
+        writer.write(record.key.qend);
+        writer.write(record.key.matches);
+        writer.write(record.key.mismatch);
+        writer.write(record.key.identity);
+        writer.write(record.key.score);
+        writer.write(record.input_record);
+    }
+    return writer.commit();
+}
+
+static bool read_record(CheckpointReader& reader, sort_record_t& record) {
+    return reader.read(record.key.query) && reader.read(record.key.query_len) && reader.read(record.key.qstart) &&
+           reader.read(record.key.qend) && reader.read(record.key.matches) && reader.read(record.key.mismatch) &&
+           reader.read(record.key.identity) && reader.read(record.key.score) && reader.read(record.input_record);
+}
+
+
+// Records of a single run sorted in memory
+class SortedAlignmentReader: public AlignmentReader {
+public:
+    explicit SortedAlignmentReader(std::vector<input_record_t> records): records_(std::move(records)) {}
+
+    bool next(std::vector<input_record_t>& records) override {
+        if (next_ == records_.size()) {
+            return false;
+        }
+        records.push_back(std::move(records_[next_++]));
+        return true;
+    }
+
+private:
+    std::vector<input_record_t> records_;
+    size_t next_ = 0;
+};
+
+
+// K-way merge of the sorted runs, equal queries are taken from the earlier run first
+class MergingAlignmentReader: public AlignmentReader {
+public:
+    MergingAlignmentReader(const std::vector<std::string>& files, const std::string& directory): files_(files), directory_(directory) {
+        for (size_t run = 0; run < files_.size(); ++run) {
+            readers_.emplace_back(new CheckpointReader(files_[run], "SortRun", 0));
+            remaining_.push_back(0);
+            heads_.emplace_back();
+            if (!readers_.back()->valid() || !readers_.back()->read(remaining_.back())) {
+                throw std::runtime_error("cannot read the sorted alignments '" + files_[run] + "'");
+            }
+            if (advance(run)) {
+                heap_.push_back(run);
+            }
+        }
+        std::make_heap(heap_.begin(), heap_.end(), later_);
+    }
+
+    ~MergingAlignmentReader() override {
+        readers_.clear();
+        for (const auto& file : files_) {
+            std::remove(file.c_str());
+        }
+        rmdir(directory_.c_str());
+    }
+
+    bool next(std::vector<input_record_t>& records) override {
+        if (heap_.empty()) {
+            return false;
+        }
+        std::pop_heap(heap_.begin(), heap_.end(), later_);
+        size_t run = heap_.back();
+        records.push_back(make_input_record(heads_[run]));
+        if (advance(run)) {
+            std::push_heap(heap_.begin(), heap_.end(), later_);
+        } else {
+            heap_.pop_back();
+        }
+        return true;
+    }
+
+private:
+    // Read the next record of a run into its head, false at the end of the run
+    bool advance(size_t run) {
+        if (remaining_[run] == 0) {
+            return false;
+        }
+        --remaining_[run];
+        if (!read_record(*readers_[run], heads_[run])) {
+            throw std::runtime_error("cannot read the sorted alignments '" + files_[run] + "'");
+        }
+        return true;
+    }
+
+    std::vector<std::string> files_;
+    std::string directory_;
+    std::vector<std::unique_ptr<CheckpointReader>> readers_;
+    std::vector<uint64_t> remaining_;
+    std::vector<sort_record_t> heads_;      // next record of each run
+    std::vector<size_t> heap_;              // runs with alignments left, the smallest head on top
+
+    // Heap order of the runs
+    struct later_t {
+        const std::vector<sort_record_t>& heads;
+        bool operator()(size_t a, size_t b) const {
+            int order = heads[a].key.query.compare(heads[b].key.query);
+            return order > 0 || (order == 0 && a > b);
+        }
+    };
+    later_t later_{heads_};
+};
+
+
+std::unique_ptr<AlignmentReader> sort_by_query(AlignmentReader& input, const std::string& directory, size_t memory_budget, int threads) {
+    // One run is collected while the pool sorts and writes up to `threads` others, so each gets an equal share
+    threads = std::max(1, threads);
+    const size_t run_budget = memory_budget / (threads + 1);
+
+    // The complete records are kept as long as the input fits in a single run
+    std::vector<input_record_t> records;
+    size_t records_bytes = 0;
+    bool more = true;
+    while (more && records_bytes < run_budget) {
+        size_t first = records.size();
+        more = input.next(records);
+        for (size_t i = first; i < records.size(); ++i) {
+            records_bytes += record_bytes(records[i]);
+        }
+    }
+    if (!more) {
+        sort_run(records);
+        return std::unique_ptr<AlignmentReader>(new SortedAlignmentReader(std::move(records)));
+    }
+
+    ThreadPool pool(threads);
+    std::vector<std::string> files;
+    std::vector<sort_record_t> run;
+    size_t run_bytes = 0;
+    uint64_t input_record = 0;
+    for (auto& record : records) {
+        run.push_back(make_record(record, input_record++));
+        run_bytes += record_bytes(run.back());
+    }
+    records.clear();
+    records.shrink_to_fit();
+
+    int pending = 0;
+    std::atomic<bool> write_failed(false);
+    mkdir(directory.c_str(), 0755);
+    while (more) {
+        more = input.next(records);
+        for (auto& record : records) {
+            run.push_back(make_record(record, input_record++));
+            run_bytes += record_bytes(run.back());
+        }
+        records.clear();
+        if ((more && run_bytes < run_budget) || run.empty()) {
+            continue;
+        }
+
+        if (pending == threads) {
+            pool.wait();
+            pending = 0;
+        }
+        files.push_back(directory + "/run" + std::to_string(files.size()) + ".bin");
+        auto sorted = std::make_shared<std::vector<sort_record_t>>(std::move(run));
+        pool.submit([sorted, filename = files.back(), &write_failed]() {
+            sort_run(*sorted);
+            if (!write_run(filename, *sorted)) {
+                write_failed = true;
+            }
+        });
+        ++pending;
+        run.clear();
+        run_bytes = 0;
+    }
+    pool.wait();
+    // Thrown here rather than in the workers, so that the run fails instead of the process
+    if (write_failed) {
+        throw std::runtime_error("cannot write the sorted alignments to '" + directory + "'");
+    }
+
+    return std::unique_ptr<AlignmentReader>(new MergingAlignmentReader(files, directory));
+}
+
+
+void restore_alignments(AlignmentReader& input, std::vector<alignment_t>& alignments) {
+    // The compact alignments by their position in the input, an input record may have been chosen more than once
+    std::vector<size_t> compact;
+    for (size_t i = 0; i < alignments.size(); ++i) {
+        if (alignments[i].input_record >= 0) {
+            compact.push_back(i);
+        }
+    }
+    std::stable_sort(compact.begin(), compact.end(), [&alignments](size_t a, size_t b) {
+        return alignments[a].input_record < alignments[b].input_record;
+    });
+
+    std::vector<input_record_t> records;
+    long long input_record = 0;
+    auto next = compact.begin();
+    while (next != compact.end() && input.next(records)) {
+        for (auto& record : records) {
+            for (; next != compact.end() && alignments[*next].input_record == input_record; ++next) {
+                alignments[*next] = build_alignment(record);
+            }
+            ++input_record;
+        }
+        records.clear();
+    }
+    if (next != compact.end()) {
+        throw std::runtime_error("the alignments changed while they were sorted");
+    }
+}
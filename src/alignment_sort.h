@@ -0,0 +1,20 @@
+#ifndef ALIGNMENT_SORT_H
+#define ALIGNMENT_SORT_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "input_adapter.h"
+
+// Sort the alignments of a reader by query, the records of a query stay in the order of the input. Input which fits in
+// memory_budget bytes is sorted in memory. Otherwise every alignment is reduced to the fields of the Stage1 scoring
+// and its position in the input; the thread pool sorts runs of these records, which share memory_budget bytes, and
+// writes them to temporary files in directory, which the returned reader merges and removes.
+std::unique_ptr<AlignmentReader> sort_by_query(AlignmentReader& input, const std::string& directory, size_t memory_budget, int threads);
+
+// Replace the reduced alignments of sort_by_query by the complete records, read again from the input it sorted
+void restore_alignments(AlignmentReader& input, std::vector<alignment_t>& alignments);
+
+#endif //ALIGNMENT_SORT_H
@@ -60,6 +60,46 @@ int calculateInclusionScore(const std::vector<std::pair<int, int>>& combination)
 
 
 
+// Score of a combination of alignments of a query
+static double combination_score(double identity_sum, const std::vector<std::pair<int, int>>& combination, int qSize, const options_t& options) {
+    // Calculating overlap and inclusion scores
+    int overlap = calculateOverlapScore(combination);
+    float overlap_fraction = static_cast<float>(overlap) / qSize;
+
+    int inclusion = calculateInclusionScore(combination);
+    float inclusion_fraction = static_cast<float>(inclusion) / qSize;
+
+    // calculate final score for all single or combinations alignments
+    return identity_sum + options. inclusion_fraction_weight * inclusion_fraction - options.inclusion_fraction_weight * overlap_fraction - options.size_weight * combination.size();
+}
+
+int settled_alignment(const std::vector<const alignment_key_t*>& keys, const options_t& options) {
+    if (keys.size() == 1) {
+        return 0;
+    }
+    // The single alignments in the order of the combination search, which stops at the first one covering the query
+    int qSize = keys[0]->query_len;
+    double best_score = -std::numeric_limits<double>::infinity();
+    int best = -1;
+    for (const auto* pair : keys) {
+        // The first alignment of the coordinates, as the search finds it
+        int index = 0;
+        while (keys[index]->qstart != pair->qstart || keys[index]->qend != pair->qend) {
+            ++index;
+        }
+        const alignment_key_t& key = *keys[index];
+        double score = combination_score(key.identity, {{key.qstart, key.qend}}, qSize, options);
+        if (score > best_score) {
+            best_score = score;
+            best = index;
+        }
+        if (key.matches + key.mismatch == qSize) {
+            return best;
+        }
+    }
+    return -1;
+}
+
 std::vector<alignment_t> calculate_alignments_score(const std::unordered_map<std::string, std::vector<alignment_t>>& data_by_qname, const options_t& options) {
     std::vector<alignment_t> best_alignment;
 
@@ -103,15 +143,7 @@ std::vector<alignment_t> calculate_alignments_score(const std::unordered_map<std
                     }
                 }
 
-                // Calculating overlap and inclusion scores
-                int overlap = calculateOverlapScore(combination);
-                float overlap_fraction = static_cast<float>(overlap) / qSize;
-
-                int inclusion = calculateInclusionScore(combination);
-                float inclusion_fraction = static_cast<float>(inclusion) / qSize;
-
-                // calculate final score for all single or combinations alignments
-                double score = identity_sum + options. inclusion_fraction_weight * inclusion_fraction - options.inclusion_fraction_weight * overlap_fraction - options.size_weight * combination.size();
+                double score = combination_score(identity_sum, combination, qSize, options);
 
                 // Compare and update the best scores and their information
                 if (score > best_score) {
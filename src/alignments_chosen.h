@@ -40,6 +40,12 @@ int calculateOverlapScore(const std::vector<std::pair<int, int>>& combination);
 // Calculate inclusion score
 int calculateInclusionScore(const std::vector<std::pair<int, int>>& combination);
 
+// Index of the alignment calculate_alignments_score chooses alone for a query, without searching the combinations:
+// the query has a single alignment, or one of its alignments aligns the whole query, which ends the search among the
+// single alignments. Only the keys of the records are read, so the alignments are built for the settled one alone.
+// -1 if the combinations have to be searched.
+int settled_alignment(const std::vector<const alignment_key_t*>& keys, const options_t& options);
+
 std::vector<alignment_t> calculate_alignments_score(const std::unordered_map<std::string, std::vector<alignment_t>>& data_by_qname, const options_t& options);
 
 
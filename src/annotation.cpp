@@ -4,18 +4,17 @@
 
 #include "annotation.h"
 
+#include <algorithm>
 
-GeneAnnotator::GeneAnnotator(const std::string& gtf_path)
-        : gtf_path_(gtf_path) {}
 
-std::vector<annotation_t> GeneAnnotator::annotateAlignments(const std::vector<coordination_t>& coordinations) {
-    std::vector<annotation_t> annotations(coordinations.size());
+GeneAnnotator::GeneAnnotator(const std::string& gtf_path)
+        : gtf_path_(gtf_path), loaded_(false) {
     std::ifstream gtf_file(gtf_path_);
 
     if (!gtf_file.is_open()) {
-        std::cerr << "Failed to open GTF file: " << gtf_path_ << std::endl;
-        return annotations;
+        return;
     }
+    loaded_ = true;
 
     std::unordered_map<std::string, std::unordered_map<std::string, int>> gene_transcript_cds_length;
     std::string line;
@@ -104,17 +103,73 @@ std::vector<annotation_t> GeneAnnotator::annotateAlignments(const std::vector<co
             }
         }
 
-        for (size_t i = 0; i < coordinations.size(); ++i) {
-            const auto &coord = coordinations[i];
-            if (coord.target == chrom && coord.tstart <= end && coord.tend >= start) {
-                if (annotations[i].contigName.empty()) {
-                    std::string geneName = attr_map.count("gene_name") ? attr_map["gene_name"] : " ";
-                    std::string geneId = attr_map.count("gene_id") ? attr_map["gene_id"] : " ";
-                    std::string strand = fields[6];
-                    annotations[i] = annotation_t(coord.query, geneId, geneName,
-                                                  coord.tstart, coord.tend,
-                                                  chrom, coord.strand, "", "", -1);
-                }
+        // Every line is kept for the gene lookup, consecutive lines of the same gene share their names
+        std::pair<std::string, std::string> gene(attr_map.count("gene_id") ? attr_map["gene_id"] : " ",
+                                                 attr_map.count("gene_name") ? attr_map["gene_name"] : " ");
+        if (genes_.empty() || genes_.back() != gene) {
+            genes_.push_back(gene);
+        }
+        features_[chrom].push_back({start, end, static_cast<unsigned int>(genes_.size() - 1)});
+    }
+
+    for (auto& [chrom, exons] : chrom_exons) {
+        const auto &exon_numbers = chrom_exon_numbers[chrom];
+        std::vector<std::tuple<int, int, int>> sorted_exons;
+        for (size_t j = 0; j < exons.size(); ++j) {
+            sorted_exons.emplace_back(exons[j].first, exons[j].second, exon_numbers[j]);
+        }
+        std::sort(sorted_exons.begin(), sorted_exons.end(),
+                  [](auto &a, auto &b) { return std::get<0>(a) < std::get<0>(b); });
+
+        exon_index_t& index = exons_[chrom];
+        for (const auto &e : sorted_exons) {
+            index.starts.push_back(std::get<0>(e));
+            index.max_ends.push_back(index.max_ends.empty() ? std::get<1>(e) : std::max(index.max_ends.back(), std::get<1>(e)));
+            index.numbers.push_back(std::get<2>(e));
+        }
+    }
+}
+
+std::pair<const char*, int> GeneAnnotator::regionType(const exon_index_t& exons, int pos) {
+    if (exons.starts.empty())
+        return {"unknown", -1};
+
+    // Only the exons before `after` start at or before the position, the first of them whose running maximum of
+    // the ends reaches the position is the first exon which contains it
+    size_t after = std::upper_bound(exons.starts.begin(), exons.starts.end(), pos) - exons.starts.begin();
+    size_t first = std::lower_bound(exons.max_ends.begin(), exons.max_ends.begin() + after, pos) - exons.max_ends.begin();
+    if (first < after)
+        return {"exon", exons.numbers[first]};
+
+    // Not in an exon, so the position lies after the exon before `after` and before the exon at `after`
+    if (after == 0)
+        return {"upstream", exons.numbers.front()};
+    if (after < exons.starts.size())
+        return {"intron", exons.numbers[after - 1]};
+    return {"downstream", exons.numbers.back()};
+}
+
+std::vector<annotation_t> GeneAnnotator::annotateAlignments(const std::vector<coordination_t>& coordinations) const {
+    std::vector<annotation_t> annotations(coordinations.size());
+
+    if (!loaded_) {
+        std::cerr << "Failed to open GTF file: " << gtf_path_ << std::endl;
+        return annotations;
+    }
+
+    // The first line of the GTF file which overlaps a coordination determines its gene
+    for (size_t i = 0; i < coordinations.size(); ++i) {
+        const auto &coord = coordinations[i];
+        auto it_features = features_.find(coord.target);
+        if (it_features == features_.end()) continue;
+
+        for (const auto &feature : it_features->second) {
+            if (coord.tstart <= feature.end && coord.tend >= feature.start) {
+                const auto &gene = genes_[feature.gene];
+                annotations[i] = annotation_t(coord.query, gene.first, gene.second,
+                                              coord.tstart, coord.tend,
+                                              coord.target, coord.strand, "", "", -1);
+                break;
             }
         }
     }
@@ -146,45 +201,16 @@ std::vector<annotation_t> GeneAnnotator::annotateAlignments(const std::vector<co
         const auto &coord = coordinations[i];
         auto &anno = annotations[i];
 
-        auto it_exons = chrom_exons.find(coord.target);
-        auto it_exon_nums = chrom_exon_numbers.find(coord.target);
-        if (it_exons == chrom_exons.end() || it_exon_nums == chrom_exon_numbers.end()) {
+        auto it_exons = exons_.find(coord.target);
+        if (it_exons == exons_.end()) {
             anno.regionType = "unknown";
             continue;
         }
 
-        const auto &exons = it_exons->second;
-        const auto &exon_numbers = it_exon_nums->second;
-
         int pos = (anno.direction == "UPSTREAM") ? coord.tend : coord.tstart;
 
-        std::vector<std::tuple<int, int, int>> sorted_exons;
-        for (size_t j = 0; j < exons.size(); ++j) {
-            sorted_exons.emplace_back(exons[j].first, exons[j].second, exon_numbers[j]);
-        }
-        std::sort(sorted_exons.begin(), sorted_exons.end(),
-                  [](auto &a, auto &b) { return std::get<0>(a) < std::get<0>(b); });
-
-        auto annotate_pos = [&](int pos) -> std::pair<std::string, int> {
-            for (auto &e : sorted_exons) {
-                if (pos >= std::get<0>(e) && pos <= std::get<1>(e))
-                    return {"exon", std::get<2>(e)};
-            }
-            for (size_t j = 0; j + 1 < sorted_exons.size(); ++j) {
-                if (pos > std::get<1>(sorted_exons[j]) && pos < std::get<0>(sorted_exons[j + 1])) {
-                    return {"intron", std::get<2>(sorted_exons[j]) };
-                }
-            }
-            if (pos < std::get<0>(sorted_exons.front()))
-                return {"upstream", std::get<2>(sorted_exons.front())};
-            if (pos > std::get<1>(sorted_exons.back()))
-                return {"downstream", std::get<2>(sorted_exons.back())};
-
-            return {"unknown", -1};
-        };
-
-        auto [region, exon_number] = annotate_pos(pos);
-        anno.regionType = region + "@" + std::to_string(exon_number);
+        auto [region, exon_number] = regionType(it_exons->second, pos);
+        anno.regionType = std::string(region) + "@" + std::to_string(exon_number);
     }
 
     for (size_t i = 0; i < annotations.size(); ++i) {
@@ -10,6 +10,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <tuple>
 
 #include "alignment.h"
 #include "realign_support.h"
@@ -37,13 +38,35 @@ struct annotation_t {
 };
 
 
+// The GTF file is loaded once, so the annotator can be shared by several runs
 class GeneAnnotator {
 public:
     explicit GeneAnnotator(const std::string& gtf_path);
-    std::vector<annotation_t> annotateAlignments(const std::vector<coordination_t>& coordinations);
+    std::vector<annotation_t> annotateAlignments(const std::vector<coordination_t>& coordinations) const;
 
 private:
+    struct gtf_feature_t {
+        int start;
+        int end;
+        unsigned int gene;  // index into genes_
+    };
+
+    // Exons of the longest basic transcripts of a chromosome, sorted by start. max_ends[j] is the largest end of the
+    // exons up to j, so the first exon which reaches a position is found by binary search
+    struct exon_index_t {
+        std::vector<int> starts;
+        std::vector<int> max_ends;
+        std::vector<int> numbers;
+    };
+
+    // Region type of a position, e.g. {"exon", 3}, as if the sorted exons were scanned in order
+    static std::pair<const char*, int> regionType(const exon_index_t& exons, int pos);
+
     std::string gtf_path_;
+    bool loaded_;
+    std::vector<std::pair<std::string, std::string>> genes_;                             // gene ID and name
+    std::unordered_map<std::string, std::vector<gtf_feature_t>> features_;              // all lines by chromosome, in file order
+    std::unordered_map<std::string, exon_index_t> exons_;                               // by chromosome
     void parseAttributes(const std::string& attributes, std::unordered_map<std::string, std::string>& attr_map);
 };
 
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+#include <unistd.h>
+
+#include "batch.h"
+#include "common.h"
+#include "input_adapter.h"
+#include "log.h"
+#include "pipeline.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+std::vector<sample_t> load_sample_sheet(const std::string& filename) {
+    std::ifstream file(filename);
+    crash(!file.is_open(), "failed to open sample sheet: " + filename);
+
+    std::vector<sample_t> samples;
+    std::unordered_set<std::string> prefixes;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::vector<std::string> columns;
+        std::istringstream ss(line);
+        std::string column;
+        while (std::getline(ss, column, '\t')) {
+            columns.push_back(column);
+        }
+        crash(columns.size() != 5, "expected 5 columns (prefix, alignment file, assembly, FASTQ 1, FASTQ 2) in line " +
+                                   std::to_string(line_number) + " of the sample sheet: " + filename);
+
+        sample_t sample;
+        sample.prefix = columns[0];
+        sample.input_file = columns[1];
+        sample.input_assembly = columns[2];
+        std::replace(columns[3].begin(), columns[3].end(), ',', ' ');
+        std::replace(columns[4].begin(), columns[4].end(), ',', ' ');
+        parse_fastq_files(columns[3].c_str(), sample.input_fastq1);
+        parse_fastq_files(columns[4].c_str(), sample.input_fastq2);
+
+        crash(sample.prefix.empty(), "missing prefix in line " + std::to_string(line_number) + " of the sample sheet: " + filename);
+        crash(!prefixes.insert(sample.prefix).second, "duplicate prefix in the sample sheet: " + sample.prefix);
+        crash(sample.input_fastq1.size() != sample.input_fastq2.size(), "different number of FASTQ files for the mates of sample " + sample.prefix);
+        samples.push_back(sample);
+    }
+    crash(samples.empty(), "no samples in the sample sheet: " + filename);
+    return samples;
+}
+
+// The inputs are checked when the sample starts, so that a missing file fails the sample rather than the batch
+static void check_sample_inputs(const sample_t& sample) {
+    std::vector<const std::string*> paths = {&sample.input_file, &sample.input_assembly};
+    for (const auto& fastq : sample.input_fastq1) {
+        paths.push_back(&fastq);
+    }
+    for (const auto& fastq : sample.input_fastq2) {
+        paths.push_back(&fastq);
+    }
+    for (const std::string* path : paths) {
+        if (access(path->c_str(), R_OK)) {
+            throw std::runtime_error("file not found/readable: " + *path);
+        }
+    }
+}
+
+bool run_batch(const options_t& options) {
+    std::vector<sample_t> samples = load_sample_sheet(options.sample_sheet);
+    crash(!make_input_adapter(options.input_type), "invalid alignment method: " + options.input_type + ", we support blat, minimap2sam and minimap2paf as input");
+
+    // The samples share the log level, each writes its own log file
+    Logger::configure(options);
+    std::cout << get_time_string() << " Batch of " << samples.size() << " samples from '" << options.sample_sheet << "'" << std::endl;
+    std::cout << get_time_string() << " Loading the shared reference data" << std::endl;
+    std::unique_ptr<const reference_t> reference;
+    try {
+        reference.reset(new reference_t(options));
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return false;
+    }
+
+    // The parallel parts of all samples run on one pool of options.threads workers, so a sample uses the workers
+    // which the others leave idle. The readers and bowtie2 of a sample take an equal share of the threads.
+    int parallel_samples = std::min(options.parallel_samples, static_cast<int>(samples.size()));
+    int threads = std::max(1, options.threads / parallel_samples);
+    ThreadPool workers(std::max(1, options.threads));
+
+    std::mutex output_mutex;
+    size_t failed = 0;
+    {
+        ThreadPool pool(parallel_samples);
+        for (const auto& sample : samples) {
+            pool.submit([&, sample] {
+                options_t sample_options = options;
+                sample_options.prefix = sample.prefix;
+                sample_options.input_file = sample.input_file;
+                sample_options.input_assembly = sample.input_assembly;
+                sample_options.input_fastq1 = sample.input_fastq1;
+                sample_options.input_fastq2 = sample.input_fastq2;
+                sample_options.threads = threads;
+
+                {
+                    std::lock_guard<std::mutex> lock(output_mutex);
+                    std::cout << get_time_string() << " Sample " << sample.prefix << " started" << std::endl;
+                }
+
+                // The progress of a sample is only written to its log file, the output of the samples would interleave
+                std::ostream quiet(nullptr);
+                bool success;
+                std::string error;
+                try {
+                    check_sample_inputs(sample);
+                    std::unique_ptr<InputAdapter> adapter = make_input_adapter(sample_options.input_type);
+                    Pipeline pipeline(sample_options, *adapter, quiet);
+                    pipeline.use_reference(*reference);
+                    pipeline.use_thread_pool(workers);
+                    success = pipeline.run();
+                } catch (const std::exception& e) {
+                    success = false;
+                    error = e.what();
+                }
+                Logger::close();
+
+                std::lock_guard<std::mutex> lock(output_mutex);
+                if (success) {
+                    std::cout << get_time_string() << " Sample " << sample.prefix << " finished" << std::endl;
+                } else {
+                    ++failed;
+                    std::cerr << get_time_string() << " Sample " << sample.prefix << " failed" << (error.empty() ? "" : ": " + error)
+                              << ", see " << options.output << "/" << sample.prefix << ".log" << std::endl;
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    std::cout << get_time_string() << " Done " << samples.size() - failed << " of " << samples.size() << " samples" << std::endl;
+    return failed == 0;
+}
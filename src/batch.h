@@ -0,0 +1,27 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+
+#include "options.h"
+
+// Sample of a batch, the inputs replace the options -i, -a, -1 and -2 and the prefix replaces -p
+struct sample_t {
+    std::string prefix;
+    std::string input_file;
+    std::string input_assembly;
+    std::vector<std::string> input_fastq1;
+    std::vector<std::string> input_fastq2;
+};
+
+// Load a sample sheet, a TSV file with the columns prefix, alignment file, assembly, FASTQ 1 and FASTQ 2.
+// Several FASTQ files of a sample are separated by commas, lines starting with '#' are comments
+std::vector<sample_t> load_sample_sheet(const std::string& filename);
+
+// Run the pipeline on all samples of the sample sheet. The GTF annotation and the known fusions are loaded once
+// and shared by the samples, up to options.parallel_samples samples are processed at the same time on a shared pool
+// of options.threads workers. A failed sample does not stop the others. Returns false if any sample failed
+bool run_batch(const options_t& options);
+
+#endif //BATCH_H
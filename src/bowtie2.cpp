@@ -4,33 +4,30 @@
 
 #include "bowtie2.h"
 
-void build_bowtie2_index(const options_t& options) {
+bool build_bowtie2_index(const options_t& options, const std::string& fastaFilePath, const std::string& indexPrefix) {
     // Get user's home directory from environment variable
     const char* homeDir = getenv("HOME");
     if (!homeDir) {
         std::cerr << "Error: HOME directory not found." << std::endl;
-        return;
+        return false;
     }
 
 
-    std::string bowtie2Path =  "./bowtie2-2.5.4-linux-x86_64/bowtie2-build";
-    std::string fastaFilePath = options.output + "/" + options.prefix + ".chosen.fasta";
-    std::string indexOutputPath = options.output + "/" + options.prefix + "_idx/" + options.prefix;
-
-
-    std::string command = bowtie2Path + " " + fastaFilePath + " " + indexOutputPath;
+    std::string command = BOWTIE2_BUILD_PATH + " " + fastaFilePath + " " + indexPrefix;
     int result = system(command.c_str());
 
     if (result != 0) {
         std::cerr << "Bowtie2 indexing failed." << std::endl;
+        return false;
     }
+    return true;
 }
 
-std::string generate_bowtie2_command(const options_t& options) {
+std::string generate_bowtie2_command(const options_t& options, const std::string& indexPrefix) {
     std::stringstream command;
 
-    command << "./bowtie2-2.5.4-linux-x86_64/bowtie2" << " -t -p " << options.threads;
-    command << " -x " << options.output << "/" << options.prefix << "_idx/" << options.prefix;
+    command << BOWTIE2_PATH << " -t -p " << options.threads;
+    command << " -x " << indexPrefix;
 
     command << " -1";
     for (const auto& fastq : options.input_fastq1) {
@@ -43,7 +40,7 @@ std::string generate_bowtie2_command(const options_t& options) {
     }
 
     // Other parameters remain unchanged
-    command << " --no-mixed --no-discordant --no-contain --no-overlap --no-head --no-sq -k1 --no-unal";
+    command << " " << BOWTIE2_PARAMETERS;
 
     // Set the output file path
     command << " -S " << options.output << "/" << options.prefix << ".sam";
@@ -51,12 +48,14 @@ std::string generate_bowtie2_command(const options_t& options) {
     return command.str();
 }
 
-void run_bowtie2(const options_t& options) {
-    std::string command = generate_bowtie2_command(options);
+bool run_bowtie2(const options_t& options, const std::string& indexPrefix) {
+    std::string command = generate_bowtie2_command(options, indexPrefix);
     std::cout << "Running command: " << command << std::endl;
     int result = system(command.c_str());
 
     if (result != 0) {
         std::cerr << "Bowtie2 alignment failed." << std::endl;
+        return false;
     }
+    return true;
 }
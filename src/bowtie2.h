@@ -13,11 +13,19 @@
 #include "options.h"
 
 
-void build_bowtie2_index(const options_t& options);
+// Binaries and fixed parameters of the realignment, which also key the realignment cache
+const std::string BOWTIE2_BUILD_PATH = "./bowtie2-2.5.4-linux-x86_64/bowtie2-build";
+const std::string BOWTIE2_PATH = "./bowtie2-2.5.4-linux-x86_64/bowtie2";
+const std::string BOWTIE2_PARAMETERS = "--no-mixed --no-discordant --no-contain --no-overlap --no-head --no-sq -k1 --no-unal";
 
-std::string generate_bowtie2_command(const options_t& options);
+// Build the index of the realignment reference under the path prefix, e.g. <output>/<prefix>_idx/<prefix>.
+// Returns false if bowtie2-build failed.
+bool build_bowtie2_index(const options_t& options, const std::string& fastaFilePath, const std::string& indexPrefix);
 
-void run_bowtie2(const options_t& options);
+std::string generate_bowtie2_command(const options_t& options, const std::string& indexPrefix);
+
+// Realign the reads to the index into <output>/<prefix>.sam, returns false if bowtie2 failed
+bool run_bowtie2(const options_t& options, const std::string& indexPrefix);
 
 
 
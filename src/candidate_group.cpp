@@ -6,71 +6,47 @@
 
 
 
-std::vector<alignment_t> single_alignments(const std::vector<alignment_t>& alignments) {
-    std::vector<alignment_t> single_alignments;
-    std::unordered_map<std::string, int> queryCount;
-
-    // Count the number of times each query name occurs
-    for (const auto& alignment : alignments) {
-        queryCount[alignment.query]++;
-    }
-
-    // Filter alignments where the query name appears uniquely in all alignments
-    for (const auto& alignment : alignments) {
-        if (queryCount[alignment.query] == 1) {
-            single_alignments.push_back(alignment);
+query_groups_t group_alignments(const std::vector<alignment_t>& alignments) {
+    query_groups_t groups;
+    std::unordered_map<std::string, size_t> query_index;
+    std::vector<size_t> alignment_query(alignments.size());
+    std::vector<size_t> counts;
+
+    // Number the queries in the order of their first alignment and count their alignments
+    for (size_t i = 0; i < alignments.size(); ++i) {
+        auto inserted = query_index.emplace(alignments[i].query, counts.size());
+        if (inserted.second) {
+            counts.push_back(0);
         }
+        alignment_query[i] = inserted.first->second;
+        counts[inserted.first->second]++;
     }
 
-    return single_alignments;
-}
-
-
-std::vector<std::pair<alignment_t, alignment_t>> pair_alignments(const std::vector<alignment_t>& alignments) {
-    std::unordered_map<std::string, std::vector<alignment_t>> queryMap;
-
-    // Group each alignment by query name
-    for (const auto& alignment : alignments) {
-        queryMap[alignment.query].push_back(alignment);
+    // Lay out the alignments of each query one after another, in the order of the input
+    groups.spans.reserve(counts.size());
+    size_t begin = 0;
+    for (size_t count : counts) {
+        groups.spans.emplace_back(begin, begin);
+        begin += count;
     }
-
-    std::vector<std::pair<alignment_t, alignment_t>> pair_alignments;
-
-    // Filter out queries from the map that have exactly two alignments, and make sure they form a pair
-    for (const auto& pair : queryMap) {
-        if (pair.second.size() == 2) {
-            pair_alignments.emplace_back(pair.second[0], pair.second[1]);
-        }
-    }
-
-    return pair_alignments;
-}
-
-std::vector<alignment_t> multiple_alignments(const std::vector<alignment_t>& alignments) {
-    std::vector<alignment_t> multiple_alignments;
-    std::unordered_map<std::string, std::vector<alignment_t>> queryAlignments;
-
-    // Store the alignment corresponding to each query name in a vector
-    for (const auto& alignment : alignments) {
-        queryAlignments[alignment.query].push_back(alignment);
+    groups.order.resize(alignments.size());
+    for (size_t i = 0; i < alignments.size(); ++i) {
+        groups.order[groups.spans[alignment_query[i]].second++] = i;
     }
 
-    // Only add all alignments with a query name whose number of alignments is greater than 2
-    for (const auto& query_pair : queryAlignments) {
-        if (query_pair.second.size() > 2) {
-            multiple_alignments.insert(multiple_alignments.end(), query_pair.second.begin(), query_pair.second.end());
+    // Divide the queries by their number of alignments
+    for (size_t span = 0; span < groups.spans.size(); ++span) {
+        size_t size = groups.size(span);
+        if (size == 1) {
+            groups.singles.push_back(span);
+        } else if (size == 2) {
+            groups.pairs.push_back(span);
+        } else {
+            groups.multiples.push_back(span);
+            groups.multiple_alignments += size;
         }
     }
-
-    return multiple_alignments;
-}
-
-void group_alignments(const std::vector<alignment_t>& alignments) {
-    auto singles = single_alignments(alignments);
-
-    auto pairs = pair_alignments(alignments);
-
-    auto multiples = multiple_alignments(alignments);
+    return groups;
 }
 
 
@@ -92,134 +68,65 @@ std::string AlignmentCategoryToString(AlignmentCategory category) {
     }
 }
 
-std::unordered_map<AlignmentCategory, std::vector<std::pair<alignment_t, alignment_t>>> classify_alignments(
-        const std::vector<std::pair<alignment_t, alignment_t>>& paired_alignments, const options_t& options) {
+classified_pairs_t classify_alignments(const std::vector<alignment_t>& alignments, const query_groups_t& groups, const options_t& options) {
 
-    std::unordered_map<AlignmentCategory, std::vector<std::pair<alignment_t, alignment_t>>> classified_alignments;
+    classified_pairs_t classified_alignments;
 
-    for (const auto& alignment_pair : paired_alignments) {
-        const alignment_t& align1 = alignment_pair.first;
-        const alignment_t& align2 = alignment_pair.second;
+    for (size_t span : groups.pairs) {
+        uint32_t first = groups.order[groups.spans[span].first];
+        uint32_t second = groups.order[groups.spans[span].first + 1];
+        const alignment_t& align1 = alignments[first];
+        const alignment_t& align2 = alignments[second];
 
-        CoordPair coord1(align1.qstart, align1.qend, align1.query_strand == '+', align1.query);
-        CoordPair coord2(align2.qstart, align2.qend, align2.query_strand == '+', align2.query);
-
-        bool same_strand = coord1.pos_strand == coord2.pos_strand;
-        int overlap_size = std::max(0, std::min(coord1.end, coord2.end) - std::max(coord1.start, coord2.start));
-        int gap_size = std::max(0, std::max(coord1.start, coord2.start) - std::min(coord1.end, coord2.end));
+        int min1 = std::min(align1.qstart, align1.qend), max1 = std::max(align1.qstart, align1.qend);
+        int min2 = std::min(align2.qstart, align2.qend), max2 = std::max(align2.qstart, align2.qend);
+        bool same_strand = (align1.query_strand == '+') == (align2.query_strand == '+');
 
+        AlignmentCategory category;
         // Check for containment
-        if (coord1.Contains(coord2) || coord2.Contains(coord1)) {
-            if (same_strand) {
-                classified_alignments[CONTAINS_SAME_STRAND].push_back(alignment_pair);
-            } else {
-                classified_alignments[CONTAINS_DIFFERENT_STRAND].push_back(alignment_pair);
-            }
+        if ((min1 <= min2 && max1 >= max2) || (min2 <= min1 && max2 >= max1)) {
+            category = same_strand ? CONTAINS_SAME_STRAND : CONTAINS_DIFFERENT_STRAND;
         }
             // Check for overlaps
-        else if (coord1.Overlaps(coord2)) {
-            if (same_strand && overlap_size <= options.max_overlap_size) {
-                classified_alignments[OVERLAPS_SAME_STRAND].push_back(alignment_pair);
-            } else if (!same_strand && overlap_size <= options.max_overlap_size) {
-                classified_alignments[OVERLAPS_DIFFERENT_STRAND].push_back(alignment_pair);
+        else if (!(max2 < min1 || max1 < min2)) {
+            int overlap_size = std::max(0, std::min(align1.qend, align2.qend) - std::max(align1.qstart, align2.qstart));
+            if (overlap_size > options.max_overlap_size) {
+                continue;
             }
+            category = same_strand ? OVERLAPS_SAME_STRAND : OVERLAPS_DIFFERENT_STRAND;
         }
-            // Check for gaps
-        else if (coord1.Gap(coord2)) {
-            if (same_strand && gap_size <= options.max_gap_size) {
-                classified_alignments[GAP_SAME_STRAND].push_back(alignment_pair);
-            } else if (!same_strand && gap_size <= options.max_gap_size) {
-                classified_alignments[GAP_DIFFERENT_STRAND].push_back(alignment_pair);
+            // Otherwise there is a gap between the alignments
+        else {
+            int gap_size = std::max(0, std::max(align1.qstart, align2.qstart) - std::min(align1.qend, align2.qend));
+            if (gap_size > options.max_gap_size) {
+                continue;
             }
+            category = same_strand ? GAP_SAME_STRAND : GAP_DIFFERENT_STRAND;
         }
+        classified_alignments[category].emplace_back(first, second);
     }
 
-    return classified_alignments;
-}
-
-// Add filter_and_combine_same_strand function implementation
-std::vector<alignment_t> filter_and_combine_same_strand(
-        const std::unordered_map<AlignmentCategory, std::vector<std::pair<alignment_t, alignment_t>>>& classified_alignments,
-        AlignmentCategory category, int max_value, bool is_gap) {
-
-    std::vector<alignment_t> result;
-
-    if (classified_alignments.find(category) == classified_alignments.end()) {
-        return result;  // If there is no such category in the classification, return an empty result directly
+    // The pairs of a category are ordered by query name, the order in which Stage3 pairs them up
+    for (auto& pairs : classified_alignments) {
+        std::sort(pairs.begin(), pairs.end(), [&alignments](const alignment_pair_t& a, const alignment_pair_t& b) {
+            return alignments[a.first].query < alignments[b.first].query;
+        });
     }
 
-    for (const auto& alignment_pair : classified_alignments.at(category)) {
-        const alignment_t& align1 = alignment_pair.first;
-        const alignment_t& align2 = alignment_pair.second;
-
-        CoordPair coord1(align1.qstart, align1.qend, align1.query_strand == '+', align1.query);
-        CoordPair coord2(align2.qstart, align2.qend, align2.query_strand == '+', align2.query);
-
-        int value;
-        if (is_gap) {
-            value = std::max(0, coord2.start - coord1.end);  // 计算 gap 的大小
-        } else {
-            value = std::max(0, std::min(coord1.end, coord2.end) - std::max(coord1.start, coord2.start));  // 计算 overlap 的大小
-        }
-
-        if (value <= max_value) {
-            result.push_back(align1);
-            result.push_back(align2);
-        }
-    }
-
-    return result;
-}
-
-std::vector<alignment_t> filter_and_combine_diff_strand(
-        const std::unordered_map<AlignmentCategory, std::vector<std::pair<alignment_t, alignment_t>>>& classified_alignments,
-        AlignmentCategory category, int max_value, bool is_gap) {
-
-    std::vector<alignment_t> result;
-
-    // If the category is not in the classification, return an empty result directly
-    if (classified_alignments.find(category) == classified_alignments.end()) {
-        return result;
-    }
-
-    for (const auto& alignment_pair : classified_alignments.at(category)) {
-        const alignment_t& align1 = alignment_pair.first;
-        const alignment_t& align2 = alignment_pair.second;
-
-        // create the coordinate pairs for each alignment
-        CoordPair coord1(align1.qstart, align1.qend, align1.query_strand == '+', align1.query);
-        CoordPair coord2(align2.qstart, align2.qend, align2.query_strand == '+', align2.query);
-
-        // calculate the overlap or gap size
-        int value;
-        if (is_gap) {
-            value = std::max(0, coord2.start - coord1.end);
-        } else {
-            value = std::max(0, std::min(coord1.end, coord2.end) - std::max(coord1.start, coord2.start));  // 计算重叠大小
-        }
-
-        // if the overlap or gap size is less than or equal to the maximum value, add the alignments to the result list
-        if (value <= max_value) {
-            result.push_back(align1);
-            result.push_back(align2);
-        }
-    }
-
-    return result;
+    return classified_alignments;
 }
 
-
-// Extract the base part of the query name from the alignment data and avoid duplication
-std::unordered_set<std::string> extractBaseQueryNames(const std::vector<alignment_t>& alignments) {
+// Extract the base part of the query names of the pairs and avoid duplication
+std::unordered_set<std::string> extractBaseQueryNames(const std::vector<alignment_t>& alignments, const std::vector<alignment_pair_t>& pairs) {
     std::unordered_set<std::string> base_query_names;
-    for (const auto& alignment : alignments) {
-        size_t second_underscore = alignment.query.find('_', alignment.query.find('_') + 1);
+    for (const auto& pair : pairs) {
+        const std::string& query = alignments[pair.first].query;
+        size_t second_underscore = query.find('_', query.find('_') + 1);
         if (second_underscore != std::string::npos) {
-            std::string base_query = alignment.query.substr(0, second_underscore);
-            base_query_names.insert(base_query);
+            base_query_names.insert(query.substr(0, second_underscore));
         } else {
             // If there is no second underscore, just add the entire query name
-            base_query_names.insert(alignment.query);
+            base_query_names.insert(query);
         }
     }
     return base_query_names;
@@ -11,6 +11,8 @@
 #include "alignments_chosen.h"
 
 
+#include <array>
+#include <cstdint>
 #include <iostream>
 #include <set>
 #include <string>
@@ -22,41 +24,46 @@
 #include <algorithm>
 #include <utility>
 
-std::vector<alignment_t> single_alignments(const std::vector<alignment_t>& alignments);
-
-std::vector<std::pair<alignment_t, alignment_t>> pair_alignments(const std::vector<alignment_t>& alignments);
-
-std::vector<alignment_t> multiple_alignments(const std::vector<alignment_t>& alignments);
-
-void group_alignments(const std::vector<alignment_t>& alignments);
-
-
 enum AlignmentCategory {
     CONTAINS_SAME_STRAND,
     CONTAINS_DIFFERENT_STRAND,
     OVERLAPS_SAME_STRAND,
     OVERLAPS_DIFFERENT_STRAND,
     GAP_SAME_STRAND,
-    GAP_DIFFERENT_STRAND
+    GAP_DIFFERENT_STRAND,
+    ALIGNMENT_CATEGORIES
 };
 
 
-std::unordered_map<AlignmentCategory, std::vector<std::pair<alignment_t, alignment_t>>> classify_alignments(
-        const std::vector<std::pair<alignment_t, alignment_t>>& paired_alignments, const options_t& options);
+// Alignments of the chosen contigs grouped by query in one pass. The indices of the alignments of a query follow
+// each other in order, the spans of the queries are in the order of their first alignment and are divided by
+// their number of alignments
+struct query_groups_t {
+    std::vector<size_t> order;                          // indices of the grouped alignments
+    std::vector<std::pair<size_t, size_t>> spans;       // begin and end in order of each query
+    std::vector<size_t> singles;                        // spans of the queries with one alignment
+    std::vector<size_t> pairs;                          // with two alignments
+    std::vector<size_t> multiples;                      // with more than two alignments
+    size_t multiple_alignments = 0;                     // number of alignments of the multiples
 
+    size_t size(size_t span) const { return spans[span].second - spans[span].first; }
+};
 
+query_groups_t group_alignments(const std::vector<alignment_t>& alignments);
 
-std::string AlignmentCategoryToString(AlignmentCategory category);
+// Two alignments of a query, as indices into the grouped alignments
+typedef std::pair<uint32_t, uint32_t> alignment_pair_t;
 
+// Pairs by category, each category ordered by query name
+typedef std::array<std::vector<alignment_pair_t>, ALIGNMENT_CATEGORIES> classified_pairs_t;
 
-std::vector<alignment_t> filter_and_combine_same_strand(
-        const std::unordered_map<AlignmentCategory, std::vector<std::pair<alignment_t, alignment_t>>>& classified_alignments,
-        AlignmentCategory category, int max_value, bool is_gap);
-std::vector<alignment_t> filter_and_combine_diff_strand(
-        const std::unordered_map<AlignmentCategory, std::vector<std::pair<alignment_t, alignment_t>>>& classified_alignments,
-        AlignmentCategory category, int max_value, bool is_gap);
+// Classify the pairs of the groups by how the two alignments lie on the query. Overlaps beyond max_overlap_size and
+// gaps beyond max_gap_size are dropped in the same pass, contained alignments are kept whatever their size
+classified_pairs_t classify_alignments(const std::vector<alignment_t>& alignments, const query_groups_t& groups, const options_t& options);
+
+std::string AlignmentCategoryToString(AlignmentCategory category);
 
-std::unordered_set<std::string> extractBaseQueryNames(const std::vector<alignment_t>& alignments);
+std::unordered_set<std::string> extractBaseQueryNames(const std::vector<alignment_t>& alignments, const std::vector<alignment_pair_t>& pairs);
 std::vector<alignment_t> filterAlignmentsByBaseQuery(const std::vector<alignment_t>& alignments, const std::unordered_set<std::string>& base_query_names);
 std::vector<alignment_t> filterAlignmentsByQuery(const std::vector<alignment_t>& alignments, const std::unordered_set<std::string>& query_names);
 
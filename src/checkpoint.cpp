@@ -0,0 +1,368 @@
+#include "checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#include "symbol_table.h"
+
+namespace fs = std::filesystem;
+
+static const char CHECKPOINT_MAGIC[8] = {'D', 'F', 'C', 'K', 'P', 'T', '0', '5'};
+static const uint64_t CHECKPOINT_END = 0x444e45544e494f50ULL;   // "POINTEND"
+
+static inline uint64_t rotate_left(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+void Checksum::update(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    // Whole words first, the remaining bytes one by one
+    for (; size >= 8; bytes += 8, size -= 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes, 8);
+        hash_ ^= word * 0x87c37b91114253d5ULL;
+        hash_ = rotate_left(hash_, 27) * 0x4cf5ad432745937fULL + 0x52dce729;
+    }
+    for (; size > 0; ++bytes, --size) {
+        hash_ = (hash_ ^ *bytes) * 0x100000001b3ULL;
+    }
+}
+
+void Checksum::update(const std::string& value) {
+    update(static_cast<uint64_t>(value.size()));
+    update(value.data(), value.size());
+}
+
+uint64_t Checksum::value() const {
+    // Final mix, so that similar inputs give unrelated checksums
+    uint64_t hash = hash_;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+bool file_checksum(const std::string& filename, uint64_t& checksum) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    // Fixed block size, so the words of the checksum do not depend on how the file is read
+    std::vector<char> buffer(1 << 20);
+    Checksum hash;
+    while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+        hash.update(buffer.data(), file.gcount());
+    }
+    checksum = hash.value();
+    return !file.bad();
+}
+
+void update_file_identity(Checksum& checksum, const std::string& filename) {
+    std::error_code error;
+    fs::path path = fs::absolute(filename, error);
+    checksum.update(error ? filename : path.lexically_normal().string());
+    uintmax_t size = fs::file_size(path, error);
+    checksum.update(static_cast<uint64_t>(error ? 0 : size));
+    auto time = fs::last_write_time(path, error);
+    checksum.update(static_cast<int64_t>(error ? 0 : time.time_since_epoch().count()));
+}
+
+void update_file_key(Checksum& checksum, const std::string& filename) {
+    std::error_code error;
+    uintmax_t size = fs::file_size(filename, error);
+    if (!error && size > FILE_CONTENT_KEY_BYTES) {
+        update_file_identity(checksum, filename);
+        return;
+    }
+    uint64_t content;
+    if (!error && file_checksum(filename, content)) {
+        checksum.update(content);
+    } else {
+        checksum.update(filename);
+    }
+}
+
+
+CheckpointWriter::CheckpointWriter(const std::string& filename, const std::string& stage, uint64_t key):
+        filename_(filename), temporary_(filename + ".tmp"), file_(temporary_, std::ios::binary | std::ios::trunc) {
+    file_.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    write(stage);
+    write(key);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    if (!committed_) {
+        file_.close();
+        std::remove(temporary_.c_str());
+    }
+}
+
+void CheckpointWriter::write(const std::string& value) {
+    write(static_cast<uint64_t>(value.size()));
+    file_.write(value.data(), value.size());
+}
+
+void CheckpointWriter::write(const alignment_t& alignment) {
+    write(alignment.method_);
+    write(alignment.query);
+    write(alignment.target);
+    write(alignment.query_len);
+    write(alignment.target_len);
+    write(alignment.query_strand);
+    write(alignment.qstart);
+    write(alignment.qend);
+    write(alignment.tstart);
+    write(alignment.tend);
+    write(alignment.num_bases_aligned);
+    write(alignment.mismatch);
+    write(alignment.qnuminsert);
+    write(alignment.tnuminsert);
+    write(alignment.matches);
+    write(alignment.repmatch);
+    write(alignment.tbaseinsert);
+    write(alignment.qbaseinsert);
+    write(alignment.blockcount);
+    write(alignment.identity);
+    write(alignment.score);
+    write(alignment.model);
+    write(alignment.pairwise);
+    write(alignment.psl_str);
+    write(alignment.blocks);
+    write(alignment.query_blocks);
+    write(alignment.splice_sites);
+    write(alignment.orient);
+    write(alignment.contig);
+}
+
+void CheckpointWriter::write(const sam_t& sam) {
+    write(sam.qname);
+    write(sam.flag);
+    write(sam.rname);
+    write(sam.pos);
+    write(sam.mapq);
+    write(sam.cigar);
+    write(sam.rnext);
+    write(sam.pnext);
+    write(sam.tlen);
+    write(sam.seq);
+    write(sam.qual);
+    write(sam.optional);
+    write(sam.tp_label);
+    write(sam.num_matches);
+    write(sam.num_insertions);
+    write(sam.num_deletions);
+    write(sam.num_soft_clips);
+    write(sam.num_hard_clips);
+    write(sam.num_skipped);
+}
+
+void CheckpointWriter::write(const OverlapResultCls& overlap) {
+    write(overlap.query_id_);
+    write(overlap.start_);
+    write(overlap.end_);
+    write(overlap.overlap_interval_);
+    write(overlap.contig_start_);
+    write(overlap.contig_end_);
+}
+
+void CheckpointWriter::write(const coordination_t& coordination) {
+    write(coordination.query);
+    write(coordination.target);
+    write(coordination.tstart);
+    write(coordination.tend);
+    write(coordination.strand);
+}
+
+// The symbols are only valid in this process, so the names are written as strings
+void CheckpointWriter::write(const result_t& result) {
+    for (symbol_t symbol : {result.contig, result.gene1, result.gene2, result.gene_id1, result.gene_id2,
+                            result.tstrand1, result.tstrand2, result.chromosome1, result.chromosome2}) {
+        write(SYMBOLS.str(symbol));
+    }
+    write(result.tstart1);
+    write(result.tend1);
+    write(result.tstart2);
+    write(result.tend2);
+    write(result.splitReadsCount);
+    write(result.spanReadsCount);
+    write(result.coverage);
+    write(result.direction1);
+    write(result.direction2);
+    write(result.filters);
+    write(result.recovered);
+    write(result.regiontype1.type);
+    write(result.regiontype1.exon_number);
+    write(result.regiontype2.type);
+    write(result.regiontype2.exon_number);
+}
+
+void CheckpointWriter::write(const query_coordinates_t& query) {
+    write(query.query);
+    write(query.coordinates);
+}
+
+bool CheckpointWriter::commit() {
+    write(CHECKPOINT_END);
+    file_.close();
+    if (file_.fail() || std::rename(temporary_.c_str(), filename_.c_str()) != 0) {
+        return false;
+    }
+    committed_ = true;
+    return true;
+}
+
+
+CheckpointReader::CheckpointReader(const std::string& filename, const std::string& stage, uint64_t key) {
+    open(filename, stage, &key);
+}
+
+CheckpointReader::CheckpointReader(const std::string& filename, const std::string& stage) {
+    open(filename, stage, nullptr);
+}
+
+void CheckpointReader::open(const std::string& filename, const std::string& stage, const uint64_t* key) {
+    file_.open(filename, std::ios::binary | std::ios::ate);
+    if (!file_.is_open()) {
+        return;
+    }
+    remaining_ = file_.tellg();
+    file_.seekg(0);
+
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    std::string checkpoint_stage;
+    uint64_t checkpoint_key;
+    valid_ = read_bytes(magic, sizeof(magic)) && std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0 &&
+             read(checkpoint_stage) && checkpoint_stage == stage &&
+             read(checkpoint_key) && (key == nullptr || checkpoint_key == *key);
+}
+
+bool CheckpointReader::read_bytes(void* data, size_t size) {
+    if (size > remaining_ || !file_.read(static_cast<char*>(data), size)) {
+        remaining_ = 0;
+        return false;
+    }
+    remaining_ -= size;
+    return true;
+}
+
+bool CheckpointReader::read_size(uint64_t& size) {
+    return read(size) && size <= remaining_;
+}
+
+bool CheckpointReader::read(std::string& value) {
+    uint64_t size;
+    if (!read_size(size)) {
+        return false;
+    }
+    value.resize(size);
+    return read_bytes(&value[0], size);
+}
+
+bool CheckpointReader::read(alignment_t& alignment) {
+    return read(alignment.method_) &&
+           read(alignment.query) &&
+           read(alignment.target) &&
+           read(alignment.query_len) &&
+           read(alignment.target_len) &&
+           read(alignment.query_strand) &&
+           read(alignment.qstart) &&
+           read(alignment.qend) &&
+           read(alignment.tstart) &&
+           read(alignment.tend) &&
+           read(alignment.num_bases_aligned) &&
+           read(alignment.mismatch) &&
+           read(alignment.qnuminsert) &&
+           read(alignment.tnuminsert) &&
+           read(alignment.matches) &&
+           read(alignment.repmatch) &&
+           read(alignment.tbaseinsert) &&
+           read(alignment.qbaseinsert) &&
+           read(alignment.blockcount) &&
+           read(alignment.identity) &&
+           read(alignment.score) &&
+           read(alignment.model) &&
+           read(alignment.pairwise) &&
+           read(alignment.psl_str) &&
+           read(alignment.blocks) &&
+           read(alignment.query_blocks) &&
+           read(alignment.splice_sites) &&
+           read(alignment.orient) &&
+           read(alignment.contig);
+}
+
+bool CheckpointReader::read(sam_t& sam) {
+    return read(sam.qname) &&
+           read(sam.flag) &&
+           read(sam.rname) &&
+           read(sam.pos) &&
+           read(sam.mapq) &&
+           read(sam.cigar) &&
+           read(sam.rnext) &&
+           read(sam.pnext) &&
+           read(sam.tlen) &&
+           read(sam.seq) &&
+           read(sam.qual) &&
+           read(sam.optional) &&
+           read(sam.tp_label) &&
+           read(sam.num_matches) &&
+           read(sam.num_insertions) &&
+           read(sam.num_deletions) &&
+           read(sam.num_soft_clips) &&
+           read(sam.num_hard_clips) &&
+           read(sam.num_skipped);
+}
+
+bool CheckpointReader::read(OverlapResultCls& overlap) {
+    return read(overlap.query_id_) &&
+           read(overlap.start_) &&
+           read(overlap.end_) &&
+           read(overlap.overlap_interval_) &&
+           read(overlap.contig_start_) &&
+           read(overlap.contig_end_);
+}
+
+bool CheckpointReader::read(coordination_t& coordination) {
+    return read(coordination.query) &&
+           read(coordination.target) &&
+           read(coordination.tstart) &&
+           read(coordination.tend) &&
+           read(coordination.strand);
+}
+
+bool CheckpointReader::read(result_t& result) {
+    for (symbol_t* symbol : {&result.contig, &result.gene1, &result.gene2, &result.gene_id1, &result.gene_id2,
+                             &result.tstrand1, &result.tstrand2, &result.chromosome1, &result.chromosome2}) {
+        std::string name;
+        if (!read(name)) {
+            return false;
+        }
+        *symbol = SYMBOLS.intern(name);
+    }
+    return read(result.tstart1) &&
+           read(result.tend1) &&
+           read(result.tstart2) &&
+           read(result.tend2) &&
+           read(result.splitReadsCount) &&
+           read(result.spanReadsCount) &&
+           read(result.coverage) &&
+           read(result.direction1) &&
+           read(result.direction2) &&
+           read(result.filters) &&
+           read(result.recovered) &&
+           read(result.regiontype1.type) &&
+           read(result.regiontype1.exon_number) &&
+           read(result.regiontype2.type) &&
+           read(result.regiontype2.exon_number);
+}
+
+bool CheckpointReader::read(query_coordinates_t& query) {
+    return read(query.query) && read(query.coordinates);
+}
+
+bool CheckpointReader::finish() {
+    uint64_t end;
+    return read(end) && end == CHECKPOINT_END && remaining_ == 0;
+}
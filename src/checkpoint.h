@@ -0,0 +1,182 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "alignment.h"
+#include "output_fusions.h"
+#include "overlap.h"
+#include "realign_support.h"
+#include "sam.h"
+
+// 64 bit checksum of the inputs and options of a stage, which keys its checkpoint
+class Checksum {
+public:
+    void update(const void* data, size_t size);
+    void update(const std::string& value);
+
+    template<typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type update(T value) {
+        update(&value, sizeof(value));
+    }
+
+    uint64_t value() const;
+
+private:
+    uint64_t hash_ = 0x9e3779b97f4a7c15ULL;
+};
+
+// Checksum of the content of a file, returns false if the file can not be read
+bool file_checksum(const std::string& filename, uint64_t& checksum);
+
+// Add the identity of a file to a checksum: its absolute path, size and modification time
+void update_file_identity(Checksum& checksum, const std::string& filename);
+
+// Add a file to the key of a checkpoint: the checksum of the content of a file up to FILE_CONTENT_KEY_BYTES, the
+// identity of a larger file, whose content would take long to read on every run, or the name of a missing file
+const uint64_t FILE_CONTENT_KEY_BYTES = 16 << 20;
+void update_file_key(Checksum& checksum, const std::string& filename);
+
+// Binary checkpoint of a stage. The values are written in the byte order of the machine, so a checkpoint is only
+// read back on the kind of machine which wrote it. The file is written under a temporary name and renamed by
+// commit, so an interrupted run never leaves a partial checkpoint behind.
+class CheckpointWriter {
+public:
+    CheckpointWriter(const std::string& filename, const std::string& stage, uint64_t key);
+    ~CheckpointWriter();
+
+    template<typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type write(T value) {
+        file_.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    void write(const std::string& value);
+    void write(const alignment_t& alignment);
+    void write(const sam_t& sam);
+    void write(const OverlapResultCls& overlap);
+    void write(const coordination_t& coordination);
+    void write(const result_t& result);
+    void write(const query_coordinates_t& query);
+
+    template<typename A, typename B>
+    void write(const std::pair<A, B>& value) {
+        write(value.first);
+        write(value.second);
+    }
+    template<typename T>
+    void write(const std::vector<T>& values) {
+        write(static_cast<uint64_t>(values.size()));
+        for (const auto& value : values) {
+            write(value);
+        }
+    }
+    template<typename K, typename V>
+    void write(const std::unordered_map<K, V>& values) {
+        write(static_cast<uint64_t>(values.size()));
+        for (const auto& value : values) {
+            write(value.first);
+            write(value.second);
+        }
+    }
+
+    // Finish the checkpoint, returns false if it could not be written completely, e.g. when the disk is full
+    bool commit();
+
+private:
+    std::string filename_;
+    std::string temporary_;
+    std::ofstream file_;
+    bool committed_ = false;
+};
+
+// Reader of a checkpoint written by CheckpointWriter. A missing or damaged file, or a checkpoint of other inputs or
+// options, is not valid; the reading functions return false once the file turns out to be damaged.
+class CheckpointReader {
+public:
+    CheckpointReader(const std::string& filename, const std::string& stage, uint64_t key);
+    // Accept the checkpoint of the stage whatever inputs and options it was written with
+    CheckpointReader(const std::string& filename, const std::string& stage);
+
+    bool valid() const { return valid_; }
+
+    template<typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value, bool>::type read(T& value) {
+        return read_bytes(&value, sizeof(value));
+    }
+    bool read(std::string& value);
+    bool read(alignment_t& alignment);
+    bool read(sam_t& sam);
+    bool read(OverlapResultCls& overlap);
+    bool read(coordination_t& coordination);
+    bool read(result_t& result);
+    bool read(query_coordinates_t& query);
+
+    template<typename A, typename B>
+    bool read(std::pair<A, B>& value) {
+        return read(value.first) && read(value.second);
+    }
+    template<typename T>
+    bool read(std::vector<T>& values) {
+        uint64_t size;
+        if (!read_size(size)) {
+            return false;
+        }
+        values.clear();
+        values.reserve(size);
+        for (uint64_t i = 0; i < size; ++i) {
+            values.push_back(empty_value<T>());
+            if (!read(values.back())) {
+                return false;
+            }
+        }
+        return true;
+    }
+    template<typename K, typename V>
+    bool read(std::unordered_map<K, V>& values) {
+        uint64_t size;
+        if (!read_size(size)) {
+            return false;
+        }
+        values.clear();
+        values.reserve(size);
+        for (uint64_t i = 0; i < size; ++i) {
+            K key;
+            V value;
+            if (!read(key) || !read(value)) {
+                return false;
+            }
+            values.emplace(std::move(key), std::move(value));
+        }
+        return true;
+    }
+
+    // Check the end of the checkpoint after all values are read
+    bool finish();
+
+private:
+    void open(const std::string& filename, const std::string& stage, const uint64_t* key);
+    bool read_bytes(void* data, size_t size);
+    // Number of elements of a container, each element takes at least one byte of the remaining file
+    bool read_size(uint64_t& size);
+
+    template<typename T>
+    static T empty_value() { return T(); }
+
+    std::ifstream file_;
+    uint64_t remaining_ = 0;
+    bool valid_ = false;
+};
+
+// Types without a default constructor
+template<> inline alignment_t CheckpointReader::empty_value<alignment_t>() { return alignment_t("", 0, 0); }
+template<> inline OverlapResultCls CheckpointReader::empty_value<OverlapResultCls>() { return OverlapResultCls({}, ""); }
+template<> inline std::pair<alignment_t, alignment_t> CheckpointReader::empty_value<std::pair<alignment_t, alignment_t>>() {
+    return std::make_pair(alignment_t("", 0, 0), alignment_t("", 0, 0));
+}
+
+#endif //CHECKPOINT_H
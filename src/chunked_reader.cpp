@@ -0,0 +1,145 @@
+#include "chunked_reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const size_t CHUNK_BYTES = 1 << 20;
+static const size_t CHUNKS_PER_THREAD = 2;
+
+std::unique_ptr<AlignmentReader> ChunkedAlignmentReader::open(const std::string& filename, const header_size_t& header_size,
+                                                              record_parser_t parser, int threads) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+
+    size_t size = status.st_size;
+    const char* data = nullptr;
+    if (size > 0) {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            return nullptr;
+        }
+        // The chunks are read front to back, ahead of the consumer
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapping);
+    }
+    close(fd);
+
+    size_t begin = header_size && size > 0 ? header_size(data, size) : 0;
+    return std::unique_ptr<AlignmentReader>(new ChunkedAlignmentReader(data, size, begin, std::move(parser), threads));
+}
+
+ChunkedAlignmentReader::ChunkedAlignmentReader(const char* data, size_t size, size_t begin, record_parser_t parser, int threads):
+        data_(data), size_(size), next_begin_(begin), released_(0), parser_(std::move(parser)),
+        window_(CHUNKS_PER_THREAD * std::max(threads, 1)), pool_(std::max(threads, 1)) {
+    while (chunks_.size() < window_ && next_begin_ < size_) {
+        submit_chunk();
+    }
+}
+
+ChunkedAlignmentReader::~ChunkedAlignmentReader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+    }
+    // The workers must be done with the mapping before it goes away
+    pool_.wait();
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+void ChunkedAlignmentReader::submit_chunk() {
+    std::unique_ptr<chunk_t> chunk(new chunk_t());
+    chunk->begin = next_begin_;
+    chunk->end = std::min(next_begin_ + CHUNK_BYTES, size_);
+    // Extend the chunk to the end of its last line
+    if (chunk->end < size_) {
+        const char* line_end = static_cast<const char*>(memchr(data_ + chunk->end, '\n', size_ - chunk->end));
+        chunk->end = line_end == nullptr ? size_ : line_end - data_ + 1;
+    }
+    next_begin_ = chunk->end;
+
+    chunk_t* parsed = chunk.get();
+    chunks_.push_back(std::move(chunk));
+    pool_.submit([this, parsed] {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (cancelled_) {
+                return;
+            }
+        }
+        parse(*parsed);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            parsed->done = true;
+        }
+        chunk_done_.notify_all();
+    });
+}
+
+void ChunkedAlignmentReader::parse(chunk_t& chunk) const {
+    std::string line;
+    size_t position = chunk.begin;
+    try {
+        while (position < chunk.end) {
+            const char* line_end = static_cast<const char*>(memchr(data_ + position, '\n', chunk.end - position));
+            size_t end = line_end == nullptr ? chunk.end : line_end - data_;
+            line.assign(data_ + position, end - position);
+            parser_(line, chunk.records, chunk.warnings);
+            position = end + 1;
+        }
+    } catch (...) {
+        chunk.error = std::current_exception();
+    }
+}
+
+bool ChunkedAlignmentReader::next(std::vector<input_record_t>& records) {
+    while (!chunks_.empty()) {
+        chunk_t& chunk = *chunks_.front();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            chunk_done_.wait(lock, [&chunk] { return chunk.done; });
+        }
+        if (!warned_) {
+            for (const auto& warning : chunk.warnings) {
+                std::cerr << warning << std::endl;
+            }
+            warned_ = true;
+        }
+        if (served_ < chunk.records.size()) {
+            records.push_back(std::move(chunk.records[served_++]));
+            return true;
+        }
+        if (chunk.error) {
+            std::rethrow_exception(chunk.error);
+        }
+
+        // Give the pages of the chunk back, the records are copied out of the mapping
+        size_t page = sysconf(_SC_PAGESIZE);
+        size_t release = chunk.end / page * page;
+        if (release > released_) {
+            madvise(const_cast<char*>(data_) + released_, release - released_, MADV_DONTNEED);
+            released_ = release;
+        }
+        chunks_.pop_front();
+        served_ = 0;
+        warned_ = false;
+        if (next_begin_ < size_) {
+            submit_chunk();
+        }
+    }
+    return false;
+}
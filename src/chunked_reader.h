@@ -0,0 +1,71 @@
+#ifndef CHUNKED_READER_H
+#define CHUNKED_READER_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "alignment.h"
+#include "input_adapter.h"
+#include "thread_pool.h"
+
+// Append the record of a line, if the line holds one. Warnings are collected instead of printed, so that they
+// appear in the order of the file whatever thread parses the line.
+typedef std::function<void(const std::string& line, std::vector<input_record_t>& records,
+                           std::vector<std::string>& warnings)> record_parser_t;
+
+// Size of the header of a file which is not made of records, e.g. the psLayout header of PSL
+typedef std::function<size_t(const char* data, size_t size)> header_size_t;
+
+// Reader of a memory mapped alignment file which is cut into chunks at line ends. The chunks ahead of the consumer
+// are parsed in parallel and handed out in the order of the file, so the records come out as a sequential
+// reader would return them. An error of a line is raised after the records before it.
+class ChunkedAlignmentReader: public AlignmentReader {
+public:
+    ~ChunkedAlignmentReader() override;
+
+    // nullptr if the file can not be mapped, e.g. a pipe, the caller reads it sequentially instead
+    static std::unique_ptr<AlignmentReader> open(const std::string& filename, const header_size_t& header_size,
+                                                 record_parser_t parser, int threads);
+
+    bool next(std::vector<input_record_t>& records) override;
+
+private:
+    struct chunk_t {
+        size_t begin;
+        size_t end;
+        std::vector<input_record_t> records;
+        std::vector<std::string> warnings;
+        std::exception_ptr error;
+        bool done = false;
+    };
+
+    ChunkedAlignmentReader(const char* data, size_t size, size_t begin, record_parser_t parser, int threads);
+
+    // Cut the next chunk off the unparsed part of the file and hand it to the pool
+    void submit_chunk();
+    void parse(chunk_t& chunk) const;
+
+    const char* data_;
+    size_t size_;
+    size_t next_begin_;         // start of the part of the file which is not cut into chunks yet
+    size_t released_;           // pages before this offset are given back to the kernel
+    record_parser_t parser_;
+    size_t window_;             // number of chunks parsed ahead of the consumer
+
+    std::deque<std::unique_ptr<chunk_t>> chunks_;
+    size_t served_ = 0;         // records of the front chunk returned so far
+    bool warned_ = false;       // warnings of the front chunk printed
+
+    std::mutex mutex_;
+    std::condition_variable chunk_done_;
+    bool cancelled_ = false;
+    ThreadPool pool_;           // last member, so its workers are joined before the other members go away
+};
+
+#endif //CHUNKED_READER_H
@@ -41,6 +41,8 @@ const filter_t FILTER_min_support = FILTERS.define("min_support");
 const filter_t FILTER_homologs = FILTERS.define("homologs");
 
 // when more than 64 filters are added, the size of the filter member of the fusion_t class needs to be enlarged
+typedef unsigned long long filter_mask_t;
+inline filter_mask_t filter_bit(const filter_t filter) { return static_cast<filter_mask_t>(1) << filter; }
 
 inline bool str_to_int(const char* s, int& i) {
     char* end_of_parsing;
@@ -0,0 +1,39 @@
+#include <algorithm>
+
+#include "contig_pair_index.h"
+
+
+ContigPairIndex::ContigPairIndex(const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments, contig_name_t contig_name)
+        : pairedAlignments_(pairedAlignments), contig_name_(contig_name) {
+    for (size_t i = 0; i < pairedAlignments.size(); ++i) {
+        const alignment_t& alignment1 = pairedAlignments[i].first;
+        const alignment_t& alignment2 = pairedAlignments[i].second;
+
+        // Both alignments of a pair have to belong to the same contig
+        std::string contig = contig_name_(alignment1.query);
+        if (contig != contig_name_(alignment2.query)) {
+            continue;
+        }
+
+        // Unaligned edges of the pair, computed once and summarized per contig
+        int edge_start = std::min(alignment1.qstart, alignment2.qstart);
+        int edge_end = std::max(alignment1.qend, alignment2.qend);
+        int contig_length = alignment1.query_len;
+
+        contig_pairs_t& entry = contigs_[SYMBOLS.intern(contig)];
+        entry.pairs.push_back(i);
+        entry.max_head_unaligned = std::max(entry.max_head_unaligned, edge_start);
+        entry.max_tail_unaligned = std::max(entry.max_tail_unaligned, contig_length - edge_end);
+    }
+}
+
+
+const ContigPairIndex::contig_pairs_t* ContigPairIndex::find(symbol_t contig) const {
+    auto found = contigs_.find(contig);
+    return found == contigs_.end() ? nullptr : &found->second;
+}
+
+
+bool ContigPairIndex::contigOf(const std::string& query, symbol_t& contig) const {
+    return SYMBOLS.find(contig_name_(query), contig) && contigs_.count(contig) > 0;
+}
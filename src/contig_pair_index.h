@@ -0,0 +1,41 @@
+#ifndef CONTIG_PAIR_INDEX_H
+#define CONTIG_PAIR_INDEX_H
+
+#include <climits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "alignment.h"
+#include "symbol_table.h"
+
+// Paired alignments indexed by the exact contig name which the fusion results refer to,
+// shared by the filters that need the alignments of a result
+class ContigPairIndex {
+public:
+    // Maps the query of an alignment to its contig name, e.g. the base name of a cut contig in PSL mode
+    typedef std::string (*contig_name_t)(const std::string& query);
+
+    struct contig_pairs_t {
+        std::vector<size_t> pairs;            // indices into the paired alignments
+        int max_head_unaligned = INT_MIN;     // largest number of unaligned bases before the first aligned base of a pair
+        int max_tail_unaligned = INT_MIN;     // largest number of unaligned bases after the last aligned base of a pair
+    };
+
+    ContigPairIndex(const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments, contig_name_t contig_name);
+
+    // Pairs of a contig, nullptr if the contig has no paired alignments
+    const contig_pairs_t* find(symbol_t contig) const;
+
+    // Contig ID of a query, false if the contig has no paired alignments
+    bool contigOf(const std::string& query, symbol_t& contig) const;
+
+    const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments() const { return pairedAlignments_; }
+
+private:
+    const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments_;
+    contig_name_t contig_name_;
+    std::unordered_map<symbol_t, contig_pairs_t> contigs_;
+};
+
+#endif //CONTIG_PAIR_INDEX_H
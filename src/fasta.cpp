@@ -4,7 +4,13 @@
 
 #include "fasta.h"
 #include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
 #include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // 序列类实现
 SequenceCls::SequenceCls(const std::string &id, const std::string &extra)
@@ -127,13 +133,218 @@ std::unordered_map<std::string, std::string> load_fasta_sequences(const std::str
 
 
 
+FastaIndex::~FastaIndex() {
+    close();
+}
+
+void FastaIndex::open(const std::string &path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw FastaError("cannot open fasta file: " + path);
+    }
+    struct stat file_info;
+    if (fstat(fd, &file_info) != 0) {
+        ::close(fd);
+        throw FastaError("cannot open fasta file: " + path);
+    }
+    data_size_ = file_info.st_size;
+    if (data_size_ > 0) {
+        void* mapping = mmap(nullptr, data_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            data_size_ = 0;
+            throw FastaError("cannot map fasta file: " + path);
+        }
+        data_ = static_cast<const char*>(mapping);
+    }
+    ::close(fd);
+
+    // The cached index is only used if it is not older than the FASTA file and matches its size, a file which was
+    // replaced within the resolution of the modification time is indexed again
+    std::string fai_path = path + ".fai";
+    struct stat fai_info;
+    if (stat(fai_path.c_str(), &fai_info) == 0 && fai_info.st_mtime >= file_info.st_mtime && load_index(fai_path)) {
+        cached_ = true;
+        return;
+    }
+    entries_.clear();
+    names_.clear();
+    if (build_index()) {
+        write_index(fai_path);
+    }
+}
+
+void FastaIndex::close() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), data_size_);
+    }
+    data_ = nullptr;
+    data_size_ = 0;
+    entries_.clear();
+    names_.clear();
+    cached_ = false;
+}
+
+size_t FastaIndex::length(const std::string &name) const {
+    auto entry = entries_.find(name);
+    return entry == entries_.end() ? 0 : entry->second.length;
+}
+
+std::string FastaIndex::sequence(const std::string &name) const {
+    auto found = entries_.find(name);
+    if (found == entries_.end()) {
+        throw FastaError("unknown sequence: " + name);
+    }
+    const entry_t& entry = found->second;
+
+    // Copy the lines up to the length of the sequence, without the line breaks
+    std::string sequence;
+    sequence.reserve(entry.length);
+    const char* position = data_ + entry.offset;
+    const char* end = data_ + data_size_;
+    while (sequence.size() < entry.length && position < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(position, '\n', end - position));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        size_t bases = std::min<size_t>(line_end - position, entry.length - sequence.size());
+        if (bases > 0 && position[bases - 1] == '\r') {
+            --bases;
+        }
+        sequence.append(position, bases);
+        position = line_end + 1;
+    }
+    for (char &c : sequence) {
+        c = std::toupper(c);
+    }
+    return sequence;
+}
+
+bool FastaIndex::load_index(const std::string &fai_path) {
+    std::ifstream fai(fai_path);
+    if (!fai.is_open()) {
+        return false;
+    }
+    std::string line;
+    const entry_t* last = nullptr;  // the entry which ends the file
+    while (std::getline(fai, line)) {
+        std::istringstream columns(line);
+        std::string name;
+        entry_t entry;
+        // Every sequence starts after the line break of its header
+        if (!(columns >> name >> entry.length >> entry.offset >> entry.line_bases >> entry.line_width) || entry.offset == 0 ||
+            entry.offset > data_size_ || data_[entry.offset - 1] != '\n' || entry.line_width < entry.line_bases ||
+            (entry.length > 0 && entry.line_bases == 0)) {
+            entries_.clear();
+            names_.clear();
+            return false;
+        }
+        if (entries_.find(name) == entries_.end()) {
+            names_.push_back(name);
+        }
+        entries_[name] = entry;
+        if (last == nullptr || entry.offset > last->offset) {
+            last = &entries_[name];
+        }
+    }
+    if (last == nullptr) {
+        return data_size_ == 0;
+    }
+
+    // The lines of the last sequence have to reach the end of the file, its last line break is optional and may be
+    // followed by empty lines
+    uint64_t line_break = last->line_width - last->line_bases;
+    uint64_t end = last->offset;
+    if (last->length > 0) {
+        end += (last->length - 1) / last->line_bases * last->line_width + (last->length - 1) % last->line_bases + 1 + line_break;
+    }
+    bool valid = data_size_ + line_break >= end;
+    for (uint64_t i = end; valid && i < data_size_; ++i) {
+        valid = data_[i] == '\n' || data_[i] == '\r';
+    }
+    if (!valid) {
+        entries_.clear();
+        names_.clear();
+    }
+    return valid;
+}
+
+bool FastaIndex::build_index() {
+    bool uniform = true;
+    entry_t* entry = nullptr;
+    uint64_t last_line_bases = 0;     // bases of the previous line of the sequence
+    const char* position = data_;
+    const char* end = data_ + data_size_;
+    while (position < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(position, '\n', end - position));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        uint64_t width = line_end - position + (line_end < end ? 1 : 0);
+        uint64_t bases = line_end - position;
+        if (bases > 0 && position[bases - 1] == '\r') {
+            --bases;
+        }
+
+        if (*position == '>') {
+            // The name is the first word of the header, as in FastaFileCls
+            const char* name_end = position + 1;
+            while (name_end < line_end && !std::isspace(static_cast<unsigned char>(*name_end))) {
+                ++name_end;
+            }
+            std::string name(position + 1, name_end);
+            if (entries_.find(name) == entries_.end()) {
+                names_.push_back(name);
+            }
+            entry = &entries_[name];
+            *entry = {0, static_cast<uint64_t>(line_end - data_) + (line_end < end ? 1 : 0), 0, 0};
+            last_line_bases = 0;
+        } else if (entry == nullptr) {
+            throw FastaError("Improperly formatted fasta file: sequence id line must begin with \">\": \"" + std::string(position, line_end) + "\".");
+        } else {
+            // All lines of a sequence but the last have the width of the first line
+            if (entry->line_bases == 0) {
+                entry->line_bases = bases;
+                entry->line_width = width;
+            } else if (last_line_bases != entry->line_bases || bases > entry->line_bases) {
+                uniform = false;
+            }
+            entry->length += bases;
+            last_line_bases = bases;
+        }
+        position = line_end + 1;
+    }
+    return uniform;
+}
+
+void FastaIndex::write_index(const std::string &fai_path) const {
+    // Written under a temporary name, an index which can not be written, e.g. in a read-only directory, is only kept in memory
+    std::string temporary = fai_path + ".tmp";
+    std::ofstream fai(temporary);
+    if (!fai.is_open()) {
+        return;
+    }
+    for (const auto& name : names_) {
+        const entry_t& entry = entries_.at(name);
+        fai << name << '\t' << entry.length << '\t' << entry.offset << '\t' << entry.line_bases << '\t' << entry.line_width << '\n';
+    }
+    fai.close();
+    if (fai.fail() || std::rename(temporary.c_str(), fai_path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+
+
 // Collect and merge sequences based on base query name
-std::unordered_map<std::string, std::string> collectAndMergeSequences(const std::vector<alignment_t>& alignments, const std::unordered_map<std::string, std::string>& fasta_sequences) {
+std::unordered_map<std::string, std::string> collectAndMergeSequences(const std::vector<alignment_t>& alignments, const FastaIndex& fasta) {
     std::unordered_map<std::string, std::vector<std::pair<int, std::string>>> sequencesToMerge;
 
     for (const auto& alignment : alignments) {
         auto [baseName, number] = parseQuery(alignment.query);
-        if (fasta_sequences.find(alignment.query) != fasta_sequences.end()) {
+        if (fasta.contains(alignment.query)) {
             sequencesToMerge[baseName].emplace_back(number, alignment.query);
         }
     }
@@ -147,7 +358,7 @@ std::unordered_map<std::string, std::string> collectAndMergeSequences(const std:
         std::string lastPart;
         for (const auto& [_, partName] : parts) {
             if (partName != lastPart) {
-                combinedSequence += fasta_sequences.at(partName);
+                combinedSequence += fasta.sequence(partName);
                 lastPart = partName;
             }
         }
@@ -158,7 +369,7 @@ std::unordered_map<std::string, std::string> collectAndMergeSequences(const std:
 }
 
 // Collect and merge sequences based on base query name
-std::unordered_map<std::string, std::string> collectSequences(const std::vector<alignment_t>& alignments, const std::unordered_map<std::string, std::string>& fasta_sequences) {
+std::unordered_map<std::string, std::string> collectSequences(const std::vector<alignment_t>& alignments, const FastaIndex& fasta) {
     std::unordered_map<std::string, std::string> mergedSequences;
 
     // Loop through each alignment
@@ -167,11 +378,11 @@ std::unordered_map<std::string, std::string> collectSequences(const std::vector<
         const std::string& baseName = alignment.query;
 
         // Only add the sequence if it hasn't been added yet
-        if (fasta_sequences.find(baseName) != fasta_sequences.end()) {
+        if (fasta.contains(baseName)) {
             // Check if the baseName has already been added to mergedSequences
             if (mergedSequences.find(baseName) == mergedSequences.end()) {
-                // Add the sequence from fasta_sequences to mergedSequences
-                mergedSequences[baseName] = fasta_sequences.at(baseName);
+                // Read the sequence from the assembly into mergedSequences
+                mergedSequences[baseName] = fasta.sequence(baseName);
             }
         }
     }
@@ -5,6 +5,7 @@
 #ifndef FASTA_H
 #define FASTA_H
 
+#include <cstdint>
 #include <string>
 #include <fstream>
 #include <stdexcept>
@@ -56,6 +57,51 @@ private:
 
 std::unordered_map<std::string, std::string> load_fasta_sequences(const std::string &fasta_path) ;
 
+// Offset index of a FASTA file in the .fai format of samtools faidx. The file is memory-mapped and the sequences
+// are read on demand, so only the pages of the requested contigs are loaded. The index is cached in <path>.fai
+// and rebuilt when it is missing or older than the FASTA file.
+class FastaIndex {
+public:
+    FastaIndex() = default;
+    ~FastaIndex();
+    FastaIndex(const FastaIndex&) = delete;
+    FastaIndex& operator=(const FastaIndex&) = delete;
+
+    // Map the FASTA file and load or build its index, throws FastaError if the file can not be read
+    void open(const std::string &path);
+    void close();
+
+    size_t size() const { return entries_.size(); }
+    const std::vector<std::string>& names() const { return names_; }
+    bool contains(const std::string &name) const { return entries_.count(name) > 0; }
+    // Number of bases of a sequence, 0 for an unknown name
+    size_t length(const std::string &name) const;
+    // Sequence in upper case, throws FastaError for an unknown name
+    std::string sequence(const std::string &name) const;
+
+    // Whether the index was read from the cache file instead of being built
+    bool cached() const { return cached_; }
+
+private:
+    struct entry_t {
+        uint64_t length;        // number of bases
+        uint64_t offset;        // byte offset of the first base
+        uint64_t line_bases;    // bases per line
+        uint64_t line_width;    // bytes per line, including the line break
+    };
+
+    bool load_index(const std::string &fai_path);
+    // Returns false if the lines of a sequence differ in length, such an index is not written to the cache
+    bool build_index();
+    void write_index(const std::string &fai_path) const;
+
+    std::unordered_map<std::string, entry_t> entries_;
+    std::vector<std::string> names_;    // in the order of the file
+    const char* data_ = nullptr;
+    size_t data_size_ = 0;
+    bool cached_ = false;
+};
+
 
 std::string mergeSequences(const std::vector<std::string>& fragments, const std::unordered_map<std::string, std::string>& fasta_sequences);
 
@@ -64,8 +110,8 @@ std::string getBaseQueryName(const std::string& query);
 void outputMergedContigs(const std::vector<alignment_t>& sorted_alignments, const std::unordered_map<std::string, std::string>& fasta_sequences, const options_t& options);
 
 std::pair<std::string, int> parseQuery(const std::string& query);
-std::unordered_map<std::string, std::string> collectAndMergeSequences(const std::vector<alignment_t>& alignments, const std::unordered_map<std::string, std::string>& fasta_sequences);
-std::unordered_map<std::string, std::string> collectSequences(const std::vector<alignment_t>& alignments, const std::unordered_map<std::string, std::string>& fasta_sequences);
+std::unordered_map<std::string, std::string> collectAndMergeSequences(const std::vector<alignment_t>& alignments, const FastaIndex& fasta);
+std::unordered_map<std::string, std::string> collectSequences(const std::vector<alignment_t>& alignments, const FastaIndex& fasta);
 void outputMergedSequences(const std::unordered_map<std::string, std::string>& mergedSequences, const options_t& options);
 
 #endif // FASTA_H
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "filter_chain.h"
+
+#include <chrono>
+#include <memory>
+
+#include "filter_duplicates.h"
+#include "filter_internal_tandem_duplication.h"
+#include "filter_long_gap.h"
+#include "filter_min_support.h"
+#include "filter_mt.h"
+#include "filter_small_fragments.h"
+
+
+void FilterChain::add(filter_t filter, const std::string& description, const predicate_t& discard, const reset_t& reset) {
+    filters_.push_back({filter, description, discard, reset});
+    discarded_.push_back(0);
+    evaluated_.push_back(0);
+    seconds_.push_back(0);
+}
+
+
+size_t FilterChain::apply(std::vector<result_t>& results) {
+    std::fill(discarded_.begin(), discarded_.end(), 0);
+    std::fill(evaluated_.begin(), evaluated_.end(), 0);
+    std::fill(seconds_.begin(), seconds_.end(), 0);
+    for (const auto& entry : filters_)
+        if (entry.reset)
+            entry.reset();
+
+    // Index of the discarding filter for each result, size() if the result is kept. Each filter runs over the results
+    // which the filters before it kept, in input order, so it sees the same results as if the chain were applied to one
+    // result after the other, and it is timed once over its whole pass
+    std::vector<size_t> stage(results.size(), filters_.size());
+    std::vector<size_t> remaining(results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        remaining[i] = i;
+        results[i].filters = 0;
+    }
+    for (size_t j = 0; j < filters_.size() && !remaining.empty(); ++j) {
+        auto start = std::chrono::steady_clock::now();
+        size_t passed = 0;
+        for (size_t i : remaining) {
+            result_t& result = results[i];
+            if (filters_[j].discard(result)) {
+                result.filters = filter_bit(filters_[j].filter);
+                stage[i] = j;
+                ++discarded_[j];
+            } else {
+                remaining[passed++] = i;
+            }
+        }
+        evaluated_[j] = remaining.size();
+        remaining.resize(passed);
+        seconds_[j] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Stable counting sort by stage, kept results first
+    size_t kept = results.size();
+    for (size_t count : discarded_)
+        kept -= count;
+    std::vector<size_t> offsets(filters_.size() + 1);
+    offsets[filters_.size()] = 0;
+    size_t offset = kept;
+    for (size_t j = 0; j < filters_.size(); ++j) {
+        offsets[j] = offset;
+        offset += discarded_[j];
+    }
+    std::vector<size_t> order(results.size());
+    for (size_t i = 0; i < results.size(); ++i)
+        order[offsets[stage[i]]++] = i;
+
+    std::vector<result_t> partitioned;
+    partitioned.reserve(results.size());
+    for (size_t i : order)
+        partitioned.push_back(std::move(results[i]));
+    results.swap(partitioned);
+
+    return kept;
+}
+
+
+void add_fusion_filters(FilterChain& chain, const options_t& options, const FilterHomologs* filter_homologs) {
+    if (options.filters.at("duplicates")) {
+        // The predicate and the reset share the filter
+        auto duplicates = std::make_shared<DuplicatesFilter>();
+        chain.add(FILTER_duplicates, "Filtering fusions with duplicates",
+                  [duplicates](const result_t& result) { return (*duplicates)(result); },
+                  [duplicates]() { duplicates->reset(); });
+    }
+    if (options.filters.at("mt"))
+        chain.add(FILTER_same_gene, "Filtering fusions in MT, mitochondrial", is_mt);
+    if (options.filters.at("long_gap"))
+        chain.add(FILTER_long_gap, "Filtering fusions with long gaps", [&options](const result_t& result) {
+            return has_long_gap(result, options.long_gap_threshold, options.short_segment_threshold);
+        });
+    if (options.filters.at("internal_tandem_duplication"))
+        chain.add(FILTER_homopolymer, "Filtering internal tandem duplications", [&options](const result_t& result) {
+            return is_internal_tandem_duplication(result, options.max_itd_length, options.min_split_reads, options.min_itd_fraction);
+        });
+    if (options.filters.at("homologs") && filter_homologs != nullptr)
+        chain.add(FILTER_homologs, "Filtering fusions with homologs", [filter_homologs](const result_t& result) {
+            return filter_homologs->is_homolog(result);
+        });
+    if (options.filters.at("small_fragments"))
+        chain.add(FILTER_small_fragments, "Filtering fusions with small fragements", [&options](const result_t& result) {
+            return has_small_fragments(result, options.size_ratio_threshold);
+        });
+    if (options.filters.at("min_support"))
+        chain.add(FILTER_min_support, "Filtering fusions under minimum support reads", [&options](const result_t& result) {
+            return lacks_min_support(result, options.min_span_reads, options.min_split_reads);
+        });
+}
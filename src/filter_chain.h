@@ -0,0 +1,56 @@
+#ifndef FILTER_CHAIN_H
+#define FILTER_CHAIN_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "filter_homologs.h"
+#include "options.h"
+#include "output_fusions.h"
+
+// Single-pass filter engine: each result runs through the enabled filters in chain order until the first one
+// discards it, the discarding filter is recorded as bit in result_t::filters
+class FilterChain {
+public:
+    // Returns true if the result is discarded
+    typedef std::function<bool(const result_t&)> predicate_t;
+    // Clears the state a filter keeps between the results, e.g. the results seen by the duplicate filter
+    typedef std::function<void()> reset_t;
+
+    // Append a filter, the description is used in the log messages. The reset is called at the start of each apply()
+    void add(filter_t filter, const std::string& description, const predicate_t& discard, const reset_t& reset = nullptr);
+
+    // Evaluate all results and partition them in place without copying: kept results first, in input order,
+    // followed by the discarded results grouped by filter in chain order. Returns the number of kept results.
+    size_t apply(std::vector<result_t>& results);
+
+    size_t size() const { return filters_.size(); }
+    filter_t filter(size_t i) const { return filters_[i].filter; }
+    const std::string& description(size_t i) const { return filters_[i].description; }
+    // Number of results discarded by the i-th filter in the last call of apply()
+    size_t discarded(size_t i) const { return discarded_[i]; }
+    // Number of results evaluated and time spent by the i-th filter in the last call of apply()
+    size_t evaluated(size_t i) const { return evaluated_[i]; }
+    double seconds(size_t i) const { return seconds_[i]; }
+
+private:
+    struct entry_t {
+        filter_t filter;
+        std::string description;
+        predicate_t discard;
+        reset_t reset;
+    };
+    std::vector<entry_t> filters_;
+    std::vector<size_t> discarded_;
+    std::vector<size_t> evaluated_;
+    std::vector<double> seconds_;
+};
+
+// Append the fusion filters enabled in the options in the order of the pipeline. The filters refer to the options and
+// the homologs, which have to outlive the chain. The homologs are nullptr for input of whole contigs, whose queries
+// are no fragments that could repeat coordinates of their contig.
+void add_fusion_filters(FilterChain& chain, const options_t& options, const FilterHomologs* filter_homologs);
+
+#endif //FILTER_CHAIN_H
@@ -6,40 +6,50 @@
 
 // Define a function to compare whether two result_t are duplicates
 bool is_duplicate(const result_t& res1, const result_t& res2) {
-    return res1.contig == res2.contig &&
-           res1.gene1 == res2.gene1 &&
-           res1.gene2 == res2.gene2 &&
-           res1.tstart1 == res2.tstart1 &&
-           res1.tstart2 == res2.tstart2 &&
-           res1.tstrand1 == res2.tstrand1 &&
-           res1.tstrand2 == res2.tstrand2 &&
-           res1.chromosome1 == res2.chromosome1 &&
-           res1.chromosome2 == res2.chromosome2 &&
-           res1.direction1 == res2.direction1 &&
-           res1.direction2 == res2.direction2;
+    return duplicate_fields_t(res1) == duplicate_fields_t(res2);
 }
 
 
-// Define a function to filter out duplicate results
-std::vector<result_t> filter_duplicates(std::vector<result_t>& results) {
-    std::vector<result_t> unique_results;
+// Mix a value into the key (64-bit variant of boost::hash_combine)
+static inline void hash_combine(uint64_t& key, uint64_t value) {
+    key ^= value + 0x9e3779b97f4a7c15ULL + (key << 12) + (key >> 4);
+}
 
-    for (auto& result : results) {
-        bool is_dup = false;
-        for (const auto& seen : unique_results) {
-            if (is_duplicate(result, seen)) {
-                is_dup = true;
-                break;
-            }
-        }
-        if (is_dup) {
-            result.filter_status = "discarded_duplicates";
-            unique_results.push_back(result);
-        } else {
-            result.filter_status = "kept";
-            unique_results.push_back(result);
+
+uint64_t duplicate_key(const result_t& result) {
+    uint64_t key = result.contig;
+    hash_combine(key, (static_cast<uint64_t>(result.gene1) << 32) | result.gene2);
+    hash_combine(key, (static_cast<uint64_t>(result.tstart1) << 32) | result.tstart2);
+    hash_combine(key, (static_cast<uint64_t>(result.tstrand1) << 32) | result.tstrand2);
+    hash_combine(key, (static_cast<uint64_t>(result.chromosome1) << 32) | result.chromosome2);
+    hash_combine(key, (static_cast<uint64_t>(result.direction1) << 8) | static_cast<uint64_t>(result.direction2));
+    return key;
+}
+
+
+duplicate_fields_t::duplicate_fields_t(const result_t& result):
+        contig(result.contig), gene1(result.gene1), gene2(result.gene2), tstart1(result.tstart1), tstart2(result.tstart2),
+        tstrand1(result.tstrand1), tstrand2(result.tstrand2), chromosome1(result.chromosome1), chromosome2(result.chromosome2),
+        direction1(result.direction1), direction2(result.direction2) {
+}
+
+bool duplicate_fields_t::operator==(const duplicate_fields_t& other) const {
+    return contig == other.contig && gene1 == other.gene1 && gene2 == other.gene2 && tstart1 == other.tstart1 &&
+           tstart2 == other.tstart2 && tstrand1 == other.tstrand1 && tstrand2 == other.tstrand2 &&
+           chromosome1 == other.chromosome1 && chromosome2 == other.chromosome2 &&
+           direction1 == other.direction1 && direction2 == other.direction2;
+}
+
+
+// Discard the result if it duplicates a previous one; the first occurrence is kept
+bool DuplicatesFilter::operator()(const result_t& result) {
+    duplicate_fields_t fields(result);
+    std::vector<duplicate_fields_t>& bucket = seen_[duplicate_key(result)];
+    for (const duplicate_fields_t& seen : bucket) {
+        if (seen == fields) {
+            return true;
         }
     }
-
-    return unique_results;
+    bucket.push_back(fields);
+    return false;
 }
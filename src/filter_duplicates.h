@@ -5,14 +5,42 @@
 #ifndef FUSION_DETECTION_2_FILTER_DUPLICATES_H
 #define FUSION_DETECTION_2_FILTER_DUPLICATES_H
 
+#include <cstdint>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <tuple>
 #include <string>
 #include "output_fusions.h"
 
 
-// Declare the filter_duplicates function
-std::vector<result_t> filter_duplicates(std::vector<result_t>& results);
+bool is_duplicate(const result_t& res1, const result_t& res2);
+
+// 64-bit key over the fields compared by is_duplicate()
+uint64_t duplicate_key(const result_t& result);
+
+// Fields compared by is_duplicate(). The filter keeps a copy of them, as the chain moves the results it has seen.
+struct duplicate_fields_t {
+    explicit duplicate_fields_t(const result_t& result);
+    bool operator==(const duplicate_fields_t& other) const;
+
+    symbol_t contig, gene1, gene2;
+    unsigned int tstart1, tstart2;
+    symbol_t tstrand1, tstrand2, chromosome1, chromosome2;
+    direction_t direction1, direction2;
+};
+
+// Duplicate filter for the filter chain: discards every result that duplicates a result seen before.
+// Results are bucketed by their duplicate key, colliding keys are resolved by comparing the fields.
+class DuplicatesFilter {
+public:
+    bool operator()(const result_t& result);
+
+    // Forget the results seen so far, the chain calls it before each pass
+    void reset() { seen_.clear(); }
+
+private:
+    std::unordered_map<uint64_t, std::vector<duplicate_fields_t>> seen_;
+};
 
 #endif //FUSION_DETECTION_2_FILTER_DUPLICATES_H
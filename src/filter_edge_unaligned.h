@@ -8,12 +8,13 @@
 #include <vector>
 #include <string>
 #include "alignment.h"
+#include "contig_pair_index.h"
 #include "output_fusions.h"
 #include "options.h"
 
 
-std::vector<result_t> filter_edge_unaligned(const std::vector<result_t>& final_results,
-                                             const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments,
-                                             const options_t& options);
+// Check whether a paired alignment of the result leaves more than edge_unaligned bases unaligned at the head or tail.
+// Not part of the fusion filter chain, as the filter never ran in the pipeline.
+bool is_edge_unaligned(const result_t& result, const ContigPairIndex& contig_pairs, int edge_unaligned);
 
 #endif // FILTER_EDGE_UNALIGNED_H
@@ -8,83 +8,54 @@
 #include <sstream>
 #include <iostream>
 
-// Constructor
-FilterHomologs::FilterHomologs(const std::vector<result_t>& final_results,
-                               const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments,
-                               const std::vector<alignment_t>& alignments)
-    : final_results_(final_results), pairedAlignments_(pairedAlignments), alignments_(alignments) {}
-
-// Function to apply the homolog filter
-std::vector<result_t> FilterHomologs::filter_homologs() {
-    std::vector<result_t> filteredResults;
 
-    // Iterate through each result in final_results
-    for (auto result : final_results_) {
-        bool is_repeated = false;
-
-        // Extract contig name from result
-        std::string contig_name = result.contig;
+uint64_t FilterHomologs::coordinateKey(int qstart, int qend) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(qstart)) << 32) | static_cast<uint32_t>(qend);
+}
 
-        // Get matching alignments from pairedAlignments
-        std::vector<std::pair<alignment_t, alignment_t>> matchingPairedAlignments;
-        for (const auto& pair : pairedAlignments_) {
-            const alignment_t& alignment1 = pair.first;
-            const alignment_t& alignment2 = pair.second;
 
-            // Match contig name
-            if (alignment1.query.find(contig_name + "_") == 0 &&
-                alignment2.query.find(contig_name + "_") == 0) {
-                matchingPairedAlignments.push_back(pair);
-            }
+// Constructor
+FilterHomologs::FilterHomologs(const std::vector<result_t>& final_results,
+                               const ContigPairIndex& contig_pairs,
+                               const std::vector<query_coordinates_t>& queries) {
+    // Occurrences of each coordinate pair (qstart, qend) per contig of the results
+    std::unordered_map<symbol_t, std::unordered_map<uint64_t, int>> coordinate_counts;
+    for (const auto& result : final_results) {
+        if (contig_pairs.find(result.contig) != nullptr) {
+            coordinate_counts[result.contig];
         }
+    }
 
-        // Get matching alignments from alignments
-        std::vector<alignment_t> matchingAlignments;
-        for (const auto& alignment : alignments_) {
-            if (alignment.query.find(contig_name + "_") == 0) {
-                matchingAlignments.push_back(alignment);
+    symbol_t contig;
+    for (const auto& query : queries) {
+        if (contig_pairs.contigOf(query.query, contig)) {
+            auto counts = coordinate_counts.find(contig);
+            if (counts != coordinate_counts.end()) {
+                for (const auto& coordinate : query.coordinates) {
+                    ++counts->second[coordinateKey(coordinate.first, coordinate.second)];
+                }
             }
         }
+    }
 
-        // Iterate through matching paired alignments and check for repeated coordinates
-        for (const auto& pair : matchingPairedAlignments) {
-            const alignment_t& alignment1 = pair.first;
-            const alignment_t& alignment2 = pair.second;
-
-            // Check if (qstart, qend) of alignment1 or alignment2 is repeated in matchingAlignments
-            int count1 = countCoordinatePairs(alignment1.qstart, alignment1.qend, matchingAlignments);
-            int count2 = countCoordinatePairs(alignment2.qstart, alignment2.qend, matchingAlignments);
-
-            // If any coordinate pair is repeated, mark as repeated and break
-            if (count1 > 1 || count2 > 1) {
-                is_repeated = true;
+    // A contig is repeated if the coordinates of any of its paired alignments occur more than once
+    const auto& pairedAlignments = contig_pairs.pairedAlignments();
+    for (const auto& [contig_id, counts] : coordinate_counts) {
+        auto count = [&counts](const alignment_t& alignment) {
+            auto found = counts.find(coordinateKey(alignment.qstart, alignment.qend));
+            return found == counts.end() ? 0 : found->second;
+        };
+        for (size_t i : contig_pairs.find(contig_id)->pairs) {
+            if (count(pairedAlignments[i].first) > 1 || count(pairedAlignments[i].second) > 1) {
+                repeated_contigs_.insert(contig_id);
                 break;
             }
         }
-
-        // Set filter status
-        if (!is_repeated) {
-            result.filter_status = "kept";
-            filteredResults.push_back(result);
-        } else {
-            result.filter_status = "discarded_homologs";
-            filteredResults.push_back(result);
-        }
     }
-
-    return filteredResults;
 }
 
-// Helper function to count occurrences of a coordinate pair (qstart, qend) in alignments
-int FilterHomologs::countCoordinatePairs(int qstart, int qend, const std::vector<alignment_t>& alignments) {
-    int count = 0;
-
-    // Count the number of times (qstart, qend) appears in alignments
-    for (const auto& alignment : alignments) {
-        if (alignment.qstart == qstart && alignment.qend == qend) {
-            ++count;
-        }
-    }
 
-    return count;
+// Function to apply the homolog filter to one result
+bool FilterHomologs::is_homolog(const result_t& result) const {
+    return repeated_contigs_.count(result.contig) > 0;
 }
@@ -5,31 +5,31 @@
 #ifndef FILTER_HOMOLOGS_H
 #define FILTER_HOMOLOGS_H
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include "alignment.h"
+#include "contig_pair_index.h"
 #include "output_fusions.h"
 
 // FilterHomologs class definition
 class FilterHomologs {
 public:
-    // Constructor
+    // Constructor, counts the coordinates of the input alignments of the result contigs in one pass
     FilterHomologs(const std::vector<result_t>& final_results,
-                   const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments,
-                   const std::vector<alignment_t>& alignments);
+                   const ContigPairIndex& contig_pairs,
+                   const std::vector<query_coordinates_t>& queries);
 
-    // Function to apply the homolog filter
-    std::vector<result_t> filter_homologs();
+    // Check whether the paired alignments of a result repeat coordinates of other alignments of its contig
+    bool is_homolog(const result_t& result) const;
 
 private:
-    // Helper function to count occurrences of a coordinate pair (qstart, qend) in alignments
-    int countCoordinatePairs(int qstart, int qend, const std::vector<alignment_t>& alignments);
+    static uint64_t coordinateKey(int qstart, int qend);
 
-    // Member variables
-    const std::vector<result_t>& final_results_; // Reference to the results
-    const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments_; // Reference to paired alignments
-    const std::vector<alignment_t>& alignments_; // Reference to full alignments
+    // Contigs of the results whose paired alignments repeat coordinates
+    std::unordered_set<symbol_t> repeated_contigs_;
 };
 
 
@@ -6,8 +6,9 @@
 #ifndef FILTER_INTERNAL_TANDEM_DUPLICATION_H
 #define FILTER_INTERNAL_TANDEM_DUPLICATION_H
 
-std::vector<result_t> filter_internal_tandem_duplication(
-    const std::vector<result_t>& results,
+// Check whether a fusion within one gene is an internal tandem duplication without enough support
+bool is_internal_tandem_duplication(
+    const result_t& res,
     unsigned int max_itd_length,
     unsigned int min_split_reads,
     float min_itd_fraction
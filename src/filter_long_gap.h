@@ -9,6 +9,7 @@
 #include <vector>
 #include "output_fusions.h"
 
-std::vector<result_t> filter_long_gap(const std::vector<result_t>& results, unsigned int long_gap_threshold, unsigned int short_segment_threshold);
+// Check whether a fusion on the same chromosome has a short gap or a short segment
+bool has_long_gap(const result_t& result, unsigned int long_gap_threshold, unsigned int short_segment_threshold);
 
 #endif //FUSION_DETECTION_2_FILTER_LONG_GAP_H
@@ -8,6 +8,7 @@
 #include <vector>
 #include "output_fusions.h"
 
-std::vector<result_t> filter_min_support(std::vector<result_t>& results, unsigned int min_span_reads, unsigned int min_split_reads);
+// Check whether a result has fewer supporting reads than required
+bool lacks_min_support(const result_t& result, unsigned int min_span_reads, unsigned int min_split_reads);
 
 #endif //FUSION_DETECTION_2_FILTER_MIN_SUPPORT_H
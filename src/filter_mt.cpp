@@ -4,14 +4,9 @@
 
 #include "filter_mt.h"
 
-std::vector<result_t> filter_mt(std::vector<result_t>& results) {
-    for (auto& result : results) {
-        if (result.filter_status == "kept") {
-            if (result.chromosome1 == "MT" || result.chromosome2 == "MT" ||
-                result.chromosome1 == "chrM" || result.chromosome2 == "chrM") {
-                result.filter_status = "discarded_mt";
-                }
-        }
-    }
-    return results;
+bool is_mt(const result_t& result) {
+    static const symbol_t MT = SYMBOLS.intern("MT");
+    static const symbol_t CHRM = SYMBOLS.intern("chrM");
+    return result.chromosome1 == MT || result.chromosome2 == MT ||
+           result.chromosome1 == CHRM || result.chromosome2 == CHRM;
 }
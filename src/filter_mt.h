@@ -8,6 +8,7 @@
 #include "common.h"
 #include "output_fusions.h"
 
-std::vector<result_t> filter_mt(std::vector<result_t>& results);
+// Check whether a fusion partner lies on the mitochondrial chromosome
+bool is_mt(const result_t& result);
 
 #endif //FILTER_MT_H
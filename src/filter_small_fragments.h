@@ -7,6 +7,7 @@
 
 #include "output_fusions.h"
 
-std::vector<result_t> filter_small_fragments(const std::vector<result_t>& results, const options_t& options);
+// Check whether the smaller fusion part is too small relative to the larger one
+bool has_small_fragments(const result_t& result, float size_ratio_threshold);
 
 #endif //FILTER_SMALL_FRAGMENTS_H
@@ -0,0 +1,295 @@
+#include "input_adapter.h"
+
+#include <algorithm>
+
+#include "candidate_group.h"
+#include "chunked_reader.h"
+#include "paf.h"
+#include "psl.h"
+#include "sam.h"
+
+bool InputAdapter::passes_score(const std::vector<alignment_t>& alignments, const options_t& options) const {
+    // Sum up the scores of the contig, the total score has to exceed the threshold
+    double total_score = 0.0;
+    for (const auto& alignment : alignments) {
+        total_score += alignment.score;
+    }
+    return total_score > options.min_score_total;
+}
+
+void InputAdapter::load(const std::string& filename, const FastaIndex& fasta, int threads, std::vector<alignment_t>& alignments) const {
+    std::unique_ptr<AlignmentReader> reader = open(filename, fasta, threads);
+    std::vector<input_record_t> records;
+    while (reader->next(records)) {
+        alignments.push_back(build_alignment(records.back()));
+        records.clear();
+    }
+}
+
+
+alignment_t build_alignment(input_record_t& record) {
+    if (const psl_t* psl = std::get_if<psl_t>(&record.record)) {
+        return alignment_t("blat", *psl);
+    }
+    if (const paf_t* paf = std::get_if<paf_t>(&record.record)) {
+        return alignment_t("minimap2paf", *paf);
+    }
+    if (const sam_t* sam = std::get_if<sam_t>(&record.record)) {
+        return alignment_t("minimap2sam", *sam, record.key.query_len);
+    }
+    alignment_t alignment(record.key.query, record.key.qstart, record.key.qend);
+    alignment.query_len = record.key.query_len;
+    alignment.matches = record.key.matches;
+    alignment.mismatch = record.key.mismatch;
+    alignment.identity = record.key.identity;
+    alignment.score = record.key.score;
+    alignment.input_record = record.position;
+    return alignment;
+}
+
+template<typename T>
+static void add_record(alignment_key_t key, T&& parsed, std::vector<input_record_t>& records) {
+    records.emplace_back();
+    records.back().key = std::move(key);
+    records.back().record = std::forward<T>(parsed);
+}
+
+
+AlignmentGroupReader::AlignmentGroupReader(const InputAdapter& adapter, const std::string& filename, const FastaIndex& fasta, int threads):
+        reader_(adapter.open(filename, fasta, threads)) {
+}
+
+AlignmentGroupReader::AlignmentGroupReader(std::unique_ptr<AlignmentReader> reader): reader_(std::move(reader)) {
+}
+
+bool AlignmentGroupReader::next(std::vector<input_record_t>& group) {
+    group.clear();
+    if (lookahead_.empty() && !reader_->next(lookahead_)) {
+        return false;
+    }
+    do {
+        group.push_back(std::move(lookahead_.back()));
+        lookahead_.clear();
+    } while (reader_->next(lookahead_) && lookahead_.back().key.query == group.front().key.query);
+
+    if (!queries_.insert(group.front().key.query).second) {
+        grouped_ = false;
+    }
+    return true;
+}
+
+
+class PslAlignmentReader: public AlignmentReader {
+public:
+    explicit PslAlignmentReader(const std::string& filename): file_(filename) {}
+
+    bool next(std::vector<input_record_t>& records) override {
+        if (!file_.next(psl_)) {
+            return false;
+        }
+        // Add qEnds and tEnds for psl format
+        calculate_ends(psl_);
+        add_record(alignment_key(psl_), psl_, records);
+        return true;
+    }
+
+private:
+    PslFileCls file_;
+    psl_t psl_;
+};
+
+std::unique_ptr<AlignmentReader> PslInputAdapter::open(const std::string& filename, const FastaIndex& /*fasta*/, int threads) const {
+    std::unique_ptr<AlignmentReader> reader = ChunkedAlignmentReader::open(filename, psl_header_size,
+        [](const std::string& line, std::vector<input_record_t>& records, std::vector<std::string>& /*warnings*/) {
+            if (line.empty() || line[0] == '#') {
+                return;
+            }
+            psl_t psl;
+            psl_record(line, psl);
+            calculate_ends(psl);
+            add_record(alignment_key(psl), std::move(psl), records);
+        }, threads);
+    if (!reader) {
+        reader.reset(new PslAlignmentReader(filename));
+    }
+    return reader;
+}
+
+std::vector<alignment_t> PslInputAdapter::select_fragments(const std::vector<alignment_t>& chosen_alignments, const std::unordered_set<std::string>& query_names) const {
+    // Filter alignments based on base query name, the fragments which are not continous on chromsome are discarded
+    std::vector<alignment_t> fragments = removeDiscontinuousChromosomes(filterAlignmentsByBaseQuery(chosen_alignments, query_names));
+    std::sort(fragments.begin(), fragments.end(), compareAlignments);
+    return fragments;
+}
+
+sequences_t PslInputAdapter::collect_sequences(const std::vector<alignment_t>& fragments, const FastaIndex& fasta) const {
+    return collectAndMergeSequences(fragments, fasta);
+}
+
+std::vector<OverlapResultCls> PslInputAdapter::process_pairs(const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments, const sequences_t& sequences) const {
+    return processAndMergeAlignments(pairedAlignments, sequences);
+}
+
+std::vector<alignment_t> PslInputAdapter::supported_alignments(const std::vector<alignment_t>& fragments, const std::vector<alignment_t>& /*chosen_alignments*/,
+                                                               const std::vector<alignment_pair_t>& /*overlaps_same_strand*/,
+                                                               const std::unordered_set<std::string>& valid_queries) const {
+    return filterAlignmentsByValidBaseQueries(fragments, valid_queries);
+}
+
+std::vector<coordination_t> PslInputAdapter::coordinations(const std::vector<alignment_t>& alignments) const {
+    // Merge continuous segments of the cut contigs
+    return mergeContinuousSegments(extractCoordinations(alignments));
+}
+
+
+bool Minimap2InputAdapter::passes_score(const std::vector<alignment_t>& alignments, const options_t& options) const {
+    // Each alignment has to exceed the threshold in addition to the total score
+    int total_score = 0;
+    for (const auto& alignment : alignments) {
+        if (alignment.score <= options.min_score_each) {
+            return false;
+        }
+        total_score += alignment.score;
+    }
+    return total_score > options.min_score_total;
+}
+
+std::vector<alignment_t> Minimap2InputAdapter::select_fragments(const std::vector<alignment_t>& chosen_alignments, const std::unordered_set<std::string>& query_names) const {
+    return filterAlignmentsByQuery(chosen_alignments, query_names);
+}
+
+sequences_t Minimap2InputAdapter::collect_sequences(const std::vector<alignment_t>& fragments, const FastaIndex& fasta) const {
+    return collectSequences(fragments, fasta);
+}
+
+std::vector<OverlapResultCls> Minimap2InputAdapter::process_pairs(const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments, const sequences_t& /*sequences*/) const {
+    // Get the complete best aligned alignments from the same contig
+    return processAlignments(pairedAlignments);
+}
+
+std::vector<alignment_t> Minimap2InputAdapter::supported_alignments(const std::vector<alignment_t>& /*fragments*/, const std::vector<alignment_t>& chosen_alignments,
+                                                                    const std::vector<alignment_pair_t>& overlaps_same_strand,
+                                                                    const std::unordered_set<std::string>& valid_queries) const {
+    return filterAlignmentsByValidQueries(chosen_alignments, overlaps_same_strand, valid_queries);
+}
+
+std::vector<coordination_t> Minimap2InputAdapter::coordinations(const std::vector<alignment_t>& alignments) const {
+    return extractSimpleCoordinations(alignments);
+}
+
+
+// this is the first sam loading, which is distinguished with realignment
+static void add_sam_record(sam_t&& sam, const FastaIndex& fasta, std::vector<input_record_t>& records,
+                           std::vector<std::string>& warnings) {
+    // The query length of SAM records is taken from the index of the contigs
+    if (!fasta.contains(sam.qname)) {
+        warnings.push_back("Warning: Could not find contig length for query: " + sam.qname);
+    }
+    int query_length = static_cast<int>(fasta.length(sam.qname));
+    // The alignment does not need the sequence of the contig
+    sam.seq = std::string();
+    sam.qual = std::string();
+    add_record(alignment_key(sam, query_length), std::move(sam), records);
+}
+
+class SamFileAlignmentReader: public AlignmentReader {
+public:
+    SamFileAlignmentReader(const std::string& filename, const FastaIndex& fasta): file_(filename), fasta_(fasta) {}
+
+    bool next(std::vector<input_record_t>& records) override {
+        if (!file_.next(sam_)) {
+            return false;
+        }
+        std::vector<std::string> warnings;
+        add_sam_record(sam_t(sam_), fasta_, records, warnings);
+        for (const auto& warning : warnings) {
+            std::cerr << warning << std::endl;
+        }
+        return true;
+    }
+
+private:
+    SamFileCls file_;
+    const FastaIndex& fasta_;
+    sam_t sam_;
+};
+
+// Fails on a SAM file without alignments
+class SamAlignmentReader: public AlignmentReader {
+public:
+    SamAlignmentReader(const std::string& filename, std::unique_ptr<AlignmentReader> reader): filename_(filename), reader_(std::move(reader)) {}
+
+    bool next(std::vector<input_record_t>& records) override {
+        if (!reader_->next(records)) {
+            // Check if the SAM file is empty
+            if (records_ == 0) {
+                throw SamError("SAM file is empty：" + filename_);
+            }
+            return false;
+        }
+        ++records_;
+        return true;
+    }
+
+private:
+    std::string filename_;
+    std::unique_ptr<AlignmentReader> reader_;
+    size_t records_ = 0;
+};
+
+std::unique_ptr<AlignmentReader> SamInputAdapter::open(const std::string& filename, const FastaIndex& fasta, int threads) const {
+    std::unique_ptr<AlignmentReader> reader = ChunkedAlignmentReader::open(filename, nullptr,
+        [&fasta](const std::string& line, std::vector<input_record_t>& records, std::vector<std::string>& warnings) {
+            sam_t sam;
+            if (sam_record(line, sam)) {
+                add_sam_record(std::move(sam), fasta, records, warnings);
+            }
+        }, threads);
+    if (!reader) {
+        reader.reset(new SamFileAlignmentReader(filename, fasta));
+    }
+    return std::unique_ptr<AlignmentReader>(new SamAlignmentReader(filename, std::move(reader)));
+}
+
+
+class PafAlignmentReader: public AlignmentReader {
+public:
+    explicit PafAlignmentReader(const std::string& filename): file_(filename) {}
+
+    bool next(std::vector<input_record_t>& records) override {
+        if (!file_.next(paf_)) {
+            return false;
+        }
+        add_record(alignment_key(paf_), paf_, records);
+        return true;
+    }
+
+private:
+    PafFileCls file_;
+    paf_t paf_;
+};
+
+std::unique_ptr<AlignmentReader> PafInputAdapter::open(const std::string& filename, const FastaIndex& /*fasta*/, int threads) const {
+    std::unique_ptr<AlignmentReader> reader = ChunkedAlignmentReader::open(filename, nullptr,
+        [](const std::string& line, std::vector<input_record_t>& records, std::vector<std::string>& /*warnings*/) {
+            paf_t paf;
+            if (paf_record(line, paf)) {
+                add_record(alignment_key(paf), std::move(paf), records);
+            }
+        }, threads);
+    if (!reader) {
+        reader.reset(new PafAlignmentReader(filename));
+    }
+    return reader;
+}
+
+
+std::unique_ptr<InputAdapter> make_input_adapter(const std::string& input_type) {
+    if (input_type == "blat")
+        return std::unique_ptr<InputAdapter>(new PslInputAdapter());
+    if (input_type == "minimap2sam")
+        return std::unique_ptr<InputAdapter>(new SamInputAdapter());
+    if (input_type == "minimap2paf")
+        return std::unique_ptr<InputAdapter>(new PafInputAdapter());
+    return nullptr;
+}
@@ -0,0 +1,146 @@
+#ifndef INPUT_ADAPTER_H
+#define INPUT_ADAPTER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+#include "alignment.h"
+#include "contig_pair_index.h"
+#include "fasta.h"
+#include "options.h"
+#include "overlap.h"
+#include "realign_support.h"
+
+typedef std::unordered_map<std::string, std::string> sequences_t;
+
+// Record of the input alignments, parsed as far as Stage1 groups and settles the alignments of a query. The alignment_t
+// is only built for the records which Stage1 keeps or scores.
+struct input_record_t {
+    alignment_key_t key;
+    std::variant<std::monostate, psl_t, paf_t, sam_t> record;  // empty for the records of a sort spilled to disk
+    long long position = -1;                                    // position in the input of a record without its fields
+};
+
+// Alignment of a record. A record of a spilled sort gives an alignment with the fields of its key only, which
+// restore_alignments completes.
+alignment_t build_alignment(input_record_t& record);
+
+// Reader of the input alignments one record at a time
+class AlignmentReader {
+public:
+    virtual ~AlignmentReader() = default;
+
+    // Append the next record, false at the end of the file
+    virtual bool next(std::vector<input_record_t>& records) = 0;
+};
+
+// Format specific steps of the pipeline. Every adapter converts its input into the same table of alignment_t,
+// the remaining hooks cover the few places where the handling of cut contigs (PSL) and whole contigs (SAM/PAF) differs
+class InputAdapter {
+public:
+    virtual ~InputAdapter() = default;
+
+    // Name of the input format used in the log messages, e.g. "PSL"
+    virtual const char* format() const = 0;
+
+    // Open the alignments of the contigs to the genome. The records of a regular file are parsed by the given number
+    // of threads
+    virtual std::unique_ptr<AlignmentReader> open(const std::string& filename, const FastaIndex& fasta, int threads) const = 0;
+    // Load all alignments of the file
+    void load(const std::string& filename, const FastaIndex& fasta, int threads, std::vector<alignment_t>& alignments) const;
+
+    // Whether the queries are fragments of the contigs, so that a query aligned as a whole may still be part of a fusion
+    virtual bool fragmented() const { return false; }
+
+    // Check whether the alignments of a contig pass the score thresholds
+    virtual bool passes_score(const std::vector<alignment_t>& alignments, const options_t& options) const;
+
+    // Select the alignments of the candidate contigs and collect the sequences which the reads are realigned to
+    virtual std::vector<alignment_t> select_fragments(const std::vector<alignment_t>& chosen_alignments, const std::unordered_set<std::string>& query_names) const = 0;
+    virtual sequences_t collect_sequences(const std::vector<alignment_t>& fragments, const FastaIndex& fasta) const = 0;
+
+    // Determine the fusion overlaps of the paired alignments
+    virtual std::vector<OverlapResultCls> process_pairs(const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments, const sequences_t& sequences) const = 0;
+
+    // Genomic coordinates of the contigs supported by reads
+    virtual std::vector<alignment_t> supported_alignments(const std::vector<alignment_t>& fragments, const std::vector<alignment_t>& chosen_alignments,
+                                                          const std::vector<alignment_pair_t>& overlaps_same_strand,
+                                                          const std::unordered_set<std::string>& valid_queries) const = 0;
+    virtual std::vector<coordination_t> coordinations(const std::vector<alignment_t>& alignments) const = 0;
+
+    // Contig name which the fusion results of a query refer to
+    virtual ContigPairIndex::contig_name_t contig_name() const = 0;
+};
+
+// BLAT alignments in PSL format, contigs are cut into fragments which are merged again before realignment
+class PslInputAdapter: public InputAdapter {
+public:
+    const char* format() const override { return "PSL"; }
+    bool fragmented() const override { return true; }
+    std::unique_ptr<AlignmentReader> open(const std::string& filename, const FastaIndex& fasta, int threads) const override;
+    std::vector<alignment_t> select_fragments(const std::vector<alignment_t>& chosen_alignments, const std::unordered_set<std::string>& query_names) const override;
+    sequences_t collect_sequences(const std::vector<alignment_t>& fragments, const FastaIndex& fasta) const override;
+    std::vector<OverlapResultCls> process_pairs(const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments, const sequences_t& sequences) const override;
+    std::vector<alignment_t> supported_alignments(const std::vector<alignment_t>& fragments, const std::vector<alignment_t>& chosen_alignments,
+                                                  const std::vector<alignment_pair_t>& overlaps_same_strand,
+                                                  const std::unordered_set<std::string>& valid_queries) const override;
+    std::vector<coordination_t> coordinations(const std::vector<alignment_t>& alignments) const override;
+    ContigPairIndex::contig_name_t contig_name() const override { return extractBaseQueryName; }
+};
+
+// Common steps of the minimap2 inputs, the contigs are aligned as a whole
+class Minimap2InputAdapter: public InputAdapter {
+public:
+    bool passes_score(const std::vector<alignment_t>& alignments, const options_t& options) const override;
+    std::vector<alignment_t> select_fragments(const std::vector<alignment_t>& chosen_alignments, const std::unordered_set<std::string>& query_names) const override;
+    sequences_t collect_sequences(const std::vector<alignment_t>& fragments, const FastaIndex& fasta) const override;
+    std::vector<OverlapResultCls> process_pairs(const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments, const sequences_t& sequences) const override;
+    std::vector<alignment_t> supported_alignments(const std::vector<alignment_t>& fragments, const std::vector<alignment_t>& chosen_alignments,
+                                                  const std::vector<alignment_pair_t>& overlaps_same_strand,
+                                                  const std::unordered_set<std::string>& valid_queries) const override;
+    std::vector<coordination_t> coordinations(const std::vector<alignment_t>& alignments) const override;
+    ContigPairIndex::contig_name_t contig_name() const override { return query_name; }
+
+private:
+    static std::string query_name(const std::string& query) { return query; }
+};
+
+// minimap2 alignments in SAM format
+class SamInputAdapter: public Minimap2InputAdapter {
+public:
+    const char* format() const override { return "SAM"; }
+    std::unique_ptr<AlignmentReader> open(const std::string& filename, const FastaIndex& fasta, int threads) const override;
+};
+
+// minimap2 alignments in PAF format
+class PafInputAdapter: public Minimap2InputAdapter {
+public:
+    const char* format() const override { return "PAF"; }
+    std::unique_ptr<AlignmentReader> open(const std::string& filename, const FastaIndex& fasta, int threads) const override;
+};
+
+// Groups of the consecutive alignments of a query, in the order of the input file. pblat and minimap2 write the
+// alignments of a query together; grouped() turns false once a query occurs again after other queries.
+class AlignmentGroupReader {
+public:
+    AlignmentGroupReader(const InputAdapter& adapter, const std::string& filename, const FastaIndex& fasta, int threads);
+    explicit AlignmentGroupReader(std::unique_ptr<AlignmentReader> reader);
+
+    bool next(std::vector<input_record_t>& group);
+    bool grouped() const { return grouped_; }
+
+private:
+    std::unique_ptr<AlignmentReader> reader_;
+    std::vector<input_record_t> lookahead_;     // first record of the next group
+    std::unordered_set<std::string> queries_;   // queries of the groups read so far
+    bool grouped_ = true;
+};
+
+// Create the adapter of an input type (blat, minimap2sam, minimap2paf), nullptr if the type is not supported
+std::unique_ptr<InputAdapter> make_input_adapter(const std::string& input_type);
+
+#endif //INPUT_ADAPTER_H
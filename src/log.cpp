@@ -2,44 +2,183 @@
 // Created by xinwei on 6/6/24.
 //
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "log.h"
 
-std::ofstream Logger::logFile;
+std::atomic<LogLevel> Logger::level_(LogLevel::DEBUG);
+std::atomic<Logger::record_t*> Logger::head_(nullptr);
+thread_local Logger::sink_t* Logger::sink_ = nullptr;
+
+struct Logger::sink_t {
+    std::ofstream file;
+};
+
+static std::thread writer;
+static std::mutex lifecycle_mutex;     // guards open_sinks and the start and stop of the writer
+static int open_sinks = 0;
+static std::mutex writer_mutex;
+static std::condition_variable writer_wakeup;
+static std::atomic<bool> waiting(false);
+static bool stopping = false;
+
+// Let the writer drain the queue and wait for it, called with lifecycle_mutex held
+static void stopWriter() {
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        stopping = true;
+    }
+    writer_wakeup.notify_one();
+    writer.join();
+}
+
+void Logger::configure(const options_t& options) {
+    LogLevel level;
+    if (parseLevel(options.log_level, level)) {
+        setLevel(level);
+    }
+}
 
 void Logger::init(const options_t& options) {
-    logFile.open(options.output + "/" + options.prefix + ".log", std::ios::out); // Clear existing content
-    logFile.close(); // Close the file
-    logFile.open(options.output + "/" +options.prefix + ".log", std::ios::out | std::ios::app); // Reopen in append mode
+    close();
+    sink_t* sink = new sink_t;
+    sink->file.open(options.output + "/" + options.prefix + ".log", std::ios::out | std::ios::trunc); // Clear existing content
+
+    std::lock_guard<std::mutex> lock(lifecycle_mutex);
+    if (open_sinks++ == 0) {
+        stopping = false;
+        writer = std::thread(writeLoop);
+    }
+    sink_ = sink;
+
+    // Write the pending messages when the program exits early, e.g. by crash()
+    static bool registered = false;
+    if (!registered) {
+        std::atexit(shutdown);
+        registered = true;
+    }
 }
 
 void Logger::close() {
-    if (logFile.is_open()) {
-        logFile.close();
+    sink_t* sink = sink_;
+    if (sink == nullptr) {
+        return;
+    }
+    sink_ = nullptr;
+    push(new record_t{nullptr, LogLevel::INFO, "", sink, true});
+
+    std::lock_guard<std::mutex> lock(lifecycle_mutex);
+    if (--open_sinks == 0) {
+        stopWriter();
     }
 }
 
+void Logger::shutdown() {
+    std::lock_guard<std::mutex> lock(lifecycle_mutex);
+    if (open_sinks > 0) {
+        open_sinks = 0;
+        stopWriter();
+    }
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& level) {
+    if (name == "debug") level = LogLevel::DEBUG;
+    else if (name == "info") level = LogLevel::INFO;
+    else if (name == "warning") level = LogLevel::WARNING;
+    else if (name == "error") level = LogLevel::ERROR;
+    else return false;
+    return true;
+}
+
 void Logger::Log(const std::string& message, LogLevel level) {
-    // Prepare the log level prefix as a string
-    std::string logLevelPrefix;
-    switch (level) {
-        case LogLevel::DEBUG:
-            logLevelPrefix = "[DEBUG]: ";
-            break;
-        case LogLevel::INFO:
-            logLevelPrefix = "[INFO]: ";
-            break;
-        case LogLevel::WARNING:
-            logLevelPrefix = "[WARNING]: ";
-            break;
-        case LogLevel::ERROR:
-            logLevelPrefix = "[ERROR]: ";
-            break;
+    sink_t* sink = sink_;
+    if (!enabled(level) || sink == nullptr) {
+        return;
     }
+    push(new record_t{nullptr, level, message, sink, false});
+}
+
+void Logger::push(record_t* record) {
+    // Lock-free push onto the stack of pending messages, the writer restores the order
+    record_t* head = head_.load(std::memory_order_relaxed);
+    do {
+        record->next = head;
+    } while (!head_.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
 
-    // Write to the log file with level prefix and message
-    if (logFile.is_open()) {
-        logFile << logLevelPrefix << message << std::endl;
+    if (waiting.load()) {
+        writer_wakeup.notify_one();
+    }
+}
+
+void Logger::writeLoop() {
+    while (true) {
+        // Take all pending messages at once
+        record_t* batch = head_.exchange(nullptr, std::memory_order_acquire);
+        if (batch == nullptr) {
+            std::unique_lock<std::mutex> lock(writer_mutex);
+            if (stopping && head_.load() == nullptr) {
+                break;
+            }
+            waiting.store(true);
+            writer_wakeup.wait_for(lock, std::chrono::milliseconds(100), [] { return stopping || head_.load() != nullptr; });
+            waiting.store(false);
+            continue;
+        }
+
+        // The stack holds the newest message first
+        record_t* ordered = nullptr;
+        while (batch != nullptr) {
+            record_t* next = batch->next;
+            batch->next = ordered;
+            ordered = batch;
+            batch = next;
+        }
+
+        // Files written in this batch, flushed once at the end
+        std::vector<sink_t*> written;
+        while (ordered != nullptr) {
+            sink_t* sink = ordered->sink;
+            if (ordered->close) {
+                written.erase(std::remove(written.begin(), written.end(), sink), written.end());
+                sink->file.close();
+                delete sink;
+            } else {
+                // Prepare the log level prefix as a string
+                const char* logLevelPrefix = "";
+                switch (ordered->level) {
+                    case LogLevel::DEBUG:
+                        logLevelPrefix = "[DEBUG]: ";
+                        break;
+                    case LogLevel::INFO:
+                        logLevelPrefix = "[INFO]: ";
+                        break;
+                    case LogLevel::WARNING:
+                        logLevelPrefix = "[WARNING]: ";
+                        break;
+                    case LogLevel::ERROR:
+                        logLevelPrefix = "[ERROR]: ";
+                        break;
+                }
+                if (sink->file.is_open()) {
+                    sink->file << logLevelPrefix << ordered->message << '\n';
+                }
+                if (std::find(written.begin(), written.end(), sink) == written.end()) {
+                    written.push_back(sink);
+                }
+            }
+            record_t* next = ordered->next;
+            delete ordered;
+            ordered = next;
+        }
+        for (sink_t* sink : written) {
+            sink->file.flush();
+        }
     }
 }
 
@@ -58,4 +197,4 @@ void Logger::Warning(const std::string& message) {
 
 void Logger::Error(const std::string& message) {
     Log(message, LogLevel::ERROR);
-}
\ No newline at end of file
+}
@@ -5,19 +5,29 @@
 #ifndef FUSION_DETECTION_2_LOG_H
 #define FUSION_DETECTION_2_LOG_H
 
+#include <atomic>
 #include <iostream>
 #include <string>
 #include "options.h"
+
+// ordered by severity, messages below the log level are dropped
 enum class LogLevel {
-    INFO,
     DEBUG,
+    INFO,
     WARNING,
     ERROR
 };
 
+// Asynchronous logger: the messages are passed through a lock-free queue to a background thread,
+// which writes them in batches and flushes once per batch.
+// Each thread writes to the log file it opened with init, so the runs of a batch keep separate logs
 class Logger {
 public:
+    // Set the log level of the process from the options, once before the runs start
+    static void configure(const options_t& options);
+    // Open <output>/<prefix>.log for the messages of the calling thread
     static void init(const options_t& options) ;
+    // Close the log file of the calling thread, the background thread writes all pending messages and stops with the last open log
     static void close();
 
     static void Log(const std::string& message, LogLevel level = LogLevel::INFO);
@@ -28,7 +38,30 @@ public:
     static void Warning(const std::string& message);
     static void Error(const std::string& message);
 
+    // Check whether messages of a level are written, so that expensive messages are only built when needed
+    static bool enabled(LogLevel level) { return level >= level_.load(std::memory_order_relaxed); }
+    static void setLevel(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+
+    // Parse a level name (debug, info, warning, error)
+    static bool parseLevel(const std::string& name, LogLevel& level);
+
+private:
+    struct sink_t;
+
+    struct record_t {
+        record_t* next;
+        LogLevel level;
+        std::string message;
+        sink_t* sink;
+        bool close;         // close the sink after all its previous messages
+    };
+
+    static void push(record_t* record);
+    static void writeLoop();
+    static void shutdown();
 
-    static std::ofstream logFile;
+    static std::atomic<LogLevel> level_;
+    static std::atomic<record_t*> head_;    // most recent message, producers push with CAS
+    static thread_local sink_t* sink_;      // log file of the calling thread
 };
 #endif //FUSION_DETECTION_2_LOG_H
@@ -0,0 +1,164 @@
+#include "metrics.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <unistd.h>
+
+
+Metrics::Timer::Timer(Metrics& metrics, const std::string& name):
+    metrics_(metrics), index_(metrics.steps_.size()), running_(true), wall_start_(wall_time()), cpu_start_(cpu_time()),
+    child_cpu_start_(child_cpu_time()), rss_start_(current_rss_kb()) {
+    // The step is registered when it starts, so nested steps are listed after their parent
+    metrics_.steps_.emplace_back();
+    metrics_.steps_.back().name = name;
+}
+
+Metrics::Timer::~Timer() {
+    stop();
+}
+
+void Metrics::Timer::stop() {
+    if (!running_)
+        return;
+    running_ = false;
+    step_t& step = metrics_.steps_[index_];
+    step.wall_seconds = wall_time() - wall_start_;
+    step.cpu_seconds = cpu_time() - cpu_start_;
+    step.child_cpu_seconds = child_cpu_time() - child_cpu_start_;
+    step.rss_delta_kb = current_rss_kb() - rss_start_;
+}
+
+void Metrics::Timer::count(const std::string& key, uint64_t value) {
+    metrics_.steps_[index_].counts.emplace_back(key, value);
+}
+
+
+Metrics::Metrics(): wall_start_(wall_time()), cpu_start_(cpu_time()), child_cpu_start_(child_cpu_time()) {}
+
+void Metrics::record(const std::string& name, double wall_seconds, const std::vector<std::pair<std::string, uint64_t>>& counts) {
+    steps_.emplace_back();
+    steps_.back().name = name;
+    steps_.back().wall_seconds = wall_seconds;
+    steps_.back().counts = counts;
+}
+
+void Metrics::count(const std::string& key, uint64_t value) {
+    counts_.emplace_back(key, value);
+}
+
+
+double Metrics::wall_time() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double rusage_seconds(int who) {
+    struct rusage usage;
+    getrusage(who, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+double Metrics::cpu_time() {
+    return rusage_seconds(RUSAGE_SELF);
+}
+
+double Metrics::child_cpu_time() {
+    return rusage_seconds(RUSAGE_CHILDREN);
+}
+
+long Metrics::current_rss_kb() {
+    // The resident set size is only available from procfs, fall back to the peak elsewhere
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    if (statm >> pages >> resident)
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+    return peak_rss_kb();
+}
+
+long Metrics::peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+
+static void write_json_string(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                    out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+                else
+                    out << c;
+        }
+    }
+    out << '"';
+}
+
+static void write_json_counts(std::ostream& out, const std::vector<std::pair<std::string, uint64_t>>& counts) {
+    out << "{";
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (i > 0)
+            out << ", ";
+        write_json_string(out, counts[i].first);
+        out << ": " << counts[i].second;
+    }
+    out << "}";
+}
+
+void Metrics::write_json(std::ostream& out, const std::vector<std::pair<std::string, std::string>>& info) const {
+    out << std::fixed << std::setprecision(6);
+    out << "{\n";
+    for (const auto& entry : info) {
+        out << "  ";
+        write_json_string(out, entry.first);
+        out << ": ";
+        write_json_string(out, entry.second);
+        out << ",\n";
+    }
+    out << "  \"total\": {\"wall_seconds\": " << wall_time() - wall_start_
+        << ", \"cpu_seconds\": " << cpu_time() - cpu_start_
+        << ", \"child_cpu_seconds\": " << child_cpu_time() - child_cpu_start_
+        << ", \"peak_rss_kb\": " << peak_rss_kb()
+        << ", \"counts\": ";
+    write_json_counts(out, counts_);
+    out << "},\n";
+
+    out << "  \"steps\": [";
+    for (size_t i = 0; i < steps_.size(); ++i) {
+        const step_t& step = steps_[i];
+        out << (i > 0 ? ",\n" : "\n") << "    {\"name\": ";
+        write_json_string(out, step.name);
+        out << ", \"wall_seconds\": " << step.wall_seconds;
+        if (step.cpu_seconds >= 0)
+            out << ", \"cpu_seconds\": " << step.cpu_seconds;
+        if (step.child_cpu_seconds >= 0)
+            out << ", \"child_cpu_seconds\": " << step.child_cpu_seconds;
+        if (step.cpu_seconds >= 0)
+            out << ", \"rss_delta_kb\": " << step.rss_delta_kb;
+        out << ", \"counts\": ";
+        write_json_counts(out, step.counts);
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void Metrics::write_json(const std::string& filename, const std::vector<std::pair<std::string, std::string>>& info) const {
+    std::ofstream out(filename);
+    if (!out) {
+        throw std::runtime_error("failed to open metrics file: " + filename);
+    }
+    write_json(out, info);
+}
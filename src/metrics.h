@@ -0,0 +1,76 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Performance metrics of a run: wall time, CPU time, resident memory and item counts of each stage and sub-step,
+// written as JSON next to the fusion list so that regressions can be tracked per sample
+class Metrics {
+public:
+    struct step_t {
+        std::string name;               // "/" separated path of the step, e.g. "Stage3/bowtie2_align"
+        double wall_seconds = 0;
+        double cpu_seconds = -1;        // CPU time of this process, -1 if not measured
+        double child_cpu_seconds = -1;  // CPU time of finished child processes such as bowtie2, -1 if not measured
+        long rss_delta_kb = 0;          // change of the resident set size during the step
+        std::vector<std::pair<std::string, uint64_t>> counts;
+    };
+
+    // Measures the enclosing scope as a step, the step is recorded when the timer goes out of scope
+    class Timer {
+    public:
+        Timer(Metrics& metrics, const std::string& name);
+        ~Timer();
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+        // Set an item count of the step
+        void count(const std::string& key, uint64_t value);
+
+        // Finish the step before the end of the scope
+        void stop();
+
+    private:
+        Metrics& metrics_;
+        size_t index_;
+        bool running_;
+        double wall_start_;
+        double cpu_start_;
+        double child_cpu_start_;
+        long rss_start_;
+    };
+
+    Metrics();
+
+    // Record a step which was measured elsewhere, e.g. a filter evaluated inside the filter chain
+    void record(const std::string& name, double wall_seconds, const std::vector<std::pair<std::string, uint64_t>>& counts);
+
+    // Set a count of the whole run
+    void count(const std::string& key, uint64_t value);
+
+    const std::vector<step_t>& steps() const { return steps_; }
+
+    // Write the metrics as JSON, the totals cover the time since the construction of the metrics
+    void write_json(std::ostream& out, const std::vector<std::pair<std::string, std::string>>& info) const;
+    void write_json(const std::string& filename, const std::vector<std::pair<std::string, std::string>>& info) const;
+
+    // Current measurements of the process
+    static double wall_time();
+    static double cpu_time();
+    static double child_cpu_time();
+    static long current_rss_kb();
+    static long peak_rss_kb();
+
+private:
+    double wall_start_;
+    double cpu_start_;
+    double child_cpu_start_;
+    std::vector<step_t> steps_;     // in the order the steps were started
+    std::vector<std::pair<std::string, uint64_t>> counts_;
+};
+
+#endif //METRICS_H
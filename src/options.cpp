@@ -15,6 +15,7 @@
 
 #include "options.h"
 #include "common.h"
+#include "log.h"
 
 
 
@@ -112,6 +113,10 @@ options_t get_default_options() {
 
     options.max_pair_combination = 3;
     options.threads = 4;
+    options.parallel_samples = 2;
+    options.sort_memory = 2048;
+    options.realign_cache_size = 10240;
+    options.junction_window = 0;
     options.max_overlap_size = 8;
     options.max_gap_size = 2;
     options.min_edge_length = 20;
@@ -126,7 +131,11 @@ options_t get_default_options() {
     options.min_split_reads = 3;
     options.min_span_reads = 1;
     options.max_itd_length = 1000;
+    options.known_fusions = "./known_fusions.tsv";
+    options.log_level = "debug";
     options.min_itd_fraction = 0.5;
+    options.checkpoint = false;
+    options.resume = false;
 
     for (size_t i = 0; i < FILTERS.size(); ++i)
         if (i != FILTER_none)
@@ -194,6 +203,10 @@ void print_usage() {
               << wrap_help("-A","--edge-unaligned") << std::endl
               << wrap_help2("Maximum number of unaligned bases at the head or tail of a contig. "
                                                 "(Default: 50).") << std::endl
+              << wrap_help("-B","--sample-sheet") << std::endl
+              << wrap_help2("Batch mode: TSV file with one sample per line (prefix, alignment file, assembly, FASTQ 1, FASTQ 2). "
+                                                "The samples are processed with the shared GTF and known fusions, the options -i, -a, -1, -2 "
+                                                "and -p are taken from the sample sheet.") << std::endl
               << wrap_help("-c","--max_alignment_count") << std::endl
               << wrap_help2("Maximum number of alignments considered for each contig."
                                                 " Larger values may increase processing time (Default: 100).") << std::endl
@@ -210,8 +223,27 @@ void print_usage() {
               << wrap_help2("Minimum segment length requirement for fusion parts (Default: 35).") << std::endl
               << wrap_help("-I","--inclusion-fraction-weight") << std::endl
               << wrap_help2("Weight of the inclusion fraction in alignment score calculation (Default: 1).") << std::endl
+              << wrap_help("-j","--junction-window") << std::endl
+              << wrap_help2("Insert size of the read pairs. If set, the reads are realigned to windows of insert size plus "
+                                                "read length around the junctions of the candidate contigs instead of the whole contigs "
+                                                "(Default: 0, whole contigs).") << std::endl
+              << wrap_help("-J","--realign-cache") << std::endl
+              << wrap_help2("Directory of a cache of the bowtie2 indexes and realigned reads, keyed by the chosen contigs, "
+                                                "the FASTQ files and the bowtie2 parameters. A rerun with the same inputs skips bowtie2; "
+                                                "the directory can be shared by several runs (Default: no cache).") << std::endl
+              << wrap_help("-k","--known-fusions") << std::endl
+              << wrap_help2("Known fusions used to recover discarded candidates, either as TSV or as packed "
+                                                "database built with 'DenovoFusion compile-known-fusions' (Default: " + default_options.known_fusions + ").") << std::endl
+              << wrap_help("-K","--checkpoint") << std::endl
+              << wrap_help2("Write the results of Stage1 to Stage3 and the annotated candidates of Stage4 as binary checkpoints "
+                                                "to <output>/<prefix>_checkpoint. The checkpoints are keyed by the options of the stages and "
+                                                "the inputs, small inputs by their content and inputs over 16 MB by their path, size and "
+                                                "modification time.") << std::endl
               << wrap_help("-l","--max-overlap-size") << std::endl
               << wrap_help2("Maximum number of overlapping bases allowed in paired alignments (Default: 8).") << std::endl
+              << wrap_help("-L","--log-level") << std::endl
+              << wrap_help2("Minimum level of the messages written to the log file: debug, info, warning or error. "
+                                                "The per-record details are only written at debug level (Default: " + default_options.log_level + ").") << std::endl
               << wrap_help("-n","--max-pair-combination") << std::endl
               << wrap_help2("Maximum number of alignment combinations per contig. Larger values may "
                                                 "increase processing time (Default: 3).") << std::endl
@@ -223,6 +255,9 @@ void print_usage() {
               << wrap_help2("Minimum number of split reads required as support (Default: 3).") << std::endl
               << wrap_help("-q","--threads") << std::endl
               << wrap_help2("Number of threads to use (Default: 4).") << std::endl
+              << wrap_help("-R","--resume") << std::endl
+              << wrap_help2("Continue a previous run from its latest checkpoint which matches the inputs and options, the "
+                                                "covered stages are skipped. Implies -K.") << std::endl
               << wrap_help("-s","--min_score_total") << std::endl
               << wrap_help2("Minimum total score for combined alignments (Default: 95).") << std::endl
               << wrap_help("-S","--size-weight") << std::endl
@@ -231,6 +266,15 @@ void print_usage() {
               << wrap_help2("Gap threshold for candidate fusions on the same chromosome (Default: 200000).") << std::endl
               << wrap_help("-v","--coverage-differ") << std::endl
               << wrap_help2("Coverage ratio threshold between adjacent bases in breakpoint prediction (Default: 0.85).") << std::endl
+              << wrap_help("-w","--parallel-samples") << std::endl
+              << wrap_help2("Number of samples processed at the same time in batch mode, they share a pool of the "
+                                                "threads. Each sample in progress keeps its alignments and reads in memory (Default: " + std::to_string(default_options.parallel_samples) + ").") << std::endl
+              << wrap_help("-W","--realign-cache-size") << std::endl
+              << wrap_help2("Size limit in MB of the realignment cache, the least recently used entries are removed "
+                                                "beyond it (Default: " + std::to_string(default_options.realign_cache_size) + ").") << std::endl
+              << wrap_help("-y","--sort-memory") << std::endl
+              << wrap_help2("Memory in MB for sorting alignment files whose records are not grouped by query, e.g. "
+                                                "coordinate-sorted SAM files. Larger files are sorted in runs on disk (Default: " + std::to_string(default_options.sort_memory) + ").") << std::endl
               << wrap_help("-z","--size-ratio-threshold") << std::endl
               << wrap_help2("Proportion of fusion part 1 and part 2 must remain within an "
                                                 "acceptable range (Default: 0.1).") << std::endl
@@ -275,6 +319,16 @@ options_t option_parser(int argc, char **argv) {
     {"short-segment-threshold", required_argument, nullptr, 'G'}, // --short-segment-threshold (short option -G)
     {"min-split-reads", required_argument, nullptr, 'P'},  // --min-split-reads (short option -P)
     {"min-span-reads", required_argument, nullptr, 'N'},   // --min-span-reads (short option -N)
+    {"known-fusions", required_argument, nullptr, 'k'},   // --known-fusions (short option -k)
+    {"log-level", required_argument, nullptr, 'L'},       // --log-level (short option -L)
+    {"sample-sheet", required_argument, nullptr, 'B'},    // --sample-sheet (short option -B)
+    {"parallel-samples", required_argument, nullptr, 'w'}, // --parallel-samples (short option -w)
+    {"sort-memory", required_argument, nullptr, 'y'},     // --sort-memory (short option -y)
+    {"junction-window", required_argument, nullptr, 'j'}, // --junction-window (short option -j)
+    {"realign-cache", required_argument, nullptr, 'J'},   // --realign-cache (short option -J)
+    {"realign-cache-size", required_argument, nullptr, 'W'}, // --realign-cache-size (short option -W)
+    {"checkpoint", no_argument, nullptr, 'K'},            // --checkpoint (short option -K)
+    {"resume", no_argument, nullptr, 'R'},                // --resume (short option -R)
     {"help", no_argument, nullptr, 'h'},                   // --help (short option -h)
     {nullptr, 0, nullptr, 0} // Sentinel value
 };
@@ -286,7 +340,7 @@ options_t option_parser(int argc, char **argv) {
     int c;
     std::string junction_suffix(".junction");
     std::unordered_map<char,unsigned int> duplicate_arguments;
-    const std::string valid_arguments = "1:2:c:x:q:d:g:r:G:o:w:l:O:t:p:a:b:k:s:i:v:f:E:S:m:L:H:D:R:A:M:K:V:F:U:Q:e:T:C:l:z:Z:uXIh";
+    const std::string valid_arguments = "1:2:c:x:q:d:g:r:G:o:w:l:O:t:p:a:b:k:s:i:v:f:E:S:m:L:B:P:N:n:H:D:A:M:V:F:U:Q:e:T:C:l:y:j:J:W:z:Z:uXIKRh";
     // Use getopt_long to handle both short and long options
     while ((c = getopt_long(argc, argv, valid_arguments.c_str(), long_options, nullptr)) != -1) {
         // Throw error if the same argument is specified more than once
@@ -390,6 +444,42 @@ options_t option_parser(int argc, char **argv) {
             case 'N':
                 crash(!validate_int(optarg, options.min_span_reads, 1,50), "invalid argument to -" + ((char) c));
                 break;
+            case 'k':
+                options.known_fusions = optarg;
+                crash(access(options.known_fusions.c_str(), R_OK), "file not found/readable: " + options.known_fusions);
+                break;
+            case 'L': {
+                LogLevel level;
+                crash(!Logger::parseLevel(optarg, level), "invalid argument to -" + ((char) c) + ": " + optarg);
+                options.log_level = optarg;
+                break;
+            }
+            case 'B':
+                options.sample_sheet = optarg;
+                crash(access(options.sample_sheet.c_str(), R_OK), "file not found/readable: " + options.sample_sheet);
+                break;
+            case 'w':
+                crash(!validate_int(optarg, options.parallel_samples, 1, 64), "invalid argument to -" + ((char) c));
+                break;
+            case 'y':
+                crash(!validate_int(optarg, options.sort_memory, 16), "invalid argument to -" + ((char) c));
+                break;
+            case 'j':
+                crash(!validate_int(optarg, options.junction_window, 0), "invalid argument to -" + ((char) c));
+                break;
+            case 'J':
+                options.realign_cache = optarg;
+                break;
+            case 'W':
+                crash(!validate_int(optarg, options.realign_cache_size, 1), "invalid argument to -" + ((char) c));
+                break;
+            case 'K':
+                options.checkpoint = true;
+                break;
+            case 'R':
+                options.checkpoint = true;
+                options.resume = true;
+                break;
             case 'h':
                 print_usage();
                 exit(0);
@@ -410,14 +500,20 @@ options_t option_parser(int argc, char **argv) {
         crash(true, "no arguments given");
     }
     crash(options.input_type.empty(), "missing mandatory option -m");
-    crash(options.input_file.empty(), "missing mandatory option -i");
-    crash(options.input_assembly.empty(), "missing mandatory option -a");
     crash(options.output.empty(), "missing mandatory option -o");
     crash(options.gtf_path.empty(), "missing mandatory option -g");
-    crash(options.input_fastq1.empty(), "missing mandatory option -1");
-    crash(options.input_fastq2.empty(), "missing mandatory option -2");
-    crash(options.prefix.empty(), "missing mandatory option -p");
     crash(options.read_length == 0, "missing mandatory option -r");
+    // In batch mode the inputs and the prefix of each sample are taken from the sample sheet
+    if (options.sample_sheet.empty()) {
+        crash(options.input_file.empty(), "missing mandatory option -i");
+        crash(options.input_assembly.empty(), "missing mandatory option -a");
+        crash(options.input_fastq1.empty(), "missing mandatory option -1");
+        crash(options.input_fastq2.empty(), "missing mandatory option -2");
+        crash(options.prefix.empty(), "missing mandatory option -p");
+    } else {
+        crash(!options.input_file.empty() || !options.input_assembly.empty() || !options.input_fastq1.empty() || !options.input_fastq2.empty() || !options.prefix.empty(),
+              "options -i, -a, -1, -2 and -p are taken from the sample sheet (-B)");
+    }
 
 
     return options;
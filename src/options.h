@@ -25,6 +25,10 @@ struct options_t {
     std::string output;
     std::string gtf_path;
     std::string prefix;
+    std::string known_fusions;
+    std::string log_level;
+    std::string sample_sheet;
+    std::string realign_cache;  // directory of the realignment cache, empty for none
     std::vector<std::string> input_fastq1;
     std::vector<std::string> input_fastq2;
 
@@ -36,9 +40,13 @@ struct options_t {
 
     int max_pair_combination;
     int threads;
+    int parallel_samples;
+    int sort_memory;            // MB
+    int realign_cache_size;     // MB
     int max_overlap_size;
     int max_gap_size;
     int read_length;
+    int junction_window;        // insert size of the reads, 0 to realign to the whole contigs
     int min_edge_length;
     float size_ratio_threshold;
     int edge_unaligned;
@@ -53,6 +61,9 @@ struct options_t {
     int max_itd_length;
     float min_itd_fraction;
 
+    bool checkpoint;        // write the results of the stages to <output>/<prefix>_checkpoint
+    bool resume;            // skip the stages which are covered by a valid checkpoint
+
 
 
     std::unordered_map<std::string,bool> filters;
@@ -61,6 +72,8 @@ struct options_t {
 
     options_t option_parser(int argc, char** argv);
 
+    options_t get_default_options();
+
     bool output_directory_exists(const std::string& output_file);
 
     std::string wrap_help(const std::string& option, const std::string& text, const unsigned short int max_line_width = 80);
@@ -68,6 +81,7 @@ struct options_t {
     std::string wrap_help2(const std::string& text, const unsigned short int max_line_width = 80);
 
 
+    bool validate_int(const char* optarg, int& value, const int min_value = INT_MIN, const int max_value = INT_MAX);
     bool validate_int(const char* optarg, unsigned int& value, const unsigned int min_value = 0, const unsigned int max_value = INT_MAX);
     bool validate_float(const char* optarg, float& value, const float min_value = FLT_MIN, const float max_value = FLT_MAX);
 
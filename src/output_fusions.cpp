@@ -10,6 +10,93 @@
 
 
 
+std::string get_filter_status(const result_t& result) {
+    if (result.recovered)
+        return "recovered";
+    for (filter_t filter = 0; filter < FILTERS.size(); ++filter)
+        if (result.filters & filter_bit(filter))
+            return "discarded_" + FILTERS[filter];
+    return "kept";
+}
+
+
+direction_t parse_direction(const std::string& direction) {
+    if (direction == "UPSTREAM")
+        return direction_t::UPSTREAM;
+    if (direction == "DOWNSTREAM")
+        return direction_t::DOWNSTREAM;
+    if (direction == "UNDEFINED")
+        return direction_t::UNDEFINED;
+    return direction_t::NONE;
+}
+
+std::string direction_to_string(direction_t direction) {
+    switch (direction) {
+        case direction_t::UPSTREAM: return "UPSTREAM";
+        case direction_t::DOWNSTREAM: return "DOWNSTREAM";
+        case direction_t::UNDEFINED: return "UNDEFINED";
+        default: return "";
+    }
+}
+
+
+region_t parse_region(const std::string& region) {
+    region_t result;
+    size_t at = region.find('@');
+    std::string type = region.substr(0, at);
+    if (type == "exon")
+        result.type = region_type_t::EXON;
+    else if (type == "intron")
+        result.type = region_type_t::INTRON;
+    else if (type == "upstream")
+        result.type = region_type_t::UPSTREAM;
+    else if (type == "downstream")
+        result.type = region_type_t::DOWNSTREAM;
+    else if (type == "unknown")
+        result.type = region_type_t::UNKNOWN;
+    if (at != std::string::npos)
+        str_to_int(region.c_str() + at + 1, result.exon_number);
+    return result;
+}
+
+std::string region_to_string(const region_t& region) {
+    std::string type;
+    switch (region.type) {
+        case region_type_t::NONE: return "";
+        case region_type_t::UNKNOWN: type = "unknown"; break;
+        case region_type_t::EXON: type = "exon"; break;
+        case region_type_t::INTRON: type = "intron"; break;
+        case region_type_t::UPSTREAM: type = "upstream"; break;
+        case region_type_t::DOWNSTREAM: type = "downstream"; break;
+    }
+    if (region.exon_number == NO_EXON_NUMBER)
+        return type;
+    return type + "@" + std::to_string(region.exon_number);
+}
+
+
+void writeResultFields(std::ostream& out, const result_t& result, char separator) {
+    out << SYMBOLS.str(result.contig) << separator
+        << SYMBOLS.str(result.gene1) << separator
+        << SYMBOLS.str(result.gene2) << separator
+        << SYMBOLS.str(result.gene_id1) << separator
+        << SYMBOLS.str(result.gene_id2) << separator
+        << result.splitReadsCount << separator
+        << result.spanReadsCount << separator
+        << SYMBOLS.str(result.chromosome1) << separator
+        << SYMBOLS.str(result.chromosome2) << separator
+        << direction_to_string(result.direction1) << separator
+        << direction_to_string(result.direction2) << separator
+        << result.tstart1 << separator
+        << result.tend1 << separator
+        << result.tstart2 << separator
+        << result.tend2 << separator
+        << region_to_string(result.regiontype1) << separator
+        << region_to_string(result.regiontype2) << separator
+        << get_filter_status(result);
+}
+
+
 void processAnnotations(const std::vector<annotation_t>& annotations, std::vector<result_t>& results) {
 
     for (size_t i = 0; i < annotations.size(); i += 2) {
@@ -18,24 +105,23 @@ void processAnnotations(const std::vector<annotation_t>& annotations, std::vecto
         const auto& ann2 = annotations[i+1];
 
         if (ann1.contigName == ann2.contigName) {  // 同一个 contig
-            result.contig = ann1.contigName;
-            result.gene1 = ann1.geneName;
-            result.gene2 = ann2.geneName;
-            result.gene_id1 = ann1.geneId.empty() ? "" : ann1.geneId;
-            result.gene_id2 = ann2.geneId.empty() ? "" : ann2.geneId;
+            result.contig = SYMBOLS.intern(ann1.contigName);
+            result.gene1 = SYMBOLS.intern(ann1.geneName);
+            result.gene2 = SYMBOLS.intern(ann2.geneName);
+            result.gene_id1 = SYMBOLS.intern(ann1.geneId);
+            result.gene_id2 = SYMBOLS.intern(ann2.geneId);
             result.tstart1 = ann1.start;
             result.tend1 = ann1.end;
             result.tstart2 = ann2.start;
             result.tend2 = ann2.end;
-            result.chromosome1 = ann1.chromosome;
-            result.chromosome2 = ann2.chromosome;
-            result.tstrand1 = ann1.strand;
-            result.tstrand2 = ann2.strand;
-            result.direction1 = ann1.direction;
-            result.direction2 = ann2.direction;
-            result.regiontype1 = ann1.regionType;
-            result.regiontype2 = ann2.regionType;
-            result.filter_status = "unfiltered";
+            result.chromosome1 = SYMBOLS.intern(ann1.chromosome);
+            result.chromosome2 = SYMBOLS.intern(ann2.chromosome);
+            result.tstrand1 = SYMBOLS.intern(ann1.strand);
+            result.tstrand2 = SYMBOLS.intern(ann2.strand);
+            result.direction1 = parse_direction(ann1.direction);
+            result.direction2 = parse_direction(ann2.direction);
+            result.regiontype1 = parse_region(ann1.regionType);
+            result.regiontype2 = parse_region(ann2.regionType);
             results.push_back(result);
         }
     }
@@ -49,11 +135,14 @@ void integrateReadCounts(
         const std::unordered_map<std::string, int>& spanReadsCount) {
 
     for (auto& result : results) {
-        if (splitReadsCount.find(result.contig) != splitReadsCount.end()) {
-            result.splitReadsCount = splitReadsCount.at(result.contig);
+        const std::string& contig = SYMBOLS.str(result.contig);
+        auto split = splitReadsCount.find(contig);
+        if (split != splitReadsCount.end()) {
+            result.splitReadsCount = split->second;
         }
-        if (spanReadsCount.find(result.contig) != spanReadsCount.end()) {
-            result.spanReadsCount = spanReadsCount.at(result.contig);
+        auto span = spanReadsCount.find(contig);
+        if (span != spanReadsCount.end()) {
+            result.spanReadsCount = span->second;
         }
     }
 }
@@ -62,10 +151,11 @@ void integrateReadCounts(
 
 // Function to filter out results where gene1 or gene2 is empty
 void removeEmptyGenes(std::vector<result_t>& results) {
+    const symbol_t blank = SYMBOLS.intern(" ");
     results.erase(std::remove_if(results.begin(), results.end(),
-                                 [](const result_t& result) {
-                                     return result.gene_id1.empty() || result.gene_id2.empty() ||
-                                           result.gene_id1 == " " || result.gene_id2 == " ";
+                                 [blank](const result_t& result) {
+                                     return result.gene_id1 == SYMBOL_EMPTY || result.gene_id2 == SYMBOL_EMPTY ||
+                                           result.gene_id1 == blank || result.gene_id2 == blank;
                                 }),
                   results.end());
 }
@@ -84,24 +174,8 @@ void writeToCSV(const std::vector<result_t>& final_results, const std::string& f
 
     // Write the data
     for (const auto& result : final_results) {
-        outFile << result.contig << ","
-                << result.gene1 << ","
-                << result.gene2 << ","
-                << result.gene_id1 << ","
-                << result.gene_id2 << ","
-                << result.splitReadsCount << ","
-                << result.spanReadsCount << ","
-                << result.chromosome1 << ","
-                << result.chromosome2 << ","
-                << result.direction1 << ","
-                << result.direction2 << ","
-                << result.tstart1 << ","
-                << result.tend1 << ","
-                << result.tstart2 << ","
-                << result.tend2 << ","
-                << result.regiontype1 << ","
-                << result.regiontype2<< ","
-                << result.filter_status <<  "\n";
+        writeResultFields(outFile, result, ',');
+        outFile << "\n";
     }
 
     // Close the file
@@ -121,24 +195,8 @@ void writeToTSV(const std::vector<result_t>& final_results, const std::string& f
 
     //
     for (const auto& result : final_results) {
-        outFile << result.contig << "\t"
-                << result.gene1 << "\t"
-                << result.gene2 << "\t"
-                << result.gene_id1 << "\t"
-                << result.gene_id2 << "\t"
-                << result.splitReadsCount << "\t"
-                << result.spanReadsCount << "\t"
-                << result.chromosome1 << "\t"
-                << result.chromosome2 << "\t"
-                << result.direction1 << "\t"
-                << result.direction2 << "\t"
-                << result.tstart1 << "\t"
-                << result.tend1 << "\t"
-                << result.tstart2 << "\t"
-                << result.tend2 << "\t"
-                << result.regiontype1 << "\t"
-                << result.regiontype2 << "\t"
-                << result.filter_status << "\n";
+        writeResultFields(outFile, result, '\t');
+        outFile << "\n";
     }
 
     outFile.close();
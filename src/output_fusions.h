@@ -19,33 +19,73 @@
 #include "common.h"
 #include "annotation.h"
 #include "coverage.h"
+#include "symbol_table.h"
 
 
+// Direction of a fusion partner relative to the breakpoint
+enum class direction_t : unsigned char {
+    NONE,
+    UPSTREAM,
+    DOWNSTREAM,
+    UNDEFINED
+};
+
+// Region of the genome a breakpoint lies in, written as "<type>@<exon number>"
+enum class region_type_t : unsigned char {
+    NONE,
+    UNKNOWN,
+    EXON,
+    INTRON,
+    UPSTREAM,
+    DOWNSTREAM
+};
+
+const int NO_EXON_NUMBER = INT_MIN; // region without "@<exon number>", e.g. plain "unknown"
+
+struct region_t {
+    region_type_t type = region_type_t::NONE;
+    int exon_number = NO_EXON_NUMBER;
+};
+
+// Fusion candidate; names are interned in SYMBOLS and only turned into strings by the writers
 struct result_t {
-    std::string contig;
-    std::string gene1;
-    std::string gene2;
-    std::string gene_id1;
-    std::string gene_id2;
+    symbol_t contig = SYMBOL_EMPTY;
+    symbol_t gene1 = SYMBOL_EMPTY;
+    symbol_t gene2 = SYMBOL_EMPTY;
+    symbol_t gene_id1 = SYMBOL_EMPTY;
+    symbol_t gene_id2 = SYMBOL_EMPTY;
     unsigned int tstart1;
     unsigned int tend1;
     unsigned int tstart2;
     unsigned int tend2;
-    std::string tstrand1;
-    std::string tstrand2;
-    std::string chromosome1;
-    std::string chromosome2;
-    unsigned int splitReadsCount;
-    unsigned int spanReadsCount;
-    float coverage;
-    std::string direction1;
-    std::string direction2;
-    std::string filter_status;
-    std::string regiontype1;
-    std::string regiontype2;
+    symbol_t tstrand1 = SYMBOL_EMPTY;
+    symbol_t tstrand2 = SYMBOL_EMPTY;
+    symbol_t chromosome1 = SYMBOL_EMPTY;
+    symbol_t chromosome2 = SYMBOL_EMPTY;
+    unsigned int splitReadsCount = 0;
+    unsigned int spanReadsCount = 0;
+    float coverage = 0;
+    direction_t direction1 = direction_t::NONE;
+    direction_t direction2 = direction_t::NONE;
+    filter_mask_t filters = 0; // bit of the filter that discarded the result, 0 if kept
+    bool recovered = false;    // discarded, but recovered as known fusion
+    region_t regiontype1;
+    region_t regiontype2;
 
 };
 
+// Filter status as written to the output, e.g. "kept", "recovered" or "discarded_long_gap"
+std::string get_filter_status(const result_t& result);
+
+direction_t parse_direction(const std::string& direction);
+std::string direction_to_string(direction_t direction);
+
+region_t parse_region(const std::string& region);
+std::string region_to_string(const region_t& region);
+
+// Write the columns of a result, separated by the given character, without line break
+void writeResultFields(std::ostream& out, const result_t& result, char separator);
+
 
 void processAnnotations(const std::vector<annotation_t>& annotations, std::vector<result_t>& results);
 
@@ -62,17 +62,12 @@ int OverlapResultCls::getContigEnd() const {
 }
 
 
-std::vector<std::pair<alignment_t, alignment_t>> pairAlignments(const std::vector<alignment_t>& alignments) {
-    std::map<std::string, std::vector<alignment_t>> groupedAlignments;
-    for (const auto& alignment : alignments) {
-        groupedAlignments[alignment.query].push_back(alignment);
-    }
-
+// The pairs of Stage2 refer to the chosen alignments, ordered by query name
+std::vector<std::pair<alignment_t, alignment_t>> pairAlignments(const std::vector<alignment_t>& alignments, const std::vector<alignment_pair_t>& pairs) {
     std::vector<std::pair<alignment_t, alignment_t>> pairedAlignments;
-    for (const auto& entry : groupedAlignments) {
-        if (entry.second.size() == 2) {
-            pairedAlignments.push_back(std::make_pair(entry.second[0], entry.second[1]));
-        }
+    pairedAlignments.reserve(pairs.size());
+    for (const auto& pair : pairs) {
+        pairedAlignments.emplace_back(alignments[pair.first], alignments[pair.second]);
     }
     return pairedAlignments;
 }
@@ -42,7 +42,7 @@ public:
 int extractNumber(const std::string& query);
 std::string baseQueryName(const std::string& query);
 
-std::vector<std::pair<alignment_t, alignment_t>> pairAlignments(const std::vector<alignment_t>& alignments);
+std::vector<std::pair<alignment_t, alignment_t>> pairAlignments(const std::vector<alignment_t>& alignments, const std::vector<alignment_pair_t>& pairs);
 std::vector<OverlapResultCls> processAndMergeAlignments(
     const std::vector<std::pair<alignment_t, alignment_t>>& pairedAlignments,
     const std::unordered_map<std::string, std::string>& mergedsequences);
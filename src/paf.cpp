@@ -4,30 +4,43 @@
 #include <iostream>
 #include <stdexcept>
 
-// Function to parse a PAF file
-void paf_parse(const std::string& filename, std::vector<paf_t>& alignments) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+PafFileCls::PafFileCls(const std::string& filename) : file_(filename) {
+    if (!file_.is_open()) {
         throw std::runtime_error("无法打开文件: " + filename);
     }
+}
 
-    alignments.clear();  // clear the vector and fill in a new vector
+bool PafFileCls::next(paf_t& alignment) {
     std::string line;
 
-    while (getline(file, line)) {
-        if (line.empty() || line[0] == '#') {
-            continue; // discard empty lines and comments
+    while (getline(file_, line)) {
+        if (paf_record(line, alignment)) {
+            return true;
         }
+    }
+    return false;
+}
 
-        paf_t alignment;
-        parse_line(line, alignment);
-        validate_entry(alignment);
-        if (alignment.optional_fields.count("tp") > 0 && alignment.optional_fields["tp"] == "A:P") {
-            alignments.push_back(alignment);  // store alignment in the container only if it's primary
-        }
+bool paf_record(const std::string& line, paf_t& alignment) {
+    if (line.empty() || line[0] == '#') {
+        return false; // discard empty lines and comments
     }
 
-    file.close();
+    alignment = paf_t();
+    parse_line(line, alignment);
+    validate_entry(alignment);
+    return alignment.optional_fields.count("tp") > 0 && alignment.optional_fields["tp"] == "A:P";  // only primary alignments
+}
+
+// Function to parse a PAF file
+void paf_parse(const std::string& filename, std::vector<paf_t>& alignments) {
+    PafFileCls file(filename);
+
+    alignments.clear();  // clear the vector and fill in a new vector
+    paf_t alignment;
+    while (file.next(alignment)) {
+        alignments.push_back(alignment);
+    }
 }
 
 
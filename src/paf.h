@@ -6,6 +6,7 @@
 #ifndef PAF_H
 #define PAF_H
 
+#include <fstream>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -28,9 +29,23 @@ struct paf_t {
     std::string cigar;
 };
 
+// Reader of the primary alignments of a PAF file one record at a time
+class PafFileCls {
+public:
+    explicit PafFileCls(const std::string& filename);
+
+    bool next(paf_t& alignment);
+
+private:
+    std::ifstream file_;
+};
+
 // Function to parse a PAF file
 void paf_parse(const std::string& filename, std::vector<paf_t>& alignments);
 
+// Parse a line of a PAF file, false for comments and alignments which are not primary
+bool paf_record(const std::string& line, paf_t& alignment);
+
 void parse_line(const std::string& line, paf_t& alignment);
 
 void validate_entry(const paf_t& alignment);
@@ -0,0 +1,933 @@
+#include "pipeline.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <thread>
+
+#include "alignment_sort.h"
+#include "alignments_chosen.h"
+#include "annotation.h"
+#include "bowtie2.h"
+#include "breakpoint.h"
+#include "candidate_group.h"
+#include "checkpoint.h"
+#include "contig_pair_index.h"
+#include "coverage.h"
+#include "fasta.h"
+#include "filter_chain.h"
+#include "filter_homologs.h"
+#include "log.h"
+#include "realign_cache.h"
+#include "recover_known_fusion.h"
+#include "support_writing.h"
+#include "symbol_table.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+Pipeline::Pipeline(const options_t& options, const InputAdapter& adapter, std::ostream& out): options_(options), adapter_(adapter), out_(out) {}
+
+bool Pipeline::run() {
+
+    // Stage0: general settings for the programm, initialize log file, clear the existing log file, set a time log
+    time_t start_time;
+    time(&start_time);
+
+    Logger::init(options_);
+    out_ << get_time_string() << " Program DenovoFusion start" << std::endl;
+    Logger::Info(get_time_string() + " Program DenovoFusion start");
+
+    out_ << get_time_string() << " Launching fusion gene analysing program version " << DENOVOFUSION_VERSION << "\n" << std::flush;
+    Logger::Info(get_time_string() + " DenovoFusion version = " + DENOVOFUSION_VERSION);
+
+    if (options_.checkpoint) {
+        prepare_checkpoints();
+    }
+
+    bool success = run_stage(1, "Determine representive alignment for each contig", &Pipeline::choose_alignments) &&
+                   run_stage(2, "Grouping the alignments", &Pipeline::classify_candidates) &&
+                   run_stage(3, "Start realigning reads to contigs with using bowtie2", &Pipeline::realign_reads) &&
+                   run_stage(4, "Annotation of the gene, filtering the candidates and output the remain results", &Pipeline::filter_fusions) &&
+                   run_stage(5, "Calculation of the coverage and  prediction of breakpoints", &Pipeline::predict_breakpoints);
+    if (!success) {
+        Logger::close();
+        return false;
+    }
+
+    // Print resource usage stats end exit
+    time_t end_time;
+    time(&end_time);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    #ifdef __APPLE__
+    #define RU_MAXRSS_UNIT 1024.0*1024*1024
+    #else
+    #define RU_MAXRSS_UNIT 1024.0*1024
+    #endif
+
+    out_ << get_time_string() << " Done "
+         << "(elapsed time=" << get_hhmmss_string(difftime(end_time, start_time)) << ", "
+         << "CPU time=" << get_hhmmss_string(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) << ", "
+         << "peak memory=" << std::setprecision(3) << (usage.ru_maxrss/(RU_MAXRSS_UNIT)) << "gb)" << std::endl;
+
+    // Write the metrics next to the fusion list
+    metrics_.count("alignments", input_alignments());
+    metrics_.count("fusions", final_results_.size());
+    metrics_.count("discarded_fusions", discarded_results_.size());
+    std::string metrics_file = options_.output + "/" + options_.prefix + ".metrics.json";
+    metrics_.write_json(metrics_file, {{"version", DENOVOFUSION_VERSION}, {"prefix", options_.prefix}, {"input_type", options_.input_type},
+                                       {"input_file", options_.input_file}});
+    out_ << get_time_string() << " Write metrics into file:" << " '" << metrics_file << "' " << std::endl;
+
+    // Record before program close
+    Logger::Info(get_time_string() + " The program ends");
+
+    // Close log file
+    Logger::close();
+    return true;
+}
+
+bool Pipeline::run_stage(int number, const std::string& description, stage_t stage) {
+    const std::string name = "Stage" + std::to_string(number);
+    // The checkpoint of Stage4 is taken within the stage, before the filters
+    if (number <= std::min(resumed_stage_, 3)) {
+        out_ << get_time_string() << " " << name << ": skipped, the results are loaded from the checkpoint " << std::endl;
+        Logger::Info(get_time_string() + " " + name + ": skipped, the results are loaded from the checkpoint ");
+        return true;
+    }
+    out_ << get_time_string() << " " << name << ": " << description << " " << std::endl;
+    Logger::Info(get_time_string() + " " + name + ": " + description + " ");
+
+    size_t index = metrics_.steps().size();
+    bool success;
+    {
+        Metrics::Timer timer(metrics_, name);
+        success = (this->*stage)();
+    }
+
+    Logger::Info(get_time_string() + " " + name + " finished (elapsed time=" + get_hhmmss_string(metrics_.steps()[index].wall_seconds) + ")");
+
+    if (success && options_.checkpoint && number <= 3) {
+        save_checkpoint(number);
+    }
+    return success;
+}
+
+
+void Pipeline::prepare_checkpoints() {
+    {
+        Metrics::Timer timer(metrics_, "checkpoint/keys");
+
+        // Each key continues the checksum of the stage before, so it covers all inputs and options up to its stage
+        Checksum key;
+        key.update(DENOVOFUSION_VERSION);
+        key.update(options_.input_type);
+        update_file_key(key, options_.input_file);
+        update_file_key(key, options_.input_assembly);
+        key.update(options_.max_alignment_count);
+        key.update(options_.min_identity_fract);
+        key.update(options_.min_score_total);
+        key.update(options_.min_score_each);
+        key.update(options_.max_pair_combination);
+        key.update(options_.inclusion_fraction_weight);
+        key.update(options_.overlap_fraction_weight);
+        key.update(options_.size_weight);
+        key.update(options_.edge_unaligned);
+        checkpoint_keys_[1] = key.value();
+
+        key.update(options_.max_overlap_size);
+        key.update(options_.max_gap_size);
+        checkpoint_keys_[2] = key.value();
+
+        if (realignment_.empty()) {
+            for (const auto& fastq : options_.input_fastq1) {
+                update_file_key(key, fastq);
+            }
+            for (const auto& fastq : options_.input_fastq2) {
+                update_file_key(key, fastq);
+            }
+        } else {
+            update_file_key(key, realignment_);
+        }
+        key.update(options_.junction_window);
+        key.update(options_.read_length);
+        key.update(options_.min_edge_length);
+        checkpoint_keys_[3] = key.value();
+
+        // The candidates are annotated, but not filtered yet, so the filter options are not part of the key
+        update_file_key(key, options_.gtf_path);
+        checkpoint_keys_[4] = key.value();
+    }
+
+    std::string directory = options_.output + "/" + options_.prefix + "_checkpoint";
+    mkdir(directory.c_str(), 0755);
+
+    // Continue from the latest valid checkpoint
+    if (options_.resume) {
+        Metrics::Timer timer(metrics_, "checkpoint/load");
+        for (int stage = 4; stage >= 1 && resumed_stage_ == 0; --stage) {
+            if (load_checkpoint(stage)) {
+                resumed_stage_ = stage;
+            } else {
+                clear_results();
+            }
+        }
+        timer.count("stage", resumed_stage_);
+        if (resumed_stage_ > 0) {
+            out_ << get_time_string() << " Resuming from the checkpoint of Stage" << resumed_stage_ << " '" << checkpoint_file(resumed_stage_) << "' " << std::endl;
+            Logger::Info(get_time_string() + " Resuming from the checkpoint of Stage" + std::to_string(resumed_stage_) + " '" + checkpoint_file(resumed_stage_) + "' ");
+        } else {
+            out_ << get_time_string() << " No checkpoint matches the inputs and options, running all stages " << std::endl;
+            Logger::Info(get_time_string() + " No checkpoint matches the inputs and options, running all stages ");
+        }
+    }
+
+    // Stage2 reads the sequences of the candidate contigs from the assembly
+    if (resumed_stage_ == 1) {
+        fasta_.open(options_.input_assembly);
+    }
+
+    // bowtie2 realigns the reads to the chosen contigs written in Stage2
+    if (resumed_stage_ == 2) {
+        outputMergedSequences(merged_sequences_, options_);
+    }
+}
+
+std::string Pipeline::checkpoint_file(int stage) const {
+    return options_.output + "/" + options_.prefix + "_checkpoint/Stage" + std::to_string(stage) + ".ckpt";
+}
+
+void Pipeline::save_checkpoint(int stage) {
+    const std::string name = "Stage" + std::to_string(stage);
+    Metrics::Timer timer(metrics_, name + "/checkpoint");
+
+    CheckpointWriter writer(checkpoint_file(stage), name, checkpoint_keys_[stage]);
+    // The pairs of Stage2 refer to the chosen alignments
+    if (stage <= 2) {
+        writer.write(chosen_alignments_);
+    }
+    writer.write(query_coordinates_);
+    if (stage == 2) {
+        writer.write(overlaps_same_strand_);
+        writer.write(gaps_same_strand_);
+        writer.write(fragments_);
+        writer.write(merged_sequences_);
+    }
+    if (stage >= 3) {
+        writer.write(sam_entries_);
+        writer.write(paired_alignments_);
+        writer.write(overlap_results_);
+        writer.write(split_reads_);
+        writer.write(span_reads_);
+    }
+    if (stage == 3) {
+        writer.write(split_reads_count_);
+        writer.write(span_reads_count_);
+        writer.write(final_coordinations_);
+    }
+    if (stage == 4) {
+        writer.write(final_results_);
+    }
+
+    // A failed checkpoint only costs the time of the stage when resuming
+    if (!writer.commit()) {
+        out_ << get_time_string() << " Warning: failed to write the checkpoint '" << checkpoint_file(stage) << "' " << std::endl;
+        Logger::Warning(get_time_string() + " Failed to write the checkpoint '" + checkpoint_file(stage) + "' ");
+    }
+}
+
+bool Pipeline::load_checkpoint(int stage) {
+    CheckpointReader reader(checkpoint_file(stage), "Stage" + std::to_string(stage), checkpoint_keys_[stage]);
+    if (!reader.valid()) {
+        return false;
+    }
+    if (!read_checkpoint(reader, stage)) {
+        Logger::Warning(get_time_string() + " Ignoring the damaged checkpoint '" + checkpoint_file(stage) + "' ");
+        return false;
+    }
+    return true;
+}
+
+bool Pipeline::load_candidates(const std::string& checkpoint_file) {
+    CheckpointReader reader(checkpoint_file, "Stage4");
+    if (reader.valid() && read_checkpoint(reader, 4)) {
+        return true;
+    }
+    clear_results();
+    return false;
+}
+
+// Read the results in the order save_checkpoint writes them
+bool Pipeline::read_checkpoint(CheckpointReader& reader, int stage) {
+    bool success = true;
+    if (stage <= 2) {
+        success = success && reader.read(chosen_alignments_);
+    }
+    success = success && reader.read(query_coordinates_);
+    if (stage == 2) {
+        success = success && reader.read(overlaps_same_strand_) && reader.read(gaps_same_strand_) &&
+                  reader.read(fragments_) && reader.read(merged_sequences_);
+    }
+    if (stage >= 3) {
+        success = success && reader.read(sam_entries_) && reader.read(paired_alignments_) && reader.read(overlap_results_) &&
+                  reader.read(split_reads_) && reader.read(span_reads_);
+    }
+    if (stage == 3) {
+        success = success && reader.read(split_reads_count_) && reader.read(span_reads_count_) && reader.read(final_coordinations_);
+    }
+    if (stage == 4) {
+        success = success && reader.read(final_results_);
+    }
+    return success && reader.finish();
+}
+
+void Pipeline::clear_results() {
+    query_coordinates_.clear();
+    chosen_alignments_.clear();
+    overlaps_same_strand_.clear();
+    gaps_same_strand_.clear();
+    fragments_.clear();
+    merged_sequences_.clear();
+    sam_entries_.clear();
+    paired_alignments_.clear();
+    overlap_results_.clear();
+    split_reads_count_.clear();
+    span_reads_count_.clear();
+    split_reads_.clear();
+    span_reads_.clear();
+    final_coordinations_.clear();
+    final_results_.clear();
+}
+
+
+// Queries read and scored together in Stage1
+static const size_t STAGE1_BATCH_QUERIES = 4096;
+
+// Read the next batch of queries, false once a query turns out to be spread over the file
+static bool read_query_batch(AlignmentGroupReader& reader, std::vector<std::vector<input_record_t>>& batch) {
+    batch.clear();
+    std::vector<input_record_t> group;
+    while (batch.size() < STAGE1_BATCH_QUERIES && reader.next(group)) {
+        batch.push_back(std::move(group));
+    }
+    return reader.grouped();
+}
+
+// Stage1: find the representative alignment for each contig, then find the contigs which include the putative fusion gene
+bool Pipeline::choose_alignments() {
+
+    // Index the contig file, the sequences of the candidate contigs are only read in Stage2
+    {
+        Metrics::Timer timer(metrics_, "Stage1/load_contigs");
+        fasta_.open(options_.input_assembly);
+        timer.count("contigs", fasta_.size());
+        timer.count("index_cached", fasta_.cached());
+    }
+    out_ << get_time_string() << " The original contig include " << fasta_.size() << " sequences "<< std::endl;
+    Logger::Info( get_time_string() + " The original contig include " + std::to_string(fasta_.size()) + " sequences ");
+
+    // Read the alignment file one query at a time, only the chosen alignments and the query coordinates are kept
+    out_ << get_time_string() << " Loading alignments from " << adapter_.format() << " file:" << " '" << options_.input_file << "' " << "\n" << std::flush;
+    Logger::Info(get_time_string() + " Loading alignments from " + adapter_.format() + " file:" + " '" +  options_.input_file + "' ");
+    Metrics::Timer scoring_timer(metrics_, "Stage1/scoring");
+    stage1_counts_t counts;
+    bool streamed;
+    {
+        AlignmentGroupReader reader(adapter_, options_.input_file, fasta_, options_.threads);
+        streamed = score_alignment_groups([&reader](std::vector<std::vector<input_record_t>>& batch) {
+            return read_query_batch(reader, batch);
+        }, counts);
+    }
+
+    // The alignments of a query are spread over the file, so the file is sorted by query within the memory limit
+    if (!streamed) {
+        out_ << get_time_string() << " The alignments of the queries are not grouped in the " << adapter_.format() << " file, sorting the file by query " << std::endl;
+        Logger::Warning(get_time_string() + " The alignments of the queries are not grouped in the " + adapter_.format() + " file, sorting the file by query ");
+        query_coordinates_.clear();
+        chosen_alignments_.clear();
+        counts = stage1_counts_t();
+
+        Metrics::Timer sort_timer(metrics_, "Stage1/sort");
+        std::unique_ptr<AlignmentReader> input = adapter_.open(options_.input_file, fasta_, options_.threads);
+        AlignmentGroupReader reader(sort_by_query(*input, options_.output + "/" + options_.prefix + "_sort",
+                                                  static_cast<size_t>(options_.sort_memory) << 20, options_.threads));
+        input.reset();
+        sort_timer.stop();
+        score_alignment_groups([&reader](std::vector<std::vector<input_record_t>>& batch) {
+            return read_query_batch(reader, batch);
+        }, counts);
+
+        // The runs of a large file keep only the fields of the scoring, so the chosen alignments are read again
+        bool reduced = std::any_of(chosen_alignments_.begin(), chosen_alignments_.end(),
+                                   [](const alignment_t& alignment) { return alignment.input_record >= 0; });
+        if (reduced) {
+            Metrics::Timer restore_timer(metrics_, "Stage1/restore");
+            input = adapter_.open(options_.input_file, fasta_, options_.threads);
+            restore_alignments(*input, chosen_alignments_);
+        }
+    }
+    out_ << get_time_string() << " The input " << adapter_.format() << " file includes in total " << input_alignments() << " alignments\n" << std::flush;
+
+    // Record the total number of contigs and line number range at the end
+    Logger::Info(get_time_string() + " This " + adapter_.format() + " file includes in total " + std::to_string(counts.contigs) + " contigs，alignments number in each contig range from: " +
+                 std::to_string(counts.min_alignments) + " to " + std::to_string(counts.max_alignments));
+
+    scoring_timer.count("alignments", input_alignments());
+    scoring_timer.count("streamed", streamed);
+    scoring_timer.count("contigs", counts.contigs);
+    scoring_timer.count("scored_contigs", counts.scored_contigs);
+    scoring_timer.count("single_alignment_contigs", counts.single_alignment_contigs);
+    scoring_timer.count("covered_contigs", counts.covered_contigs);
+    scoring_timer.count("covered_contigs_percent", counts.contigs > 0 ? counts.covered_contigs * 100 / counts.contigs : 0);
+    scoring_timer.count("identity_filtered_alignments", counts.identity_filtered_alignments);
+    scoring_timer.count("chosen_alignments", chosen_alignments_.size());
+
+    Logger::Info(get_time_string() + " Contigs covered by a single alignment, which are not scored: " + std::to_string(counts.covered_contigs) +
+                 " of " + std::to_string(counts.contigs));
+    out_ << get_time_string() << " Count the chosen alignments which could represent each contig: " << chosen_alignments_.size() << std::endl;
+    Logger::Info(get_time_string() + " Count the chosen alignments which could represent each contig: " + std::to_string(chosen_alignments_.size()));
+    return true;
+}
+
+
+ThreadPool& Pipeline::thread_pool() {
+    if (thread_pool_ == nullptr) {
+        own_thread_pool_.reset(new ThreadPool(std::max(1, options_.threads)));
+        thread_pool_ = own_thread_pool_.get();
+    }
+    return *thread_pool_;
+}
+
+bool Pipeline::score_alignment_groups(const batch_reader_t& read_batch, stage1_counts_t& counts) {
+    std::vector<std::vector<input_record_t>> batch;
+    std::vector<std::vector<input_record_t>> next_batch;
+    bool complete = read_batch(batch);
+
+    while (!batch.empty()) {
+        // The coordinates of all queries are kept, only the queries with not too many alignments are scored. The
+        // records are settled on their keys, so a query whose best combination is a single alignment builds that
+        // alignment alone; if it covers the whole contig, the contig is not chimeric and is dropped unless the input
+        // consists of fragments of the contigs
+        std::vector<std::vector<alignment_t>> results(batch.size());
+        std::vector<size_t> scored;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            auto& group = batch[i];
+            int group_size = group.size();
+            counts.min_alignments = std::min(counts.min_alignments, group_size);
+            counts.max_alignments = std::max(counts.max_alignments, group_size);
+            ++counts.contigs;
+
+            query_coordinates_t query{group.front().key.query, {}};
+            query.coordinates.reserve(group.size());
+            for (const auto& record : group) {
+                query.coordinates.emplace_back(record.key.qstart, record.key.qend);
+            }
+            query_coordinates_.push_back(std::move(query));
+
+            if (group_size > options_.max_alignment_count) {
+                continue;
+            }
+            int settled = -1;
+            if (group.front().key.query_len > 0) {
+                std::vector<const alignment_key_t*> keys;
+                keys.reserve(group.size());
+                for (const auto& record : group) {
+                    keys.push_back(&record.key);
+                }
+                settled = settled_alignment(keys, options_);
+            }
+            if (settled >= 0) {
+                const alignment_key_t& best = group[settled].key;
+                ++counts.single_alignment_contigs;
+                if (!adapter_.fragmented() && best.identity > options_.min_identity_fract &&
+                    best.qstart <= options_.edge_unaligned && best.qend >= best.query_len - options_.edge_unaligned) {
+                    ++counts.covered_contigs;
+                } else {
+                    results[i].push_back(build_alignment(group[settled]));
+                }
+                continue;
+            }
+            scored.push_back(i);
+        }
+        counts.scored_contigs += scored.size();
+
+        // Each task scores a range of the queries, the next batch is read meanwhile. The group is declared after the
+        // data of its tasks, so that it waits for them before the data goes away if reading the next batch throws
+        TaskGroup tasks(thread_pool());
+        int task_count = std::max(1, std::min(thread_pool().size(), static_cast<int>(scored.size())));
+        for (int task = 0; task < task_count; ++task) {
+            size_t begin = scored.size() * task / task_count;
+            size_t end = scored.size() * (task + 1) / task_count;
+            tasks.submit([this, &batch, &scored, &results, begin, end]() {
+                for (size_t i = begin; i < end; ++i) {
+                    size_t index = scored[i];
+                    std::vector<alignment_t> alignments;
+                    alignments.reserve(batch[index].size());
+                    for (auto& record : batch[index]) {
+                        alignments.push_back(build_alignment(record));
+                    }
+                    std::unordered_map<std::string, std::vector<alignment_t>> group;
+                    group.emplace(batch[index].front().key.query, std::move(alignments));
+                    results[index] = calculate_alignments_score(group, options_);
+                }
+            });
+        }
+        if (complete) {
+            complete = read_batch(next_batch);
+        } else {
+            next_batch.clear();
+        }
+        tasks.wait();
+
+        // Keep the contigs whose alignments pass the identity filter and the score thresholds, in the order of the input
+        for (const auto& result : results) {
+            std::vector<alignment_t> identity_filtered;
+            for (const auto& alignment : result) {
+                if (alignment.identity > options_.min_identity_fract) {  // Apply identity filter
+                    identity_filtered.push_back(alignment);
+                }
+            }
+            counts.identity_filtered_alignments += identity_filtered.size();
+            if (!identity_filtered.empty() && adapter_.passes_score(identity_filtered, options_)) {
+                chosen_alignments_.insert(chosen_alignments_.end(), identity_filtered.begin(), identity_filtered.end());
+            }
+        }
+        batch.swap(next_batch);
+    }
+    return complete;
+}
+
+size_t Pipeline::input_alignments() const {
+    size_t alignments = 0;
+    for (const auto& query : query_coordinates_) {
+        alignments += query.coordinates.size();
+    }
+    return alignments;
+}
+
+
+// Log detailed alignments of a category
+static void log_alignments(const std::string& category, const std::vector<alignment_t>& alignments, const std::vector<alignment_pair_t>& pairs) {
+    if (!Logger::enabled(LogLevel::DEBUG)) {
+        return;
+    }
+    Logger::Debug(get_time_string() + " Information for the alignments classified " + category + ": ");
+    for (const auto& pair : pairs) {
+        for (uint32_t index : {pair.first, pair.second}) {
+            const alignment_t& alignment = alignments[index];
+            std::ostringstream message;
+            message << get_time_string() << "\tContig:" << alignment.query
+                                         << "\tqlength:" << alignment.query_len
+                                         << "\tqstart:" << alignment.qstart
+                                         << "\tqend:" << alignment.qend
+                                         << "\tchr:" << alignment.target
+                                         << "\tstrand:" << alignment.query_strand
+                                         << "\tidentity:" << alignment.identity
+                                         << "\tscore:" << alignment.score;
+            Logger::Debug(message.str());
+        }
+    }
+}
+
+// Stage2: Grouping the alignments, select the candidate contigs and write their sequences for the realignment
+bool Pipeline::classify_candidates() {
+
+    // Using functions to get different types of alignment
+    Metrics::Timer grouping_timer(metrics_, "Stage2/grouping");
+    query_groups_t groups = group_alignments(chosen_alignments_);
+
+    // Print the number of alignments in each category
+    out_ << get_time_string() << " All the chosen alignments will be divided into different types: single alignments, gaps alignments, overlaps pairs alignments, multiples alignments " << std::endl;
+    Logger::Info(get_time_string() + " All the chosen alignments will be divided into different types: single alignments, gaps alignments, overlaps pairs alignments, multiples alignments");
+    out_ << get_time_string() << " single alignments: " << groups.singles.size() << std::endl;
+    Logger::Info(get_time_string() + " single alignments: " + std::to_string(groups.singles.size()));
+    out_ << get_time_string() << " pairs alignments: " << groups.pairs.size() << std::endl;
+    Logger::Info(get_time_string() + " pairs alignments: " + std::to_string(groups.pairs.size()));
+    out_ << get_time_string() << " multiples alignments: " << groups.multiple_alignments << std::endl;
+    Logger::Info(get_time_string() + " multiples alignments: " + std::to_string(groups.multiple_alignments));
+
+    // Classify pairwise alignments using the classify_alignments function
+    auto classified_alignments = classify_alignments(chosen_alignments_, groups, options_);
+
+    overlaps_same_strand_ = std::move(classified_alignments[OVERLAPS_SAME_STRAND]);
+    gaps_same_strand_ = std::move(classified_alignments[GAP_SAME_STRAND]);
+    const auto& overlaps_diff_strand = classified_alignments[OVERLAPS_DIFFERENT_STRAND];
+    const auto& gaps_diff_strand = classified_alignments[GAP_DIFFERENT_STRAND];
+
+    // Print the number of alignments in each category
+    out_ << get_time_string() << " All the paired chosen alignments will be divided into different types: overlap in same strand, gaps in same strand, overlaps in different strand, gaps in different strand " << std::endl;
+    Logger::Info(get_time_string() + " All the paired chosen alignments will be divided into different types: overlap in same strand, gaps in same strand, overlaps in different strand, gaps in different strand ");
+    out_ << get_time_string() << " Number of overlaps same strand alignments: " << 2 * overlaps_same_strand_.size() << std::endl;
+    Logger::Info(get_time_string() + " Number of overlaps same strand alignments: " + std::to_string(2 * overlaps_same_strand_.size()));
+    out_ << get_time_string() << " Number of overlaps different strand alignments: " << 2 * overlaps_diff_strand.size() << std::endl;
+    Logger::Info(get_time_string() + " Number of overlaps different strand alignments: " + std::to_string(2 * overlaps_diff_strand.size()));
+    out_ << get_time_string() << " Number of gaps same strand alignments: " << 2 * gaps_same_strand_.size() << std::endl;
+    Logger::Info(get_time_string() + " Number of gaps same strand alignments: " + std::to_string(2 * gaps_same_strand_.size()));
+    out_ << get_time_string() << " Number of gaps different strand alignments: " << 2 * gaps_diff_strand.size() << std::endl;
+    Logger::Info(get_time_string() + " Number of gaps different strand alignments: " + std::to_string(2 * gaps_diff_strand.size()));
+
+    grouping_timer.count("singles", groups.singles.size());
+    grouping_timer.count("pairs", groups.pairs.size());
+    grouping_timer.count("multiples", groups.multiple_alignments);
+    grouping_timer.count("overlaps_same_strand", 2 * overlaps_same_strand_.size());
+    grouping_timer.count("gaps_same_strand", 2 * gaps_same_strand_.size());
+    grouping_timer.stop();
+
+    log_alignments("Overlaps Same Strand", chosen_alignments_, overlaps_same_strand_);
+    log_alignments("Overlaps Different Strand", chosen_alignments_, overlaps_diff_strand);
+    log_alignments("Gaps Same Strand", chosen_alignments_, gaps_same_strand_);
+    log_alignments("Gaps Different Strand", chosen_alignments_, gaps_diff_strand);
+
+    // Merge the contig names of overlaps and gaps in the same strand
+    std::unordered_set<std::string> query_names = extractBaseQueryNames(chosen_alignments_, overlaps_same_strand_);
+    std::unordered_set<std::string> query_names_gap = extractBaseQueryNames(chosen_alignments_, gaps_same_strand_);
+    query_names.insert(query_names_gap.begin(), query_names_gap.end());
+
+    // Collect the sequences of the candidate contigs
+    Metrics::Timer sequences_timer(metrics_, "Stage2/collect_sequences");
+    fragments_ = adapter_.select_fragments(chosen_alignments_, query_names);
+    merged_sequences_ = adapter_.collect_sequences(fragments_, fasta_);
+
+    // Output the merged sequence to a file
+    outputMergedSequences(merged_sequences_, options_);
+    sequences_timer.count("fragments", fragments_.size());
+    sequences_timer.count("sequences", merged_sequences_.size());
+    out_ << get_time_string() << " Merged sequences " << merged_sequences_.size() << " have been written to " << options_.output << "/" << options_.prefix << ".chosen.fasta" << std::endl;
+    Logger::Info(get_time_string() + " Merged sequences have been written to " + options_.output + "/" + options_.prefix + ".chosen.fasta");
+    return true;
+}
+
+
+// Stage3: realign the contigs by using bowtie2, calculate the number of support reads for each fusion
+bool Pipeline::realign_reads() {
+
+    // paired the exact include fusion information alignments of overlaps and gaps
+    {
+        Metrics::Timer pairing_timer(metrics_, "Stage3/pairing");
+        paired_alignments_ = pairAlignments(chosen_alignments_, overlaps_same_strand_);
+        auto pairedAlignments_gap = pairAlignments(chosen_alignments_, gaps_same_strand_);
+        paired_alignments_.insert(paired_alignments_.end(), pairedAlignments_gap.begin(), pairedAlignments_gap.end());
+
+        // Get the complete best aligned alignments
+        overlap_results_ = adapter_.process_pairs(paired_alignments_, merged_sequences_);
+        pairing_timer.count("paired_alignments", paired_alignments_.size());
+        pairing_timer.count("overlaps", overlap_results_.size());
+    }
+
+    std::string samFilePath = options_.output + "/" + options_.prefix + ".sam";
+    junction_windows_t junction_windows;
+    std::unique_ptr<RealignmentCache> cache;
+    uint64_t alignments_key = 0;
+    bool cached_reads = false;
+    if (realignment_.empty()) {
+        const char* homeDir = getenv("HOME");
+        if (!homeDir) {
+            out_ << get_time_string() << " Error: HOME directory not found." << std::endl;
+            Logger::Error(get_time_string() + " Error: HOME directory not found.");
+            return false;
+        }
+
+        // Set up the index directory
+        std::string directorySetupCommand = "mkdir -p " + std::string(options_.output) + "/" + options_.prefix +"_idx";
+        system(directorySetupCommand.c_str());  // Make sure the directory exists
+
+        out_ << get_time_string() << " Updated PATH for bowtie2 binaries." << std::endl;
+        Logger::Info(get_time_string() + " Updated PATH for bowtie2 binaries.");
+
+        // The reads are realigned to the windows around the junctions, which are all the support is counted in
+        std::string reference = options_.output + "/" + options_.prefix + ".chosen.fasta";
+        if (options_.junction_window > 0) {
+            Metrics::Timer timer(metrics_, "Stage3/junction_windows");
+            reference = options_.output + "/" + options_.prefix + ".junctions.fasta";
+            junction_windows = outputJunctionWindows(merged_sequences_, overlap_results_, options_.junction_window + options_.read_length, reference);
+            timer.count("windows", junction_windows.size());
+            out_ << get_time_string() << " Junction windows " << junction_windows.size() << " have been written to " << reference << std::endl;
+            Logger::Info(get_time_string() + " Junction windows " + std::to_string(junction_windows.size()) + " have been written to " + reference);
+        }
+
+        // The index and the realigned reads of the same reference and reads are taken from the cache
+        uint64_t index_key = 0;
+        if (!options_.realign_cache.empty()) {
+            Metrics::Timer timer(metrics_, "Stage3/realign_cache");
+            cache.reset(new RealignmentCache(options_.realign_cache, static_cast<uint64_t>(options_.realign_cache_size) << 20));
+            if (RealignmentCache::index_key(reference, index_key)) {
+                alignments_key = RealignmentCache::alignments_key(index_key, options_);
+                cached_reads = cache->load_alignments(alignments_key, sam_entries_);
+            } else {
+                cache.reset();
+            }
+            timer.count("cached_reads", cached_reads ? sam_entries_.size() : 0);
+        }
+
+        std::string indexPrefix = options_.output + "/" + options_.prefix + "_idx/" + options_.prefix;
+        if (cached_reads) {
+            out_ << get_time_string() << " Using the cached realignment of " << sam_entries_.size() << " reads from '" << options_.realign_cache << "' " << std::endl;
+            Logger::Info(get_time_string() + " Using the cached realignment from '" + options_.realign_cache + "' ");
+        } else {
+            std::string cachedIndex = cache ? cache->find_index(index_key) : "";
+            if (!cachedIndex.empty()) {
+                indexPrefix = cachedIndex;
+                out_ << get_time_string() << " Using the cached bowtie2 index '" << indexPrefix << "' " << std::endl;
+                Logger::Info(get_time_string() + " Using the cached bowtie2 index '" + indexPrefix + "' ");
+            } else {
+                // Build the index, a partial index in the cache is removed with the cache
+                Metrics::Timer timer(metrics_, "Stage3/bowtie2_index");
+                bool built;
+                if (cache) {
+                    indexPrefix = cache->prepare_index(index_key);
+                    built = build_bowtie2_index(options_, reference, indexPrefix);
+                    if (built) {
+                        indexPrefix = cache->commit_index(index_key);
+                    }
+                } else {
+                    built = build_bowtie2_index(options_, reference, indexPrefix);
+                }
+                if (!built) {
+                    out_ << get_time_string() << " Error: building the bowtie2 index of " << reference << " failed." << std::endl;
+                    Logger::Error(get_time_string() + " Error: building the bowtie2 index of " + reference + " failed.");
+                    return false;
+                }
+                out_ << get_time_string() << " Bowtie2 index built." << std::endl;
+                Logger::Info(get_time_string() + " Bowtie2 index built.");
+            }
+
+            // Run realignment step, the stage fails instead of reading an old or missing realignment
+            {
+                Metrics::Timer timer(metrics_, "Stage3/bowtie2_align");
+                if (!run_bowtie2(options_, indexPrefix)) {
+                    out_ << get_time_string() << " Error: the bowtie2 alignment failed." << std::endl;
+                    Logger::Error(get_time_string() + " Error: the bowtie2 alignment failed.");
+                    return false;
+                }
+            }
+            out_ << get_time_string() << " Finished bowtie2 alignment. " << std::endl;
+            Logger::Info(get_time_string() + " Finished bowtie2 alignment.");
+        }
+    } else {
+        samFilePath = realignment_;
+        out_ << get_time_string() << " Using the existing realignment '" << realignment_ << "' " << std::endl;
+        Logger::Info(get_time_string() + " Using the existing realignment '" + realignment_ + "' ");
+    }
+
+    // Load sam file, the realignment may be empty
+    {
+        Metrics::Timer timer(metrics_, "Stage3/sam_load");
+        if (!cached_reads) {
+            SamFileCls samFile(samFilePath);
+            sam_t samEntry;
+            while (samFile.next(samEntry)) {
+                sam_entries_.push_back(samEntry);
+            }
+            samFile.close();
+        }
+        // The reads are cached in the coordinates of the reference they were realigned to
+        if (cache) {
+            if (!cached_reads && !cache->store_alignments(alignments_key, sam_entries_)) {
+                Logger::Warning(get_time_string() + " The realignment could not be written to the cache '" + options_.realign_cache + "' ");
+            }
+            cache->collect_garbage();
+        }
+        // Back to the coordinates of the contigs for the support and coverage
+        remapJunctionWindows(sam_entries_, junction_windows);
+        // The realignment is an output of the run in the coordinates of the contigs, also when it comes from the cache
+        if (cached_reads || !junction_windows.empty()) {
+            writeSamFile(samFilePath, sam_entries_);
+        }
+        timer.count("reads", sam_entries_.size());
+    }
+
+    Metrics::Timer support_timer(metrics_, "Stage3/support_counting");
+
+    // Calculation support reads, the contigs are divided among the threads
+    support_reads_t support = SupportContext(overlap_results_, sam_entries_).count(options_, thread_pool());
+    split_reads_count_ = std::move(support.split_reads_count);
+    span_reads_count_ = std::move(support.span_reads_count);
+    split_reads_ = std::move(support.split_reads);
+    span_reads_ = std::move(support.span_reads);
+
+    support_timer.count("split_read_queries", split_reads_count_.size());
+    support_timer.count("span_read_queries", span_reads_count_.size());
+
+    // Output the number of split reads and spanning read pairs for all query names
+    out_ << get_time_string() << " Calculate the number of split reads and spanning read pairs for all querys " << std::endl;
+    Logger::Info(get_time_string() + " Calculate the number of split reads and spanning read pairs for all querys");
+    if (Logger::enabled(LogLevel::DEBUG)) {
+        for (const auto& entry : split_reads_count_) {
+            Logger::Debug(get_time_string() + "\tQuery:" + entry.first + "\tsplit reads: " + std::to_string(entry.second) + "\tspan reads: " + std::to_string(span_reads_count_[entry.first]));
+        }
+    }
+
+    // Filter queries that meet the criteria, get the alignment corresponding to the valid query
+    std::unordered_set<std::string> validQueries = filterQueries(split_reads_count_, span_reads_count_);
+    std::vector<alignment_t> relevantAlignments = adapter_.supported_alignments(fragments_, chosen_alignments_, overlaps_same_strand_, validQueries);
+
+    out_ << get_time_string() << " Filtered chosen alignments based on support reads and spanning read pairs: " << relevantAlignments.size() << std::endl;
+    Logger::Info(get_time_string() + " Filtered chosen alignments: " +  std::to_string(relevantAlignments.size()));
+
+    support_timer.count("valid_queries", validQueries.size());
+    support_timer.count("relevant_alignments", relevantAlignments.size());
+
+    // Extract coordinations from relevant alignments
+    final_coordinations_ = adapter_.coordinations(relevantAlignments);
+    support_timer.count("coordinations", final_coordinations_.size());
+    out_ << get_time_string() << " Final coordinations after merging " << std::endl;
+    return true;
+}
+
+
+// Stage4: annotation of the gene, filtering the candidates and output the remain results
+bool Pipeline::filter_fusions() {
+
+    // Annotation, the reference data is loaded here unless it is shared. When resuming from the checkpoint of this
+    // stage, the candidates are already annotated and only the known fusions are needed
+    std::unique_ptr<reference_t> own_reference;
+    std::unique_ptr<KnownFusionIndex> own_known_fusions;
+    const KnownFusionIndex* known_fusions = reference_ != nullptr ? &reference_->known_fusions : nullptr;
+    if (resumed_stage_ < 4) {
+        {
+            Metrics::Timer timer(metrics_, "Stage4/annotation");
+            const reference_t* reference = reference_;
+            if (reference == nullptr) {
+                own_reference.reset(new reference_t(options_));
+                reference = own_reference.get();
+                known_fusions = &reference->known_fusions;
+            }
+            auto filtered_final_coordinations = keepOnlyTwoParts(final_coordinations_);
+            auto annotations = reference->annotator.annotateAlignments(filtered_final_coordinations);
+            keepOnlyTwoAnnotations(annotations);
+
+            processAnnotations(annotations, final_results_);
+            timer.count("annotations", annotations.size());
+            timer.count("results", final_results_.size());
+        }
+        out_ << get_time_string() << " Filtering the invalid annotations " << "(remaining=" << final_results_.size() << ")" << std::endl;
+        Logger::Info(get_time_string() + " Filtering the invalid annotations " + "(remaining=" + std::to_string(final_results_.size()) + ")");
+        integrateReadCounts(final_results_, split_reads_count_, span_reads_count_);
+
+        removeEmptyGenes(final_results_);
+        out_ << get_time_string() << " Filtering the empty annotations " << "(remaining=" << final_results_.size() << ")" << std::endl;
+        Logger::Info(get_time_string() + " Filtering the empty annotations " + "(remaining=" + std::to_string(final_results_.size()) + ")");
+
+        if (options_.checkpoint) {
+            save_checkpoint(4);
+        }
+    } else if (known_fusions == nullptr) {
+        own_known_fusions.reset(new KnownFusionIndex(options_.known_fusions));
+        known_fusions = own_known_fusions.get();
+    }
+
+    // Apply filters to final_results, the adapter decides how the queries of the paired alignments refer to the contigs
+    const options_t& options = options_;
+    ContigPairIndex contig_pairs(paired_alignments_, adapter_.contig_name());
+    FilterHomologs filter_homologs(final_results_, contig_pairs, query_coordinates_);
+    FilterChain filter_chain;
+    add_fusion_filters(filter_chain, options, adapter_.fragmented() ? &filter_homologs : nullptr);
+
+    // Evaluate all filters in one pass, the discarded results are moved behind the kept ones
+    size_t kept_count;
+    {
+        Metrics::Timer timer(metrics_, "Stage4/filters");
+        kept_count = filter_chain.apply(final_results_);
+        timer.count("results", final_results_.size());
+        timer.count("kept", kept_count);
+    }
+    size_t remaining = final_results_.size();
+    for (size_t i = 0; i < filter_chain.size(); ++i) {
+        remaining -= filter_chain.discarded(i);
+        out_ << get_time_string() << " " << filter_chain.description(i) << " (remaining=" << remaining << ")" << std::endl;
+        Logger::Info(get_time_string() + " " + filter_chain.description(i) + " (remaining=" + std::to_string(remaining) + ")");
+        metrics_.record("Stage4/filters/" + FILTERS[filter_chain.filter(i)], filter_chain.seconds(i),
+                        {{"evaluated", filter_chain.evaluated(i)}, {"discarded", filter_chain.discarded(i)}});
+    }
+
+    // Output discarded results
+    discarded_results_.assign(std::make_move_iterator(final_results_.begin() + kept_count),
+                              std::make_move_iterator(final_results_.end()));
+    final_results_.erase(final_results_.begin() + kept_count, final_results_.end());
+
+    // Filter out known fusions and add the recovered fusions to the kept results
+    std::vector<result_t> recovered_fusions = recover_fusions(discarded_results_, *known_fusions);
+    final_results_.insert(final_results_.end(), recovered_fusions.begin(), recovered_fusions.end());
+
+    // Output final results count
+    out_ << get_time_string() << " Final fusion genes count: " << final_results_.size() << std::endl;
+
+    // Integrate coverage counts into final_results
+    Metrics::Timer coverage_timer(metrics_, "Stage4/coverage");
+    std::unordered_map<std::string, float> averageCoverageMap;
+    std::unordered_map<std::string, std::unordered_map<int, int>> perBaseCoverageMap;
+    processCoverage(sam_entries_, overlap_results_, averageCoverageMap, perBaseCoverageMap);
+
+    // Iterate through final results and add coverage info, per-base coverage is stored separately
+    for (auto& result : final_results_) {
+        const std::string& contig = SYMBOLS.str(result.contig);
+
+        if (averageCoverageMap.find(contig) != averageCoverageMap.end()) {
+            result.coverage = averageCoverageMap[contig];
+        }
+        if (perBaseCoverageMap.find(contig) != perBaseCoverageMap.end()) {
+            per_base_coverage_[contig] = perBaseCoverageMap[contig];
+        }
+    }
+
+    // Save the data to a TSV file
+    savePerBaseCoverageToTSV(per_base_coverage_, options.output + "/" + options.prefix + ".per_base_coverage.tsv");
+    coverage_timer.count("contigs", per_base_coverage_.size());
+    coverage_timer.stop();
+
+    // Output the result and fill in the structure
+    if (Logger::enabled(LogLevel::DEBUG)) {
+        for (const auto& result : final_results_) {
+            std::ostringstream message;
+            message << get_time_string() << " Final fusion genes:\t";
+            writeResultFields(message, result, '\t');
+            Logger::Debug(message.str() + "\t");
+        }
+
+        for (const auto& result : discarded_results_) {
+            std::ostringstream message;
+            message << get_time_string() << " Discarded fusion genes:\t";
+            writeResultFields(message, result, '\t');
+            Logger::Debug(message.str() + "\t");
+        }
+    }
+
+    // Write supporting reads into fq files
+    Metrics::Timer output_timer(metrics_, "Stage4/output");
+    writeEvidenceToFastq(final_results_, split_reads_, span_reads_, options.prefix + ".evidence", options);
+
+    // Write to TSV file
+    writeToTSV(final_results_, options.output + "/" + options.prefix + ".fusion_list.tsv");
+    out_ << get_time_string() << " Write fusion list into file:" << " '" << options.output << "/" << options.prefix << ".fusion_list.tsv" << "' " << std::endl;
+
+    writeToTSV(discarded_results_, options.output + "/" + options.prefix + ".discarded_fusions.tsv");
+    out_ << get_time_string() << " Write discarded fusion list into file:" << " '" << options.output << "/" << options.prefix << ".discarded_fusions.tsv" << "' " << std::endl;
+    output_timer.count("fusions", final_results_.size());
+    output_timer.count("discarded_fusions", discarded_results_.size());
+    return true;
+}
+
+
+// Stage5: calculation of the coverage and  prediction of breakpoints
+bool Pipeline::predict_breakpoints() {
+    out_ << get_time_string() << " Saved per-base coverage to " << " '" << options_.output << "/" << options_.prefix << ".per_base_coverage.tsv" << "' " << std::endl;
+    Logger::Info(get_time_string() + " Saved per-base coverage to " + " '" + options_.output + "/" + options_.prefix + ".per_base_coverage.tsv" + "' ");
+
+    std::vector<std::pair<int, int>> readLengths;
+    float averageRate = 1.0; // Average rate of coverage per base
+    float qualityThreshold = 0.1; // Minimum quality score for breakpoint detection
+
+    // Evaluate breakpoints
+    Metrics::Timer timer(metrics_, "Stage5/breakpoints");
+    auto breakpoints = evaluateBreakpoints(per_base_coverage_, readLengths, averageRate, qualityThreshold, options_);
+    timer.count("contigs", breakpoints.size());
+    return true;
+}
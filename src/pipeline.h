@@ -0,0 +1,150 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "alignment.h"
+#include "annotation.h"
+#include "checkpoint.h"
+#include "input_adapter.h"
+#include "metrics.h"
+#include "options.h"
+#include "output_fusions.h"
+#include "overlap.h"
+#include "realign_support.h"
+#include "recover_known_fusion.h"
+#include "sam.h"
+#include "thread_pool.h"
+
+// Reference data which is the same for all samples, loaded once and shared by the pipelines of a batch
+struct reference_t {
+    explicit reference_t(const options_t& options): annotator(options.gtf_path), known_fusions(options.known_fusions) {}
+
+    const GeneAnnotator annotator;
+    const KnownFusionIndex known_fusions;
+};
+
+// The whole calculation of DenovoFusion for one input, the stages are the same with the description in article,
+// Stage1: chose the best alignments which could represent each contig
+// Stage2: group the contigs into 4 subsets, single alignments, gap alignments, paired alignments, multiple alignments
+// Stage3: realignment from raw reads to chosen contigs, calculate the support split and span reads
+// Stage4: filtering, output the final fusions
+// Stage5: calculation of the coverage and  prediction of breakpoints
+// The input format is only handled by the adapter, so every stage applies to PSL, SAM and PAF input alike.
+class Pipeline {
+public:
+    // The progress messages are written to out
+    Pipeline(const options_t& options, const InputAdapter& adapter, std::ostream& out = std::cout);
+
+    // Run all stages, returns false if a stage failed
+    bool run();
+
+    // Use an existing SAM file of reads realigned to the chosen contigs instead of running bowtie2
+    void use_realignment(const std::string& sam_file) { realignment_ = sam_file; }
+
+    // Use shared reference data instead of loading the GTF and known fusions in Stage4
+    void use_reference(const reference_t& reference) { reference_ = &reference; }
+
+    // Run the parallel parts of the stages on a pool shared with other runs instead of a pool of options.threads
+    // workers of this run
+    void use_thread_pool(ThreadPool& pool) { thread_pool_ = &pool; }
+
+    // Load the annotated candidates and the data of the filters from the Stage4 checkpoint of any run, e.g. to evaluate
+    // filter settings without running the pipeline. final_results() returns the candidates before the filters
+    bool load_candidates(const std::string& checkpoint_file);
+
+    const Metrics& metrics() const { return metrics_; }
+
+    // Intermediate results, available after the stage which produces them
+    const FastaIndex& fasta() const { return fasta_; }
+    const std::vector<query_coordinates_t>& query_coordinates() const { return query_coordinates_; }
+    size_t input_alignments() const;
+    const std::vector<alignment_t>& chosen_alignments() const { return chosen_alignments_; }
+    const std::vector<sam_t>& sam_entries() const { return sam_entries_; }
+    const std::vector<std::pair<alignment_t, alignment_t>>& paired_alignments() const { return paired_alignments_; }
+    const std::vector<OverlapResultCls>& overlap_results() const { return overlap_results_; }
+    const std::vector<coordination_t>& final_coordinations() const { return final_coordinations_; }
+    const std::vector<result_t>& final_results() const { return final_results_; }
+    const std::vector<result_t>& discarded_results() const { return discarded_results_; }
+
+private:
+    typedef bool (Pipeline::*stage_t)();
+
+    // Run a single stage and record its metrics, the stages covered by the resumed checkpoint are skipped
+    bool run_stage(int number, const std::string& description, stage_t stage);
+
+    // Checkpoints of Stage1 to Stage3 and of the annotated candidates in Stage4. Each checkpoint holds the results
+    // which the following stages need, so a run continues from a single checkpoint
+    void prepare_checkpoints();
+    std::string checkpoint_file(int stage) const;
+    void save_checkpoint(int stage);
+    bool load_checkpoint(int stage);
+    bool read_checkpoint(CheckpointReader& reader, int stage);
+    void clear_results();
+
+    bool choose_alignments();
+    // Stage1 scores the alignments of one query at a time. Batches of queries are scored on the worker pool while
+    // read_batch fills the next batch, read_batch returns false if the queries have to be read again
+    struct stage1_counts_t {
+        int contigs = 0;
+        int min_alignments = std::numeric_limits<int>::max();
+        int max_alignments = std::numeric_limits<int>::min();
+        size_t scored_contigs = 0;
+        size_t single_alignment_contigs = 0;    // taken without scoring the combinations
+        size_t covered_contigs = 0;             // discarded, a single alignment covers the whole contig
+        size_t identity_filtered_alignments = 0;
+    };
+    typedef std::function<bool(std::vector<std::vector<input_record_t>>&)> batch_reader_t;
+    bool score_alignment_groups(const batch_reader_t& read_batch, stage1_counts_t& counts);
+    ThreadPool& thread_pool();
+    bool classify_candidates();
+    bool realign_reads();
+    bool filter_fusions();
+    bool predict_breakpoints();
+
+    const options_t& options_;
+    const InputAdapter& adapter_;
+    std::ostream& out_;
+    Metrics metrics_;
+    std::string realignment_;
+    const reference_t* reference_ = nullptr;
+    ThreadPool* thread_pool_ = nullptr;
+    std::unique_ptr<ThreadPool> own_thread_pool_;   // created on first use if no pool is shared
+    uint64_t checkpoint_keys_[5] = {};             // by stage, covering the inputs and options up to the stage
+    int resumed_stage_ = 0;                         // stage of the checkpoint the run continues from, 0 for none
+
+    // Stage1
+    FastaIndex fasta_;                              // index of the contigs, sequences are read on demand
+    std::vector<query_coordinates_t> query_coordinates_;   // of all input alignments, for the homolog filter
+    std::vector<alignment_t> chosen_alignments_;
+
+    // Stage2
+    std::vector<alignment_pair_t> overlaps_same_strand_;    // pairs of the chosen alignments
+    std::vector<alignment_pair_t> gaps_same_strand_;
+    std::vector<alignment_t> fragments_;            // alignments of the candidate contigs
+    sequences_t merged_sequences_;
+
+    // Stage3
+    std::vector<sam_t> sam_entries_;
+    std::vector<std::pair<alignment_t, alignment_t>> paired_alignments_;
+    std::vector<OverlapResultCls> overlap_results_;
+    std::unordered_map<std::string, int> split_reads_count_;
+    std::unordered_map<std::string, int> span_reads_count_;
+    std::unordered_map<std::string, std::vector<sam_t>> split_reads_;
+    std::unordered_map<std::string, std::vector<sam_t>> span_reads_;
+    std::vector<coordination_t> final_coordinations_;
+
+    // Stage4
+    std::vector<result_t> final_results_;
+    std::vector<result_t> discarded_results_;
+    std::unordered_map<std::string, std::unordered_map<int, int>> per_base_coverage_;
+};
+
+#endif //PIPELINE_H
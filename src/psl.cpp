@@ -5,50 +5,89 @@
 #include "psl.h"
 #include "error.h"
 
-// Function to handle opening and line-by-line parsing of files
-void psl_parse(const std::string &filename, std::vector<psl_t>& psls) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+#include <cstring>
+
+PslFileCls::PslFileCls(const std::string &filename) : file_(filename) {
+    if (!file_.is_open()) {
         throw std::runtime_error("can't open file: " + filename);
     }
+}
 
-    psls.clear();  // clear the vector and fill in a new vector
+bool PslFileCls::next(psl_t &psl) {
     std::string line;
-    bool headerSkipped = false;
 
-    while (getline(file, line)) {
+    while (getline(file_, line)) {
         if (line.empty() || line[0] == '#') {
             continue; // discard the space row
         }
         // Skip header lines by checking for specific keywords or patterns
-        if (!headerSkipped) {
+        if (!headerSkipped_) {
             std::istringstream iss(line);
             std::string firstWord;
             iss >> firstWord;
             if (firstWord == "psLayout" || firstWord == "match") {
-                while (getline(file, line) && line.find("-------") == std::string::npos) {
+                while (getline(file_, line) && line.find("-------") == std::string::npos) {
                     // Skip until the dashed line at the end of the header is encountered
                 }
-                headerSkipped = true;
+                headerSkipped_ = true;
                 continue;
             }
-            headerSkipped = true;
+            headerSkipped_ = true;
         }
 
+        psl_record(line, psl);
+        return true;
+    }
+    return false;
+}
 
-        psl_t psl;
-        parse_line(line, psl);
-
-        // Adjust qEnd if it equals qSize, because of psl start end point problem itself
-        if (psl.qEnd == psl.qSize) {
-            psl.qEnd--; // Adjust qEnd
+size_t psl_header_size(const char* data, size_t size) {
+    size_t position = 0;
+    while (position < size) {
+        const char* line_end = static_cast<const char*>(memchr(data + position, '\n', size - position));
+        size_t next = line_end == nullptr ? size : line_end - data + 1;
+        std::string line(data + position, next - position - (line_end == nullptr ? 0 : 1));
+        if (!line.empty() && line[0] != '#') {
+            std::istringstream iss(line);
+            std::string firstWord;
+            iss >> firstWord;
+            if (firstWord != "psLayout" && firstWord != "match") {
+                return position;
+            }
+            // The header ends with a dashed line
+            do {
+                line_end = static_cast<const char*>(memchr(data + next, '\n', size - next));
+                line.assign(data + next, line_end == nullptr ? data + size : line_end);
+                next = line_end == nullptr ? size : line_end - data + 1;
+            } while (next < size && line.find("-------") == std::string::npos);
+            return next;
         }
+        position = next;
+    }
+    return position;
+}
 
-        validate_entry(psl);    // validate the psl file
-        psls.push_back(psl);    // put the file into container
+void psl_record(const std::string& line, psl_t& psl) {
+    psl = psl_t();
+    parse_line(line, psl);
+
+    // Adjust qEnd if it equals qSize, because of psl start end point problem itself
+    if (psl.qEnd == psl.qSize) {
+        psl.qEnd--; // Adjust qEnd
     }
 
-    file.close();  // close the file
+    validate_entry(psl);    // validate the psl file
+}
+
+// Function to handle opening and line-by-line parsing of files
+void psl_parse(const std::string &filename, std::vector<psl_t>& psls) {
+    PslFileCls file(filename);
+
+    psls.clear();  // clear the vector and fill in a new vector
+    psl_t psl;
+    while (file.next(psl)) {
+        psls.push_back(psl);    // put the file into container
+    }
 }
 
 
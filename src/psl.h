@@ -45,8 +45,26 @@ public:
 };
 
 
+// Reader of a PSL file one record at a time, the header of psLayout files is skipped
+class PslFileCls {
+public:
+    explicit PslFileCls(const std::string &filename);
+
+    bool next(psl_t &psl);
+
+private:
+    std::ifstream file_;
+    bool headerSkipped_ = false;
+};
+
 void psl_parse(const std::string &filename, std::vector<psl_t>& psls);
 
+// Number of bytes of the psLayout header at the start of a PSL file, 0 for files without a header
+size_t psl_header_size(const char* data, size_t size);
+
+// Parse and validate a record line of a PSL file
+void psl_record(const std::string& line, psl_t& psl);
+
 // Parse a single line from a PSL file to extract alignment information and populate a PslEntry structure.
 void parse_line(const std::string& line, psl_t& psl);
 
@@ -0,0 +1,196 @@
+#include "realign_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <unistd.h>
+
+#include "bowtie2.h"
+#include "checkpoint.h"
+
+namespace fs = std::filesystem;
+
+static const std::string ALIGNMENTS_STAGE = "Realignment";
+
+static std::string hex(uint64_t key) {
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016" PRIx64, key);
+    return buffer;
+}
+
+static uint64_t entry_size(const fs::directory_entry& entry) {
+    std::error_code error;
+    if (!entry.is_directory(error)) {
+        uintmax_t size = entry.file_size(error);
+        return error ? 0 : size;
+    }
+    uint64_t size = 0;
+    for (fs::recursive_directory_iterator file(entry.path(), error), end; !error && file != end; file.increment(error)) {
+        std::error_code file_error;
+        if (file->is_regular_file(file_error)) {
+            uintmax_t file_size = file->file_size(file_error);
+            size += file_error ? 0 : file_size;
+        }
+    }
+    return size;
+}
+
+RealignmentCache::RealignmentCache(const std::string& directory, uint64_t max_bytes):
+        directory_(directory), max_bytes_(max_bytes) {
+    std::error_code error;
+    fs::create_directories(directory_, error);
+}
+
+RealignmentCache::~RealignmentCache() {
+    // An index which was not built completely
+    if (!pending_index_.empty()) {
+        std::error_code error;
+        fs::remove_all(pending_index_, error);
+    }
+}
+
+bool RealignmentCache::index_key(const std::string& reference, uint64_t& key) {
+    uint64_t content;
+    if (!file_checksum(reference, content)) {
+        return false;
+    }
+    Checksum checksum;
+    checksum.update(content);
+    checksum.update(BOWTIE2_BUILD_PATH);
+    key = checksum.value();
+    return true;
+}
+
+uint64_t RealignmentCache::alignments_key(uint64_t index_key, const options_t& options) {
+    Checksum key;
+    key.update(index_key);
+    for (const auto* fastqs : {&options.input_fastq1, &options.input_fastq2}) {
+        key.update(static_cast<uint64_t>(fastqs->size()));
+        for (const auto& fastq : *fastqs) {
+            update_file_identity(key, fastq);
+        }
+    }
+    key.update(BOWTIE2_PATH);
+    key.update(BOWTIE2_PARAMETERS);
+    return key.value();
+}
+
+std::string RealignmentCache::index_directory(uint64_t key) const {
+    return directory_ + "/index-" + hex(key);
+}
+
+std::string RealignmentCache::alignments_file(uint64_t key) const {
+    return directory_ + "/alignments-" + hex(key) + ".bin";
+}
+
+// Unique in the process and among the processes sharing the cache
+std::string RealignmentCache::temporary(const std::string& path) const {
+    static std::atomic<uint64_t> counter(0);
+    return path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(counter++);
+}
+
+void RealignmentCache::touch(const std::string& path) {
+    std::error_code error;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    used_.push_back(fs::path(path).filename().string());
+}
+
+std::string RealignmentCache::find_index(uint64_t key) {
+    std::string directory = index_directory(key);
+    std::error_code error;
+    if (!fs::is_directory(directory, error)) {
+        return "";
+    }
+    touch(directory);
+    return directory + "/index";
+}
+
+std::string RealignmentCache::prepare_index(uint64_t key) {
+    pending_index_ = temporary(index_directory(key));
+    std::error_code error;
+    fs::create_directories(pending_index_, error);
+    return pending_index_ + "/index";
+}
+
+std::string RealignmentCache::commit_index(uint64_t key) {
+    std::string directory = index_directory(key);
+    std::error_code error;
+    fs::rename(pending_index_, directory, error);
+    if (error && !fs::is_directory(directory, error)) {
+        // Not cached, the temporary index is used by this run and removed with the cache
+        return pending_index_ + "/index";
+    }
+    // Another run may have stored the same index first
+    fs::remove_all(pending_index_, error);
+    pending_index_.clear();
+    return find_index(key);
+}
+
+bool RealignmentCache::load_alignments(uint64_t key, std::vector<sam_t>& reads) {
+    std::string filename = alignments_file(key);
+    CheckpointReader reader(filename, ALIGNMENTS_STAGE, key);
+    if (!reader.valid() || !reader.read(reads) || !reader.finish()) {
+        reads.clear();
+        return false;
+    }
+    touch(filename);
+    return true;
+}
+
+bool RealignmentCache::store_alignments(uint64_t key, const std::vector<sam_t>& reads) {
+    // The writer renames its own temporary file, which is made unique first
+    std::string filename = alignments_file(key);
+    std::string written = temporary(filename);
+    {
+        CheckpointWriter writer(written, ALIGNMENTS_STAGE, key);
+        writer.write(reads);
+        if (!writer.commit()) {
+            return false;
+        }
+    }
+    if (std::rename(written.c_str(), filename.c_str()) != 0) {
+        std::remove(written.c_str());
+        return false;
+    }
+    touch(filename);
+    return true;
+}
+
+void RealignmentCache::collect_garbage() {
+    struct entry_t {
+        fs::path path;
+        fs::file_time_type time;
+        uint64_t size;
+    };
+    std::vector<entry_t> entries;
+    uint64_t total = 0;
+    std::error_code error;
+    for (fs::directory_iterator entry(directory_, error), end; !error && entry != end; entry.increment(error)) {
+        std::string name = entry->path().filename().string();
+        // Entries being written by other runs
+        if (name.find(".tmp") != std::string::npos) {
+            continue;
+        }
+        uint64_t size = entry_size(*entry);
+        total += size;
+        if (std::find(used_.begin(), used_.end(), name) != used_.end()) {
+            continue;
+        }
+        std::error_code time_error;
+        entries.push_back({entry->path(), entry->last_write_time(time_error), size});
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const entry_t& a, const entry_t& b) { return a.time < b.time; });
+    for (const auto& entry : entries) {
+        if (total <= max_bytes_) {
+            break;
+        }
+        std::error_code remove_error;
+        fs::remove_all(entry.path, remove_error);
+        if (!remove_error) {
+            total -= entry.size;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef REALIGN_CACHE_H
+#define REALIGN_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "options.h"
+#include "sam.h"
+
+// Content addressed cache of the realignment, shared by the runs which name the same directory. The bowtie2 index is
+// keyed by the content of the reference, the realigned reads by the reference, the identities of the FASTQ files and
+// the bowtie2 parameters, so a rerun with other filter options skips bowtie2. An entry is written under a temporary
+// name and renamed, so a run never sees a partial entry. Each use touches the entry, and the least recently used
+// entries are removed once the cache grows past its size limit.
+class RealignmentCache {
+public:
+    RealignmentCache(const std::string& directory, uint64_t max_bytes);
+    ~RealignmentCache();
+
+    // Key of the index of a reference, false if the reference can not be read
+    static bool index_key(const std::string& reference, uint64_t& key);
+    // Key of the realigned reads, the FASTQ files are identified by path, size and modification time
+    static uint64_t alignments_key(uint64_t index_key, const options_t& options);
+
+    // Path prefix of the cached index, empty if it is not cached
+    std::string find_index(uint64_t key);
+    // Path prefix to build the index of the key under, commit_index moves it into the cache and returns its prefix
+    // there. An index which could not be moved stays at the temporary prefix until the cache goes away.
+    std::string prepare_index(uint64_t key);
+    std::string commit_index(uint64_t key);
+
+    // Cached realigned reads, false if they are not cached
+    bool load_alignments(uint64_t key, std::vector<sam_t>& reads);
+    bool store_alignments(uint64_t key, const std::vector<sam_t>& reads);
+
+    // Remove the least recently used entries until the cache fits its size limit. The entries of this run stay.
+    void collect_garbage();
+
+private:
+    std::string index_directory(uint64_t key) const;
+    std::string alignments_file(uint64_t key) const;
+    std::string temporary(const std::string& path) const;
+    void touch(const std::string& path);
+
+    std::string directory_;
+    uint64_t max_bytes_;
+    std::string pending_index_;         // temporary directory of the index being built
+    std::vector<std::string> used_;     // entries of this run
+};
+
+#endif //REALIGN_CACHE_H
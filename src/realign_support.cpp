@@ -2,13 +2,16 @@
 // Created by xinwei on 6/19/24.
 //
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <unordered_set>
 #include <fstream>
+#include <stdexcept>
 
 #include "realign_support.h"
 #include "options.h"
+#include "thread_pool.h"
 
 
 bool isReadSupportingOverlap(const sam_t& read, const OverlapResultCls& overlap, const options_t& options) {
@@ -30,19 +33,15 @@ bool isReadSupportingOverlap(const sam_t& read, const OverlapResultCls& overlap,
 
 
 
-// Initializing global variables
-std::unordered_map<std::string, std::vector<OverlapResultCls>> overlapMap;
-std::unordered_map<std::string, std::vector<sam_t>> samMap;
-
 // Filling overlapMap
-void fillOverlapMap(const std::vector<OverlapResultCls>& overlaps) {
+void fillOverlapMap(const std::vector<OverlapResultCls>& overlaps, std::unordered_map<std::string, std::vector<OverlapResultCls>>& overlapMap) {
     for (const auto& overlap : overlaps) {
         overlapMap[overlap.query_id_].push_back(overlap);
     }
 }
 
 // Populate samMap, organizing reads by rname (corresponding to query_id)
-void fillSamMap(const std::vector<sam_t>& samEntries) {
+void fillSamMap(const std::vector<sam_t>& samEntries, std::unordered_map<std::string, std::vector<sam_t>>& samMap) {
     for (const auto& sam : samEntries) {
         samMap[sam.rname].push_back(sam);
     }
@@ -50,6 +49,30 @@ void fillSamMap(const std::vector<sam_t>& samEntries) {
 
 
 
+// Number of the reads of a contig which support each of its overlaps, a read supporting two overlaps counts twice
+static int countSplitReadsOf(const std::vector<OverlapResultCls>& overlaps, const std::vector<sam_t>& reads, const options_t& options) {
+    int count = 0;
+    for (const auto& overlap : overlaps) {
+        for (const auto& read : reads) {
+            if (isReadSupportingOverlap(read, overlap, options)) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+static void collectSplitReadsOf(const std::vector<OverlapResultCls>& overlaps, const std::vector<sam_t>& reads, const options_t& options,
+                                std::vector<sam_t>& splitReads) {
+    for (const auto& overlap : overlaps) {
+        for (const auto& read : reads) {
+            if (isReadSupportingOverlap(read, overlap, options)) {
+                splitReads.push_back(read);
+            }
+        }
+    }
+}
+
 std::unordered_map<std::string, int> countSplitReads(
         const std::unordered_map<std::string, std::vector<OverlapResultCls>>& overlapMap,
         const std::unordered_map<std::string, std::vector<sam_t>>& samMap,
@@ -59,21 +82,9 @@ std::unordered_map<std::string, int> countSplitReads(
 
     for (const auto& overlapEntry : overlapMap) {
         const std::string& queryName = overlapEntry.first;
-        const std::vector<OverlapResultCls>& overlaps = overlapEntry.second;
-
-        if (samMap.find(queryName) != samMap.end()) {
-            const std::vector<sam_t>& reads = samMap.at(queryName);
-            int count = 0;
-
-            for (const auto& overlap : overlaps) {
-                for (const auto& read : reads) {
-                    if (isReadSupportingOverlap(read, overlap, options)) {
-                        ++count;
-                    }
-                }
-            }
-
-            splitReadsCount[queryName] = count;
+        auto reads = samMap.find(queryName);
+        if (reads != samMap.end()) {
+            splitReadsCount[queryName] = countSplitReadsOf(overlapEntry.second, reads->second, options);
         }
     }
 
@@ -118,6 +129,36 @@ bool isSpanningPair(const sam_t& read1, const sam_t& read2, const OverlapResultC
 
 
 
+// Use a mapping to group the reads of a contig by qname
+typedef std::unordered_map<std::string, std::vector<const sam_t*>> read_pairs_t;
+
+static read_pairs_t groupReadPairs(const std::vector<sam_t>& reads) {
+    read_pairs_t groupedReads;
+    for (const auto& read : reads) {
+        groupedReads[read.qname].push_back(&read);
+    }
+    return groupedReads;
+}
+
+static int countSpanReadPairsOf(const std::vector<OverlapResultCls>& overlaps, const read_pairs_t& groupedReads) {
+    int count = 0;
+    // Iterate over each group and compare only reads with the same qname
+    for (const auto& group : groupedReads) {
+        const std::vector<const sam_t*>& pairedReads = group.second;
+        // At least two readings are required to form a pair
+        for (size_t i = 0; i < pairedReads.size(); ++i) {
+            for (size_t j = i + 1; j < pairedReads.size(); ++j) {
+                for (const auto& overlap : overlaps) {
+                    if (isSpanningPair(*pairedReads[i], *pairedReads[j], overlap)) {
+                        count++;  // Each time a valid pair is found, the count increases by 1.
+                    }
+                }
+            }
+        }
+    }
+    return count;
+}
+
 std::unordered_map<std::string, int> countSpanReadPairs(
         const std::unordered_map<std::string, std::vector<OverlapResultCls>>& overlapMap,
         const std::unordered_map<std::string, std::vector<sam_t>>& samMap) {
@@ -126,40 +167,85 @@ std::unordered_map<std::string, int> countSpanReadPairs(
 
     for (const auto& overlapEntry : overlapMap) {
         const std::string& queryName = overlapEntry.first;
-        const std::vector<OverlapResultCls>& overlaps = overlapEntry.second;
+        auto reads = samMap.find(queryName);
+        if (reads != samMap.end()) {
+            spanPairsCount[queryName] = countSpanReadPairsOf(overlapEntry.second, groupReadPairs(reads->second));
+        }
+    }
 
-        if (samMap.find(queryName) != samMap.end()) {
-            const std::vector<sam_t>& reads = samMap.at(queryName);
-            int count = 0;
+    return spanPairsCount;
+}
 
-            // Use a mapping to group readings by qname
-            std::unordered_map<std::string, std::vector<sam_t>> groupedReads;
-            for (const auto& read : reads) {
-                groupedReads[read.qname].push_back(read);
-            }
 
-            // Iterate over each group and compare only reads with the same qname
-            for (const auto& group : groupedReads) {
-                const std::vector<sam_t>& pairedReads = group.second;
-                // At least two readings are required to form a pair
-                for (size_t i = 0; i < pairedReads.size(); ++i) {
-                    for (size_t j = i + 1; j < pairedReads.size(); ++j) {
-                        for (const auto& overlap : overlaps) {
-                            if (isSpanningPair(pairedReads[i], pairedReads[j], overlap)) {
-                                count++;  // Each time a valid pair is found, the count increases by 1.
-                            }
-                        }
-                    }
-                }
-            }
 
-            spanPairsCount[queryName] = count;
+junction_windows_t outputJunctionWindows(const std::unordered_map<std::string, std::string>& sequences,
+                                         const std::vector<OverlapResultCls>& overlaps, int flank,
+                                         const std::string& filename) {
+    // Intervals of the contigs in the order of their first overlap, so the file is the same on every run
+    std::vector<std::string> contigs;
+    std::unordered_map<std::string, std::vector<std::pair<int, int>>> intervals;
+    for (const auto& overlap : overlaps) {
+        auto sequence = sequences.find(overlap.query_id_);
+        if (sequence == sequences.end()) {
+            continue;
         }
+        int length = sequence->second.length();
+        auto& contig_intervals = intervals[overlap.query_id_];
+        if (contig_intervals.empty()) {
+            contigs.push_back(overlap.query_id_);
+        }
+        contig_intervals.emplace_back(std::max(overlap.start_ - flank, 0), std::min(overlap.end_ + flank, length));
     }
 
-    return spanPairsCount;
+    std::ofstream output_file(filename);
+    if (!output_file.is_open()) {
+        throw std::runtime_error("Failed to open output file: " + filename);
+    }
+
+    junction_windows_t windows;
+    for (const auto& contig : contigs) {
+        auto& contig_intervals = intervals[contig];
+        std::sort(contig_intervals.begin(), contig_intervals.end());
+        const std::string& sequence = sequences.at(contig);
+        for (size_t i = 0; i < contig_intervals.size();) {
+            int start = contig_intervals[i].first;
+            int end = contig_intervals[i].second;
+            for (++i; i < contig_intervals.size() && contig_intervals[i].first <= end; ++i) {
+                end = std::max(end, contig_intervals[i].second);
+            }
+            if (end <= start) {
+                continue;
+            }
+            std::string name = contig + ":" + std::to_string(start + 1) + "-" + std::to_string(end);
+            output_file << ">" << name << "\t" << end - start << "\n" << sequence.substr(start, end - start) << "\n";
+            windows[name] = {contig, start};
+        }
+    }
+
+    output_file.close();
+    return windows;
 }
 
+void remapJunctionWindows(std::vector<sam_t>& reads, const junction_windows_t& windows) {
+    for (auto& read : reads) {
+        auto window = windows.find(read.rname);
+        if (window == windows.end()) {
+            continue;
+        }
+        read.rname = window->second.contig;
+        read.pos += window->second.offset;
+        if (read.rnext == "=") {
+            read.pnext += window->second.offset;
+            continue;
+        }
+        // The mate on another window of the same contig
+        auto mate_window = windows.find(read.rnext);
+        if (mate_window != windows.end()) {
+            read.pnext += mate_window->second.offset;
+            read.rnext = mate_window->second.contig == read.rname ? "=" : mate_window->second.contig;
+        }
+    }
+}
 
 
 std::unordered_set<std::string> filterQueries(
@@ -194,14 +280,16 @@ std::vector<alignment_t> filterAlignmentsByValidBaseQueries(
 
 std::vector<alignment_t> filterAlignmentsByValidQueries(
         const std::vector<alignment_t>& alignments,
+        const std::vector<alignment_pair_t>& pairs,
         const std::unordered_set<std::string>& validQueries) {
 
     std::vector<alignment_t> filteredAlignments;
 
-    for (const alignment_t& alignment : alignments) {
-        // Assumes that query has at least one underscore.
-        if (validQueries.find(alignment.query) != validQueries.end()) {
-            filteredAlignments.push_back(alignment);
+    // Both alignments of a pair belong to the same query
+    for (const auto& pair : pairs) {
+        if (validQueries.find(alignments[pair.first].query) != validQueries.end()) {
+            filteredAlignments.push_back(alignments[pair.first]);
+            filteredAlignments.push_back(alignments[pair.second]);
         }
     }
 
@@ -309,22 +397,34 @@ std::unordered_map<std::string, std::vector<sam_t>> collectSplitReads(
 
     for (const auto& overlapEntry : overlapMap) {
         const std::string& queryName = overlapEntry.first;
-        const std::vector<OverlapResultCls>& overlaps = overlapEntry.second;
-
-        if (samMap.find(queryName) != samMap.end()) {
-            const std::vector<sam_t>& reads = samMap.at(queryName);
-            for (const auto& overlap : overlaps) {
-                for (const auto& read : reads) {
-                    if (isReadSupportingOverlap(read, overlap, options)) {
-                        splitReadsMap[queryName].push_back(read);
-                    }
-                }
+        auto reads = samMap.find(queryName);
+        if (reads != samMap.end()) {
+            std::vector<sam_t> splitReads;
+            collectSplitReadsOf(overlapEntry.second, reads->second, options, splitReads);
+            if (!splitReads.empty()) {
+                splitReadsMap[queryName] = std::move(splitReads);
             }
         }
     }
     return splitReadsMap;
 }
 
+static void collectSpanReadsOf(const std::vector<OverlapResultCls>& overlaps, const read_pairs_t& pairBuffer, std::vector<sam_t>& spanReads) {
+    // Evaluate pairs against the overlap region
+    for (const auto& overlap : overlaps) {
+        for (const auto& pairEntry : pairBuffer) {
+            const std::vector<const sam_t*>& pair = pairEntry.second;
+
+            // We only evaluate valid pairs (exactly 2 reads with the same name)
+            if (pair.size() == 2 && isSpanningPair(*pair[0], *pair[1], overlap)) {
+                // If they are a spanning pair, add BOTH to the output
+                spanReads.push_back(*pair[0]);
+                spanReads.push_back(*pair[1]);
+            }
+        }
+    }
+}
+
 std::unordered_map<std::string, std::vector<sam_t>> collectSpanReads(
     const std::unordered_map<std::string, std::vector<OverlapResultCls>>& overlapMap,
     const std::unordered_map<std::string, std::vector<sam_t>>& samMap,
@@ -335,44 +435,95 @@ std::unordered_map<std::string, std::vector<sam_t>> collectSpanReads(
 
     for (const auto& overlapEntry : overlapMap) {
         const std::string& queryName = overlapEntry.first; // The Contig Name
-        const std::vector<OverlapResultCls>& overlaps = overlapEntry.second;
-
-        // Check if this contig has mapped reads
-        if (samMap.find(queryName) != samMap.end()) {
-            const std::vector<sam_t>& reads = samMap.at(queryName);
-
-            // ---------------------------------------------------------
-            // Step 1: Group reads by Read Name (QNAME) to reconstruct pairs
-            // ---------------------------------------------------------
-            // We use a temporary map to buffer potential pairs
-            std::unordered_map<std::string, std::vector<sam_t>> pairBuffer;
-            for (const auto& read : reads) {
-                pairBuffer[read.qname].push_back(read);
-            }
 
-            // ---------------------------------------------------------
-            // Step 2: Evaluate pairs against the overlap region
-            // ---------------------------------------------------------
-            for (const auto& overlap : overlaps) {
-                for (const auto& pairEntry : pairBuffer) {
-                    const std::vector<sam_t>& pair = pairEntry.second;
-
-                    // We only evaluate valid pairs (exactly 2 reads with the same name)
-                    if (pair.size() == 2) {
-                        const sam_t& read1 = pair[0];
-                        const sam_t& read2 = pair[1];
-
-                        // Use your custom strict logic
-                        if (isSpanningPair(read1, read2, overlap)) {
-                            // If they are a spanning pair, add BOTH to the output
-                            spanReadsMap[queryName].push_back(read1);
-                            spanReadsMap[queryName].push_back(read2);
-                        }
-                    }
-                }
+        // Check if this contig has mapped reads, the reads are grouped by QNAME to reconstruct pairs
+        auto reads = samMap.find(queryName);
+        if (reads != samMap.end()) {
+            std::vector<sam_t> spanReads;
+            collectSpanReadsOf(overlapEntry.second, groupReadPairs(reads->second), spanReads);
+            if (!spanReads.empty()) {
+                spanReadsMap[queryName] = std::move(spanReads);
             }
         }
     }
 
     return spanReadsMap;
-}
\ No newline at end of file
+}
+
+
+SupportContext::SupportContext(const std::vector<OverlapResultCls>& overlaps, const std::vector<sam_t>& reads) {
+    fillOverlapMap(overlaps, overlapMap_);
+    fillSamMap(reads, samMap_);
+    // The contigs with reads in the order the sequential functions visit them
+    for (const auto& overlapEntry : overlapMap_) {
+        if (samMap_.count(overlapEntry.first) > 0) {
+            contigs_.push_back(&overlapEntry.first);
+        }
+    }
+}
+
+support_reads_t SupportContext::count(const options_t& options, int threads) const {
+    if (threads <= 1) {
+        return count(options, static_cast<ThreadPool*>(nullptr));
+    }
+    ThreadPool pool(threads);
+    return count(options, &pool);
+}
+
+support_reads_t SupportContext::count(const options_t& options, ThreadPool& pool) const {
+    return count(options, &pool);
+}
+
+support_reads_t SupportContext::count(const options_t& options, ThreadPool* pool) const {
+    // Results by contig, each worker writes the contigs of its blocks
+    struct contig_support_t {
+        int split_reads_count = 0;
+        int span_reads_count = 0;
+        std::vector<sam_t> split_reads;
+        std::vector<sam_t> span_reads;
+    };
+    std::vector<contig_support_t> contigs(contigs_.size());
+
+    auto count_contigs = [this, &contigs, &options](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const std::vector<OverlapResultCls>& overlaps = overlapMap_.at(*contigs_[i]);
+            const std::vector<sam_t>& reads = samMap_.at(*contigs_[i]);
+            read_pairs_t pairs = groupReadPairs(reads);
+            // Every supporting read is collected once per overlap, the same as countSplitReadsOf counts them
+            collectSplitReadsOf(overlaps, reads, options, contigs[i].split_reads);
+            contigs[i].split_reads_count = static_cast<int>(contigs[i].split_reads.size());
+            contigs[i].span_reads_count = countSpanReadPairsOf(overlaps, pairs);
+            collectSpanReadsOf(overlaps, pairs, contigs[i].span_reads);
+        }
+    };
+
+    // Several blocks per thread, so that a contig with many reads does not hold up the others
+    int threads = pool != nullptr ? pool->size() : 1;
+    size_t block = std::max<size_t>(1, contigs_.size() / (8 * std::max(threads, 1)));
+    if (threads <= 1 || contigs_.size() <= block) {
+        count_contigs(0, contigs_.size());
+    } else {
+        TaskGroup tasks(*pool);
+        for (size_t begin = 0; begin < contigs_.size(); begin += block) {
+            tasks.submit([&count_contigs, this, begin, block] {
+                count_contigs(begin, std::min(begin + block, contigs_.size()));
+            });
+        }
+        tasks.wait();
+    }
+
+    // Merge in the order of the contigs, so the maps do not depend on the number of threads
+    support_reads_t support;
+    for (size_t i = 0; i < contigs_.size(); ++i) {
+        const std::string& queryName = *contigs_[i];
+        support.split_reads_count[queryName] = contigs[i].split_reads_count;
+        support.span_reads_count[queryName] = contigs[i].span_reads_count;
+        if (!contigs[i].split_reads.empty()) {
+            support.split_reads[queryName] = std::move(contigs[i].split_reads);
+        }
+        if (!contigs[i].span_reads.empty()) {
+            support.span_reads[queryName] = std::move(contigs[i].span_reads);
+        }
+    }
+    return support;
+}
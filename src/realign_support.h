@@ -15,15 +15,13 @@
 #include "overlap.h"
 #include "sam.h"
 #include "options.h"
+#include "thread_pool.h"
 
 
 
-extern std::unordered_map<std::string, std::vector<OverlapResultCls>> overlapMap;
-extern std::unordered_map<std::string, std::vector<sam_t>> samMap;
-
-
-void fillOverlapMap(const std::vector<OverlapResultCls>& overlaps);
-void fillSamMap(const std::vector<sam_t>& samEntries);
+// The maps are owned by each run, so that several runs can count their support reads at the same time
+void fillOverlapMap(const std::vector<OverlapResultCls>& overlaps, std::unordered_map<std::string, std::vector<OverlapResultCls>>& overlapMap);
+void fillSamMap(const std::vector<sam_t>& samEntries, std::unordered_map<std::string, std::vector<sam_t>>& samMap);
 bool isReadSupportingOverlap(const sam_t& read, const OverlapResultCls& overlap, const options_t& options);
 bool isSpanningReadPair(const sam_t& read1, const sam_t& read2, const OverlapResultCls& overlap, const options_t& options);
 
@@ -44,6 +42,48 @@ std::unordered_map<std::string, std::vector<sam_t>> collectSpanReads(
     const std::unordered_map<std::string, std::vector<sam_t>>& samMap,
     const options_t& options);
 
+// Support reads of the contigs, by contig name
+struct support_reads_t {
+    std::unordered_map<std::string, int> split_reads_count;
+    std::unordered_map<std::string, int> span_reads_count;
+    std::unordered_map<std::string, std::vector<sam_t>> split_reads;
+    std::unordered_map<std::string, std::vector<sam_t>> span_reads;
+};
+
+// Overlaps and realigned reads of a run indexed by contig. The contigs are independent, so their support reads are
+// counted in parallel and merged in a fixed order; the result is the same as that of the four functions above.
+class SupportContext {
+public:
+    SupportContext(const std::vector<OverlapResultCls>& overlaps, const std::vector<sam_t>& reads);
+
+    support_reads_t count(const options_t& options, int threads) const;
+
+    // The same on the workers of a pool, which other runs may share
+    support_reads_t count(const options_t& options, ThreadPool& pool) const;
+
+private:
+    support_reads_t count(const options_t& options, ThreadPool* pool) const;
+
+    std::unordered_map<std::string, std::vector<OverlapResultCls>> overlapMap_;
+    std::unordered_map<std::string, std::vector<sam_t>> samMap_;
+    std::vector<const std::string*> contigs_;   // contigs with overlaps and reads
+};
+
+// A window of a contig around its junctions, which the reads are realigned to instead of the whole contig
+struct junction_window_t {
+    std::string contig;
+    int offset;         // 0-based start of the window in the contig
+};
+typedef std::unordered_map<std::string, junction_window_t> junction_windows_t;     // by name of the window
+
+// Write the windows of flank bases on both sides of the overlaps to a FASTA file, the windows overlapping each other
+// on a contig are merged. The windows are named contig:start-end with 1-based inclusive coordinates.
+junction_windows_t outputJunctionWindows(const std::unordered_map<std::string, std::string>& sequences,
+                                         const std::vector<OverlapResultCls>& overlaps, int flank,
+                                         const std::string& filename);
+// Move the reads realigned to the windows back to the coordinates of their contigs
+void remapJunctionWindows(std::vector<sam_t>& reads, const junction_windows_t& windows);
+
 
 
 std::unordered_set<std::string> filterQueries(
@@ -55,6 +95,7 @@ std::vector<alignment_t> filterAlignmentsByValidBaseQueries(
         const std::unordered_set<std::string>& validBaseQueries);
 std::vector<alignment_t> filterAlignmentsByValidQueries(
         const std::vector<alignment_t>& alignments,
+        const std::vector<alignment_pair_t>& pairs,
         const std::unordered_set<std::string>& validQueries);
 
 class coordination_t {
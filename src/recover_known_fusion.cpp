@@ -2,9 +2,39 @@
 // Created by xinwei on 10/1/24.
 //
 
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "recover_known_fusion.h"
 
 
+// Parse a coordinate of the form "-14:23058564-23095614" (strand, chromosome, start, end);
+// the strand is omitted for unstranded loci and the end is omitted for single positions
+bool parse_coordinates(const std::string& coordinate_str, coordinate_t& coordinate) {
+    bool stranded = !coordinate_str.empty() && (coordinate_str[0] == '+' || coordinate_str[0] == '-');
+    size_t chromosome_start = stranded ? 1 : 0;
+    size_t colon = coordinate_str.rfind(':');
+    if (colon == std::string::npos || colon <= chromosome_start)
+        return false;
+    size_t dash = coordinate_str.find('-', colon + 1);
+
+    coordinate.strand = stranded ? coordinate_str[0] : '.';
+    coordinate.chromosome = coordinate_str.substr(chromosome_start, colon - chromosome_start);
+    if (dash == std::string::npos) {
+        if (!str_to_int(coordinate_str.substr(colon + 1).c_str(), coordinate.start))
+            return false;
+        coordinate.end = coordinate.start;
+        return true;
+    }
+    return str_to_int(coordinate_str.substr(colon + 1, dash - colon - 1).c_str(), coordinate.start) &&
+           str_to_int(coordinate_str.substr(dash + 1).c_str(), coordinate.end);
+}
+
+
 // Function to parse known fusions from the TSV file
 std::vector<known_fusion_t> load_known_fusions(const std::string& filename) {
     std::vector<known_fusion_t> known_fusions;
@@ -27,6 +57,8 @@ std::vector<known_fusion_t> load_known_fusions(const std::string& filename) {
 
             // Start a new known fusion record
             std::istringstream ss(line.substr(1));  // Skip the '#'
+            current_fusion.gene1.clear();
+            current_fusion.gene2.clear();
             ss >> current_fusion.gene1 >> current_fusion.gene2;
 
             // Clear previous coordinate data for the new fusion
@@ -44,24 +76,10 @@ std::vector<known_fusion_t> load_known_fusions(const std::string& filename) {
             }
 
             coordinate_t coord1, coord2;
-
-            // Parse first coordinate
-            std::istringstream coord1_ss(coord1_str);
-            coord1_ss >> coord1.strand >> coord1.chromosome;
-            coord1.chromosome = coord1.chromosome.substr(1);  // Remove leading strand symbol
-            coord1_ss.ignore(1, ':');
-            coord1_ss >> coord1.start;
-            coord1_ss.ignore(1, '-');
-            coord1_ss >> coord1.end;
-
-            // Parse second coordinate
-            std::istringstream coord2_ss(coord2_str);
-            coord2_ss >> coord2.strand >> coord2.chromosome;
-            coord2.chromosome = coord2.chromosome.substr(1);  // Remove leading strand symbol
-            coord2_ss.ignore(1, ':');
-            coord2_ss >> coord2.start;
-            coord2_ss.ignore(1, '-');
-            coord2_ss >> coord2.end;
+            if (!parse_coordinates(coord1_str, coord1) || !parse_coordinates(coord2_str, coord2)) {
+                std::cerr << "Failed to parse coordinates: " << line << std::endl;
+                continue;
+            }
 
             // Store the parsed coordinates and source
             current_fusion.coordinates1.push_back(coord1);
@@ -79,43 +97,300 @@ std::vector<known_fusion_t> load_known_fusions(const std::string& filename) {
 }
 
 
+// Round a section size up to 8 bytes so that every section of the packed database stays aligned
+static size_t align8(size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+
+std::vector<char> KnownFusionIndex::pack(const std::vector<known_fusion_t>& known_fusions) {
+    // Intern gene and chromosome names in sorted order
+    std::vector<std::string> symbols;
+    for (const auto& known_fusion : known_fusions) {
+        symbols.push_back(known_fusion.gene1);
+        symbols.push_back(known_fusion.gene2);
+        for (const auto& coordinate : known_fusion.coordinates1)
+            symbols.push_back(coordinate.chromosome);
+        for (const auto& coordinate : known_fusion.coordinates2)
+            symbols.push_back(coordinate.chromosome);
+    }
+    std::sort(symbols.begin(), symbols.end());
+    symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+    auto symbol_id = [&symbols](const std::string& name) {
+        return static_cast<uint32_t>(std::lower_bound(symbols.begin(), symbols.end(), name) - symbols.begin());
+    };
+
+    // Gene pairs are sorted by their interned gene IDs, keeping the file order of repeated pairs
+    std::vector<size_t> order(known_fusions.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return std::make_pair(symbol_id(known_fusions[a].gene1), symbol_id(known_fusions[a].gene2)) <
+               std::make_pair(symbol_id(known_fusions[b].gene1), symbol_id(known_fusions[b].gene2));
+    });
+
+    std::vector<known_fusion_pair_t> pairs;
+    std::vector<known_fusion_range_t> ranges;
+    auto append_ranges = [&](const std::vector<coordinate_t>& coordinates) {
+        for (const auto& coordinate : coordinates) {
+            known_fusion_range_t range = {};
+            range.chromosome = symbol_id(coordinate.chromosome);
+            range.start = coordinate.start;
+            range.end = coordinate.end;
+            range.strand = coordinate.strand;
+            ranges.push_back(range);
+        }
+    };
+    for (size_t i : order) {
+        const known_fusion_t& known_fusion = known_fusions[i];
+        known_fusion_pair_t pair = {};
+        pair.gene1 = symbol_id(known_fusion.gene1);
+        pair.gene2 = symbol_id(known_fusion.gene2);
+        pair.first_range1 = ranges.size();
+        pair.range_count1 = known_fusion.coordinates1.size();
+        append_ranges(known_fusion.coordinates1);
+        pair.first_range2 = ranges.size();
+        pair.range_count2 = known_fusion.coordinates2.size();
+        append_ranges(known_fusion.coordinates2);
+        pairs.push_back(pair);
+    }
+
+    std::vector<uint32_t> symbol_offsets;
+    std::string strings;
+    for (const auto& symbol : symbols) {
+        symbol_offsets.push_back(strings.size());
+        strings.append(symbol).push_back('\0');
+    }
+
+    known_fusions_header_t header = {};
+    std::memcpy(header.magic, KNOWN_FUSIONS_MAGIC, sizeof(header.magic));
+    header.version = KNOWN_FUSIONS_VERSION;
+    header.symbol_count = symbols.size();
+    header.pair_count = pairs.size();
+    header.range_count = ranges.size();
+    header.string_bytes = strings.size();
+
+    size_t offsets_bytes = align8(symbol_offsets.size() * sizeof(uint32_t));
+    std::vector<char> buffer(sizeof(header) + offsets_bytes + pairs.size() * sizeof(known_fusion_pair_t) +
+                             ranges.size() * sizeof(known_fusion_range_t) + strings.size(), '\0');
+    char* out = buffer.data();
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    if (!symbol_offsets.empty())
+        std::memcpy(out, symbol_offsets.data(), symbol_offsets.size() * sizeof(uint32_t));
+    out += offsets_bytes;
+    if (!pairs.empty())
+        std::memcpy(out, pairs.data(), pairs.size() * sizeof(known_fusion_pair_t));
+    out += pairs.size() * sizeof(known_fusion_pair_t);
+    if (!ranges.empty())
+        std::memcpy(out, ranges.data(), ranges.size() * sizeof(known_fusion_range_t));
+    out += ranges.size() * sizeof(known_fusion_range_t);
+    std::memcpy(out, strings.data(), strings.size());
+    return buffer;
+}
+
+
+KnownFusionIndex::KnownFusionIndex(const std::string& filename) {
+    load(filename);
+}
+
+KnownFusionIndex::~KnownFusionIndex() {
+    release();
+}
+
+void KnownFusionIndex::release() {
+    if (mapping_ != nullptr)
+        munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    buffer_.clear();
+    header_ = nullptr;
+}
+
+
+bool KnownFusionIndex::is_packed(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    char magic[sizeof(KNOWN_FUSIONS_MAGIC)];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, KNOWN_FUSIONS_MAGIC, sizeof(magic)) == 0;
+}
+
+
+// Errors of a known fusions database are thrown, so that they fail the run which loads it rather than the process,
+// e.g. a sample of a batch
+static void database_error(bool condition, const std::string& message) {
+    if (condition)
+        throw std::runtime_error(message);
+}
+
+
+void KnownFusionIndex::load(const std::string& filename) {
+    release();
+
+    if (!is_packed(filename)) {
+        // Compile the TSV in memory, the lookup code is the same for both formats
+        buffer_ = pack(load_known_fusions(filename));
+        attach(buffer_.data(), buffer_.size(), filename);
+        return;
+    }
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    database_error(fd < 0, "failed to open known fusions database: " + filename);
+    struct stat file_info;
+    if (fstat(fd, &file_info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("failed to stat known fusions database: " + filename);
+    }
+    mapping_size_ = file_info.st_size;
+    void* mapping = mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping_size_ = 0;
+        throw std::runtime_error("failed to map known fusions database: " + filename);
+    }
+    mapping_ = mapping;
+    try {
+        attach(static_cast<const char*>(mapping_), mapping_size_, filename);
+    } catch (...) {
+        // The destructor does not run if the constructor throws
+        release();
+        throw;
+    }
+}
+
+
+void KnownFusionIndex::attach(const char* data, size_t size, const std::string& filename) {
+    database_error(size < sizeof(known_fusions_header_t), "truncated known fusions database: " + filename);
+    const auto* header = reinterpret_cast<const known_fusions_header_t*>(data);
+    database_error(std::memcmp(header->magic, KNOWN_FUSIONS_MAGIC, sizeof(header->magic)) != 0, "invalid known fusions database: " + filename);
+    database_error(header->version != KNOWN_FUSIONS_VERSION, "unsupported known fusions database version: " + filename);
+
+    size_t offsets_bytes = align8(static_cast<size_t>(header->symbol_count) * sizeof(uint32_t));
+    size_t pairs_bytes = static_cast<size_t>(header->pair_count) * sizeof(known_fusion_pair_t);
+    size_t ranges_bytes = static_cast<size_t>(header->range_count) * sizeof(known_fusion_range_t);
+    database_error(sizeof(known_fusions_header_t) + offsets_bytes + pairs_bytes + ranges_bytes + header->string_bytes != size,
+          "truncated known fusions database: " + filename);
+
+    const auto* symbol_offsets = reinterpret_cast<const uint32_t*>(data + sizeof(known_fusions_header_t));
+    const auto* pairs = reinterpret_cast<const known_fusion_pair_t*>(data + sizeof(known_fusions_header_t) + offsets_bytes);
+    const auto* ranges = reinterpret_cast<const known_fusion_range_t*>(reinterpret_cast<const char*>(pairs) + pairs_bytes);
+    const char* strings = reinterpret_cast<const char*>(ranges) + ranges_bytes;
+
+    // The lookups index the sections without checks, so every reference must stay inside its section
+    database_error(header->string_bytes > 0 && strings[header->string_bytes - 1] != '\0', "invalid known fusions database: " + filename);
+    for (uint32_t i = 0; i < header->symbol_count; ++i)
+        database_error(symbol_offsets[i] >= header->string_bytes, "invalid known fusions database: " + filename);
+    for (uint32_t i = 0; i < header->pair_count; ++i) {
+        const known_fusion_pair_t& pair = pairs[i];
+        database_error(pair.gene1 >= header->symbol_count || pair.gene2 >= header->symbol_count ||
+              static_cast<uint64_t>(pair.first_range1) + pair.range_count1 > header->range_count ||
+              static_cast<uint64_t>(pair.first_range2) + pair.range_count2 > header->range_count,
+              "invalid known fusions database: " + filename);
+    }
+    for (uint32_t i = 0; i < header->range_count; ++i)
+        database_error(ranges[i].chromosome >= header->symbol_count, "invalid known fusions database: " + filename);
+
+    header_ = header;
+    symbol_offsets_ = symbol_offsets;
+    pairs_ = pairs;
+    ranges_ = ranges;
+    strings_ = strings;
+}
+
+
+int64_t KnownFusionIndex::find_symbol(const std::string& name) const {
+    if (header_ == nullptr)
+        return -1;
+    const uint32_t* first = symbol_offsets_;
+    const uint32_t* last = symbol_offsets_ + header_->symbol_count;
+    const uint32_t* found = std::lower_bound(first, last, name, [this](uint32_t offset, const std::string& value) {
+        return std::strcmp(strings_ + offset, value.c_str()) < 0;
+    });
+    if (found == last || name != strings_ + *found)
+        return -1;
+    return found - first;
+}
+
+
+const known_fusion_pair_t* KnownFusionIndex::find(const std::string& gene1, const std::string& gene2) const {
+    int64_t id1 = find_symbol(gene1);
+    int64_t id2 = find_symbol(gene2);
+    if (id1 < 0 || id2 < 0)
+        return nullptr;
+
+    const known_fusion_pair_t* last = pairs_ + header_->pair_count;
+    const known_fusion_pair_t* found = std::lower_bound(pairs_, last, std::make_pair(id1, id2),
+        [](const known_fusion_pair_t& pair, const std::pair<int64_t, int64_t>& key) {
+            return std::make_pair<int64_t, int64_t>(pair.gene1, pair.gene2) < key;
+        });
+    if (found == last || found->gene1 != id1 || found->gene2 != id2)
+        return nullptr;
+    return found;
+}
+
+
+// Check whether the result positions overlap any combination of the coordinates of gene1 and gene2. The strand of
+// the coordinates is not compared, the results carry the strand of the contig alignment rather than of the gene.
+bool KnownFusionIndex::overlaps(const known_fusion_pair_t& pair, const result_t& result, bool reversed) const {
+    for (uint32_t i = 0; i < pair.range_count1; ++i) {
+        const known_fusion_range_t& coord1 = ranges_[pair.first_range1 + i];
+        for (uint32_t j = 0; j < pair.range_count2; ++j) {
+            const known_fusion_range_t& coord2 = ranges_[pair.first_range2 + j];
+            bool matched = reversed ?
+                (result.tstart1 <= static_cast<unsigned int>(coord2.end) && result.tend1 >= static_cast<unsigned int>(coord2.start) &&
+                 result.tstart2 <= static_cast<unsigned int>(coord1.end) && result.tend2 >= static_cast<unsigned int>(coord1.start)) :
+                (result.tstart1 <= static_cast<unsigned int>(coord1.end) && result.tend1 >= static_cast<unsigned int>(coord1.start) &&
+                 result.tstart2 <= static_cast<unsigned int>(coord2.end) && result.tend2 >= static_cast<unsigned int>(coord2.start));
+            if (matched)
+                return true;
+        }
+    }
+    return false;
+}
+
+
+bool KnownFusionIndex::matches(const result_t& result) const {
+    if (empty())
+        return false;
+    const known_fusion_pair_t* last = pairs_ + header_->pair_count;
+    // Repeated gene pairs are stored next to each other
+    const std::string& gene1 = SYMBOLS.str(result.gene1);
+    const std::string& gene2 = SYMBOLS.str(result.gene2);
+    const known_fusion_pair_t* direct = find(gene1, gene2);
+    for (const known_fusion_pair_t* pair = direct; direct != nullptr && pair != last &&
+         pair->gene1 == direct->gene1 && pair->gene2 == direct->gene2; ++pair)
+        if (overlaps(*pair, result, false))
+            return true;
+    const known_fusion_pair_t* reversed = find(gene2, gene1);
+    for (const known_fusion_pair_t* pair = reversed; reversed != nullptr && pair != last &&
+         pair->gene1 == reversed->gene1 && pair->gene2 == reversed->gene2; ++pair)
+        if (overlaps(*pair, result, true))
+            return true;
+    return false;
+}
+
+
+void compile_known_fusions(const std::string& tsv_filename, const std::string& packed_filename) {
+    std::vector<known_fusion_t> known_fusions = load_known_fusions(tsv_filename);
+    crash(known_fusions.empty(), "no known fusions found in " + tsv_filename);
+
+    std::vector<char> buffer = KnownFusionIndex::pack(known_fusions);
+    std::ofstream out(packed_filename, std::ios::binary | std::ios::trunc);
+    crash(!out.is_open(), "failed to open file for writing: " + packed_filename);
+    out.write(buffer.data(), buffer.size());
+    crash(!out, "failed to write file: " + packed_filename);
+}
+
+
 // Function to recover known fusions from discarded results
-std::vector<result_t> recover_fusions(const std::vector<result_t>& discarded_results, const std::vector<known_fusion_t>& known_fusions) {
+std::vector<result_t> recover_fusions(const std::vector<result_t>& discarded_results, const KnownFusionIndex& known_fusions) {
     std::vector<result_t> recovered; // To store recovered results
 
-    for (const auto& known_fusion : known_fusions) {
-        for (const auto& result : discarded_results) {
-            bool recovered_flag = false; // Flag to indicate if a match is found
-
-            // Check each coordinate pair for gene1 and gene2
-            for (const auto& coord1 : known_fusion.coordinates1) {
-                for (const auto& coord2 : known_fusion.coordinates2) {
-                    // Check if genes and positions match (direct case)
-                    bool matches_direct =
-                        (result.gene1 == known_fusion.gene1 && result.gene2 == known_fusion.gene2 &&
-                         result.tstart1 <= coord1.end && result.tend1 >= coord1.start &&
-                         result.tstart2 <= coord2.end && result.tend2 >= coord2.start);
-
-                    // Check if genes and positions match (reversed case)
-                    bool matches_reversed =
-                        (result.gene1 == known_fusion.gene2 && result.gene2 == known_fusion.gene1 &&
-                         result.tstart1 <= coord2.end && result.tend1 >= coord2.start &&
-                         result.tstart2 <= coord1.end && result.tend2 >= coord1.start);
-
-                    // If either direct or reversed match is found, mark as recovered
-                    if (matches_direct || matches_reversed) {
-                        result_t recovered_result = result;
-                        recovered_result.filter_status = "recovered"; // Update the filter status
-                        recovered.push_back(recovered_result);
-                        recovered_flag = true;
-                        break;  // Stop checking further coordinates for this result
-                    }
-                }
-
-                if (recovered_flag) {
-                    break;  // Stop checking further coordinates for this known fusion
-                }
-            }
+    for (const auto& result : discarded_results) {
+        // Direct or reversed gene order, each discarded result is recovered at most once
+        if (known_fusions.matches(result)) {
+            result_t recovered_result = result;
+            recovered_result.recovered = true; // Update the filter status
+            recovered.push_back(recovered_result);
         }
     }
 
@@ -4,6 +4,7 @@
 
 #ifndef FUSION_DETECTION_2_RECOVER_KNOWN_FUSION_H
 #define FUSION_DETECTION_2_RECOVER_KNOWN_FUSION_H
+#include <cstdint>
 #include <string>
 #include "output_fusions.h"
 
@@ -24,11 +25,94 @@ struct known_fusion_t {
     std::string source;
 };
 
-bool parse_coordinates(const std::string& coordinate_str, std::string& chrom, int& start, int& end);
+// Layout of the packed known fusion database:
+//   header | symbol offsets | gene pairs | coordinate ranges | symbol strings
+// Symbols (gene and chromosome names) are interned and sorted, gene pairs are sorted by (gene1, gene2),
+// so the file can be memory-mapped and searched in place without any parsing at startup.
+const char KNOWN_FUSIONS_MAGIC[8] = {'D', 'F', 'K', 'F', 'D', 'B', '\0', '\1'};
+const uint32_t KNOWN_FUSIONS_VERSION = 1;
+
+struct known_fusions_header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t symbol_count;
+    uint32_t pair_count;
+    uint32_t range_count;
+    uint64_t string_bytes;
+};
+
+struct known_fusion_range_t {
+    uint32_t chromosome;    // symbol ID
+    int32_t start;
+    int32_t end;
+    char strand;            // '+', '-' or '.' for unstranded loci
+    char padding[3];
+};
+
+struct known_fusion_pair_t {
+    uint32_t gene1;         // symbol ID
+    uint32_t gene2;         // symbol ID
+    uint32_t first_range1;  // ranges of gene1, index into the range section
+    uint32_t range_count1;
+    uint32_t first_range2;  // ranges of gene2
+    uint32_t range_count2;
+};
+
+// Read-only index of known fusions, backed either by a memory-mapped packed database or by a TSV compiled in memory
+class KnownFusionIndex {
+public:
+    KnownFusionIndex() = default;
+    explicit KnownFusionIndex(const std::string& filename);
+    ~KnownFusionIndex();
+    KnownFusionIndex(const KnownFusionIndex&) = delete;
+    KnownFusionIndex& operator=(const KnownFusionIndex&) = delete;
+
+    // Load a packed database or a TSV file; a missing file yields an empty index
+    void load(const std::string& filename);
+
+    size_t size() const { return header_ == nullptr ? 0 : header_->pair_count; }
+    bool empty() const { return size() == 0; }
+
+    // Find the record of an ordered gene pair, nullptr if the pair is not known
+    const known_fusion_pair_t* find(const std::string& gene1, const std::string& gene2) const;
+
+    // Check whether a result overlaps a known fusion, in either gene order
+    bool matches(const result_t& result) const;
+
+    const known_fusion_range_t* ranges() const { return ranges_; }
+    const char* symbol(uint32_t id) const { return strings_ + symbol_offsets_[id]; }
+
+    // Check whether a file starts with the magic bytes of a packed database
+    static bool is_packed(const std::string& filename);
+
+    // Serialize known fusions into the packed layout
+    static std::vector<char> pack(const std::vector<known_fusion_t>& known_fusions);
+
+private:
+    void attach(const char* data, size_t size, const std::string& filename);
+    void release();
+    int64_t find_symbol(const std::string& name) const;
+    bool overlaps(const known_fusion_pair_t& pair, const result_t& result, bool reversed) const;
+
+    std::vector<char> buffer_;      // owns the data when compiled from TSV
+    void* mapping_ = nullptr;       // owns the data when memory-mapped
+    size_t mapping_size_ = 0;
+
+    const known_fusions_header_t* header_ = nullptr;
+    const uint32_t* symbol_offsets_ = nullptr;
+    const known_fusion_pair_t* pairs_ = nullptr;
+    const known_fusion_range_t* ranges_ = nullptr;
+    const char* strings_ = nullptr;
+};
+
+bool parse_coordinates(const std::string& coordinate_str, coordinate_t& coordinate);
 
 std::vector<known_fusion_t> load_known_fusions(const std::string& filename);
 
-std::vector<result_t> recover_fusions(const std::vector<result_t>& discarded_results, const std::vector<known_fusion_t>& known_fusions);
+// Compile the TSV of known fusions into a packed database
+void compile_known_fusions(const std::string& tsv_filename, const std::string& packed_filename);
+
+std::vector<result_t> recover_fusions(const std::vector<result_t>& discarded_results, const KnownFusionIndex& known_fusions);
 
 
 
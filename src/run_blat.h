@@ -1,12 +0,0 @@
-//
-// Created by xinwei on 12/4/24.
-//
-
-#ifndef RUN_BLAT_H
-#define RUN_BLAT_H
-
-#include "options.h"
-
-void run_blat(const options_t& options);
-
-#endif //RUN_BLAT_H
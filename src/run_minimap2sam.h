@@ -1,12 +0,0 @@
-//
-// Created by xinwei on 12/4/24.
-//
-
-#ifndef RUN_MINIMAP2SAM_H
-#define RUN_MINIMAP2SAM_H
-
-#include "options.h"
-
-void run_minimap2sam(const options_t& options);
-
-#endif //RUN_MINIMAP2SAM_H
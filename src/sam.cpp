@@ -121,27 +121,29 @@ bool SamFileCls::next(sam_t &sam) {
     }
 
     while (std::getline(file_, curr_line_)) {
-        if (curr_line_.empty() || curr_line_[0] == '@') {  // Skip header rows or empty lines
-            continue;
+        if (sam_record(curr_line_, sam)) {
+            return true;  // If a valid SAM record is found, it returns
         }
+    }
 
-        sam = sam_t(curr_line_);
+    finished_ = true;
+    return false;
+}
 
-        // Skip secondary alignments (tp:A:S)
-        if (sam.tp_label == "S") {
-            continue;
-        }
+bool sam_record(const std::string &line, sam_t &sam) {
+    if (line.empty() || line[0] == '@') {  // Skip header rows or empty lines
+        return false;
+    }
 
-        // If CIGAR is "*", skip the line and continue reading the next line
-        if (sam.cigar == "*") {
-            continue;
-        }
+    sam = sam_t(line);
 
-        return true;  // If a valid SAM record is found, it returns
+    // Skip secondary alignments (tp:A:S)
+    if (sam.tp_label == "S") {
+        return false;
     }
 
-    finished_ = true;
-    return false;
+    // If CIGAR is "*", skip the line and continue reading the next line
+    return sam.cigar != "*";
 }
 
 
@@ -185,4 +187,18 @@ void loadSamFile(const std::string& filePath, std::vector<sam_t>& samEntries) {
     if (samEntries.empty()) {
         throw SamError("SAM file is empty：" + filePath);
     }
+}
+
+void writeSamFile(const std::string& filePath, const std::vector<sam_t>& samEntries) {
+    std::ofstream file(filePath);
+    if (!file.is_open()) {
+        throw SamError("cannot write SAM file: " + filePath);
+    }
+    for (const auto& samEntry : samEntries) {
+        file << samEntry.output() << "\n";
+    }
+    file.close();
+    if (file.fail()) {
+        throw SamError("cannot write SAM file: " + filePath);
+    }
 }
\ No newline at end of file
@@ -69,8 +69,14 @@ public:
 
 };
 
+// Parse a line of a SAM file, false for header lines, secondary and unmapped records
+bool sam_record(const std::string &line, sam_t &sam);
+
 std::unordered_map<std::string, int> count_qnames(const std::vector<sam_t>& alignments);
 
 void loadSamFile(const std::string& filePath, std::vector<sam_t>& samEntries);
 
+// Write the entries as a SAM file without header, as bowtie2 writes the realignment
+void writeSamFile(const std::string& filePath, const std::vector<sam_t>& samEntries);
+
 #endif // SAM_H
\ No newline at end of file
@@ -31,7 +31,7 @@ void writeEvidenceToFastq(
     for (const auto& res : finalResults) {
         // You can add logic here to only include "PASS" filters if needed
         // e.g., if (res.filter_status == "PASS")
-        validContigs.insert(res.contig);
+        validContigs.insert(SYMBOLS.str(res.contig));
     }
 
     std::cout << "[INFO] Filtering evidence reads for " << validContigs.size() << " final fusion candidates.\n";
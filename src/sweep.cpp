@@ -0,0 +1,345 @@
+#include "sweep.h"
+
+#include <chrono>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <unistd.h>
+
+#include "contig_pair_index.h"
+#include "filter_chain.h"
+#include "filter_homologs.h"
+#include "input_adapter.h"
+#include "options.h"
+#include "pipeline.h"
+#include "recover_known_fusion.h"
+#include "symbol_table.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+// Filter option which can be swept, set validates the value with the limits of the command line
+struct sweep_parameter_t {
+    const char* name;
+    bool (*set)(const char* value, options_t& options);
+};
+
+static const sweep_parameter_t SWEEP_PARAMETERS[] = {
+    {"min-split-reads", [](const char* value, options_t& options) { return validate_int(value, options.min_split_reads, 1, 50); }},
+    {"min-span-reads", [](const char* value, options_t& options) { return validate_int(value, options.min_span_reads, 1, 50); }},
+    {"size-ratio-threshold", [](const char* value, options_t& options) { return validate_float(value, options.size_ratio_threshold, 0.01, 0.2); }},
+    {"long-gap-threshold", [](const char* value, options_t& options) { return validate_int(value, options.long_gap_threshold, 100000, 1000000); }},
+    {"short-segment-threshold", [](const char* value, options_t& options) { return validate_int(value, options.short_segment_threshold, 1, 100); }},
+    {"max-itd-length", [](const char* value, options_t& options) { return validate_int(value, options.max_itd_length, 1); }},
+    {"min-itd-fraction", [](const char* value, options_t& options) { return validate_float(value, options.min_itd_fraction, 0, 1); }},
+};
+
+static const sweep_parameter_t* find_parameter(const std::string& name) {
+    for (const auto& parameter : SWEEP_PARAMETERS) {
+        if (name == parameter.name) {
+            return &parameter;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string> sweep_parameters() {
+    std::vector<std::string> names;
+    for (const auto& parameter : SWEEP_PARAMETERS) {
+        names.push_back(parameter.name);
+    }
+    return names;
+}
+
+
+// Fusions are compared by their genes, in either order
+typedef std::pair<std::string, std::string> gene_pair_t;
+
+static gene_pair_t make_gene_pair(const std::string& gene1, const std::string& gene2) {
+    return gene1 < gene2 ? gene_pair_t(gene1, gene2) : gene_pair_t(gene2, gene1);
+}
+
+// Gene pairs of a truth set, either a TSV with the columns Gene1 and Gene2, e.g. the fusion list or the truth of
+// denovofusion_simulate, or a list with the two genes in the first columns
+static std::set<gene_pair_t> load_truth(const std::string& filename) {
+    std::ifstream file(filename);
+    crash(!file.is_open(), "failed to open truth file: " + filename);
+
+    std::set<gene_pair_t> truth;
+    size_t gene1_column = 0;
+    size_t gene2_column = 1;
+    bool first = true;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> columns;
+        std::istringstream ss(line);
+        std::string column;
+        while (std::getline(ss, column, '\t')) {
+            columns.push_back(column);
+        }
+
+        if (first) {
+            first = false;
+            auto gene1 = std::find(columns.begin(), columns.end(), "Gene1");
+            auto gene2 = std::find(columns.begin(), columns.end(), "Gene2");
+            if (gene1 != columns.end() && gene2 != columns.end()) {
+                gene1_column = gene1 - columns.begin();
+                gene2_column = gene2 - columns.begin();
+                continue;
+            }
+        }
+        crash(columns.size() <= std::max(gene1_column, gene2_column), "missing gene columns in truth file: " + filename);
+        truth.insert(make_gene_pair(columns[gene1_column], columns[gene2_column]));
+    }
+    return truth;
+}
+
+
+// Apply the filters of one grid point like Stage4 does, then recover the known fusions among the discarded ones
+static void evaluate(sweep_point_t& point, const options_t& options, const std::vector<result_t>& candidates,
+                     const FilterHomologs* filter_homologs,
+                     const KnownFusionIndex& known_fusions, const std::set<gene_pair_t>& truth) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<result_t> results = candidates;
+    FilterChain filter_chain;
+    add_fusion_filters(filter_chain, options, filter_homologs);
+    point.kept = filter_chain.apply(results);
+    for (size_t i = 0; i < filter_chain.size(); ++i) {
+        point.filter_discarded.push_back(filter_chain.discarded(i));
+    }
+
+    std::vector<result_t> discarded(std::make_move_iterator(results.begin() + point.kept), std::make_move_iterator(results.end()));
+    results.erase(results.begin() + point.kept, results.end());
+    std::vector<result_t> recovered = recover_fusions(discarded, known_fusions);
+    results.insert(results.end(), recovered.begin(), recovered.end());
+    point.recovered = recovered.size();
+    point.discarded = discarded.size() - recovered.size();
+
+    std::set<gene_pair_t> reported;
+    for (const auto& result : results) {
+        reported.insert(make_gene_pair(SYMBOLS.str(result.gene1), SYMBOLS.str(result.gene2)));
+    }
+    point.reported_pairs = reported.size();
+    for (const auto& pair : reported) {
+        point.true_positives += truth.count(pair);
+    }
+
+    point.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void run_sweep(const sweep_options_t& sweep_options) {
+    options_t base_options = get_default_options();
+    base_options.input_type = sweep_options.input_type;
+    if (!sweep_options.known_fusions.empty()) {
+        base_options.known_fusions = sweep_options.known_fusions;
+    }
+
+    // Load the candidates and the data shared by all grid points once
+    std::unique_ptr<InputAdapter> adapter = make_input_adapter(base_options.input_type);
+    crash(!adapter, "invalid alignment method: " + base_options.input_type + ", we support blat, minimap2sam and minimap2paf as input");
+    std::ostream quiet(nullptr);
+    Pipeline pipeline(base_options, *adapter, quiet);
+    std::cout << get_time_string() << " Loading the candidates from '" << sweep_options.checkpoint << "'" << std::endl;
+    crash(!pipeline.load_candidates(sweep_options.checkpoint), "not a valid Stage4 checkpoint: " + sweep_options.checkpoint);
+    const std::vector<result_t>& candidates = pipeline.final_results();
+
+    ContigPairIndex contig_pairs(pipeline.paired_alignments(), adapter->contig_name());
+    FilterHomologs filter_homologs(candidates, contig_pairs, pipeline.query_coordinates());
+    const FilterHomologs* homologs = adapter->fragmented() ? &filter_homologs : nullptr;
+    KnownFusionIndex known_fusions(base_options.known_fusions);
+    std::set<gene_pair_t> truth;
+    if (!sweep_options.truth.empty()) {
+        truth = load_truth(sweep_options.truth);
+    }
+
+    // All combinations of the grid values, the last parameter changes fastest
+    std::vector<sweep_point_t> points(1);
+    for (const auto& parameter : sweep_options.grid) {
+        std::vector<sweep_point_t> combined;
+        for (const auto& point : points) {
+            for (size_t i = 0; i < parameter.second.size(); ++i) {
+                combined.push_back(point);
+                combined.back().values.push_back(i);
+            }
+        }
+        points.swap(combined);
+    }
+    std::cout << get_time_string() << " Evaluating " << points.size() << " filter settings on " << candidates.size() << " candidates" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<options_t> point_options(points.size(), base_options);
+    {
+        ThreadPool pool(std::max(1, std::min(sweep_options.threads, static_cast<int>(points.size()))));
+        for (size_t i = 0; i < points.size(); ++i) {
+            for (size_t j = 0; j < sweep_options.grid.size(); ++j) {
+                const auto& parameter = sweep_options.grid[j];
+                find_parameter(parameter.first)->set(parameter.second[points[i].values[j]].c_str(), point_options[i]);
+            }
+            pool.submit([&, i] {
+                evaluate(points[i], point_options[i], candidates, homologs, known_fusions, truth);
+            });
+        }
+        pool.wait();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Names of the filters in chain order, the enabled filters are the same for all grid points
+    FilterChain filter_chain;
+    add_fusion_filters(filter_chain, base_options, homologs);
+
+    std::ofstream output(sweep_options.output);
+    crash(!output.is_open(), "failed to open output file: " + sweep_options.output);
+    for (const auto& parameter : sweep_options.grid) {
+        output << parameter.first << '\t';
+    }
+    output << "reported\tkept\trecovered\tdiscarded";
+    for (size_t i = 0; i < filter_chain.size(); ++i) {
+        output << "\tdiscarded_" << FILTERS[filter_chain.filter(i)];
+    }
+    if (!truth.empty()) {
+        output << "\ttrue_positives\trecall\tprecision";
+    }
+    output << "\tmilliseconds\n";
+
+    for (const auto& point : points) {
+        for (size_t j = 0; j < sweep_options.grid.size(); ++j) {
+            output << sweep_options.grid[j].second[point.values[j]] << '\t';
+        }
+        output << point.kept + point.recovered << '\t' << point.kept << '\t' << point.recovered << '\t' << point.discarded;
+        for (size_t count : point.filter_discarded) {
+            output << '\t' << count;
+        }
+        if (!truth.empty()) {
+            output << '\t' << point.true_positives
+                   << '\t' << static_cast<double>(point.true_positives) / truth.size()
+                   << '\t' << (point.reported_pairs == 0 ? 0.0 : static_cast<double>(point.true_positives) / point.reported_pairs);
+        }
+        output << '\t' << point.milliseconds << '\n';
+    }
+    std::cout << get_time_string() << " Done (" << points.size() << " settings in " << seconds << "s), results written to '" << sweep_options.output << "'" << std::endl;
+}
+
+
+static void print_sweep_usage() {
+    sweep_options_t defaults;
+    std::string parameters;
+    for (const auto& parameter : SWEEP_PARAMETERS) {
+        parameters += std::string(parameters.empty() ? "" : ", ") + parameter.name;
+    }
+    std::cout << std::endl
+              << "DenovoFusion sweep Version: " << DENOVOFUSION_VERSION << std::endl
+              << "------------------------------------------------------------------------" << std::endl
+              << wrap_help2("Evaluates a grid of filter settings on the annotated candidates of a Stage4 checkpoint, which is "
+                            "written by a run with -K. Every combination of the values is reported with the number of kept, "
+                            "recovered and discarded fusions, and with recall and precision if a truth set is given.") << std::endl
+              << "------------------------------------------------------------------------" << std::endl
+              << "Usage: " << std::endl
+              << "DenovoFusion sweep -m blat -c path/to/prefix_checkpoint/Stage4.ckpt -o sweep.tsv \\" << std::endl
+              << "             -g min-split-reads=1,2,3 -g size-ratio-threshold=0.05,0.1 [OPTIONS]" << std::endl
+              << "------------------------------------------------------------------------" << std::endl
+              << "Mandatory parameters" << std::endl
+              << wrap_help("-c", "--checkpoint") << std::endl
+              << wrap_help2("Stage4 checkpoint of a run with -K.") << std::endl
+              << wrap_help("-m", "--method") << std::endl
+              << wrap_help2("Alignment method of the run: blat, minimap2sam or minimap2paf.") << std::endl
+              << wrap_help("-o", "--output") << std::endl
+              << wrap_help2("Output TSV file with one line per grid point.") << std::endl
+              << "Optional parameter" << std::endl
+              << wrap_help("-g", "--grid") << std::endl
+              << wrap_help2("Parameter and its comma separated values, e.g. min-split-reads=1,2,3. Can be given for several "
+                            "parameters, the other filter options keep their defaults. Parameters: " + parameters + ".") << std::endl
+              << wrap_help("-h", "--help") << std::endl
+              << wrap_help2("Display this help message and exit.") << std::endl
+              << wrap_help("-k", "--known-fusions") << std::endl
+              << wrap_help2("Known fusions used to recover discarded candidates (Default: " + get_default_options().known_fusions + ").") << std::endl
+              << wrap_help("-q", "--threads") << std::endl
+              << wrap_help2("Number of grid points evaluated at the same time (Default: " + std::to_string(defaults.threads) + ").") << std::endl
+              << wrap_help("-t", "--truth") << std::endl
+              << wrap_help2("Truth set for recall and precision, a TSV with the columns Gene1 and Gene2, e.g. the truth of "
+                            "denovofusion_simulate, or with the two genes of a fusion in the first columns.") << std::endl;
+}
+
+int sweep_main(int argc, char** argv) {
+    sweep_options_t options;
+
+    static struct option long_options[] = {
+            {"checkpoint",    required_argument, nullptr, 'c'},
+            {"method",        required_argument, nullptr, 'm'},
+            {"output",        required_argument, nullptr, 'o'},
+            {"grid",          required_argument, nullptr, 'g'},
+            {"known-fusions", required_argument, nullptr, 'k'},
+            {"threads",       required_argument, nullptr, 'q'},
+            {"truth",         required_argument, nullptr, 't'},
+            {"help",          no_argument,       nullptr, 'h'},
+            {nullptr, 0, nullptr, 0}
+    };
+    const std::string valid_arguments = "c:m:o:g:k:q:t:h";
+
+    opterr = 0;
+    int c;
+    while ((c = getopt_long(argc, argv, valid_arguments.c_str(), long_options, nullptr)) != -1) {
+        switch (c) {
+            case 'c':
+                options.checkpoint = optarg;
+                crash(access(optarg, R_OK), "file not found/readable: " + options.checkpoint);
+                break;
+            case 'm': options.input_type = optarg; break;
+            case 'o': options.output = optarg; break;
+            case 'g': {
+                std::string grid(optarg);
+                size_t equals = grid.find('=');
+                crash(equals == std::string::npos, "invalid argument to -g, expected parameter=value,...: " + grid);
+                std::string name = grid.substr(0, equals);
+                const sweep_parameter_t* parameter = find_parameter(name);
+                crash(parameter == nullptr, "unknown parameter of -g: " + name);
+                for (const auto& entry : options.grid) {
+                    crash(entry.first == name, "parameter given more than once to -g: " + name);
+                }
+
+                std::vector<std::string> values;
+                std::istringstream ss(grid.substr(equals + 1));
+                std::string value;
+                while (std::getline(ss, value, ',')) {
+                    options_t check = get_default_options();
+                    crash(!parameter->set(value.c_str(), check), "invalid value of " + name + ": " + value);
+                    values.push_back(value);
+                }
+                crash(values.empty(), "no values of " + name + " given to -g");
+                options.grid.emplace_back(name, values);
+                break;
+            }
+            case 'k':
+                options.known_fusions = optarg;
+                break;
+            case 'q': crash(!validate_int(optarg, options.threads, 1, 64), "invalid argument to -q"); break;
+            case 't':
+                options.truth = optarg;
+                crash(access(optarg, R_OK), "file not found/readable: " + options.truth);
+                break;
+            case 'h':
+                print_sweep_usage();
+                exit(0);
+            default:
+                crash(valid_arguments.find(std::string(1, (char) optopt) + ":") != std::string::npos, "option -" + ((char) optopt) + " requires an argument");
+                crash(true, "unknown option: -" + ((char) optopt));
+        }
+    }
+
+    if (argc == 1) {
+        print_sweep_usage();
+        crash(true, "no arguments given");
+    }
+    crash(options.checkpoint.empty(), "missing mandatory option -c");
+    crash(options.input_type.empty(), "missing mandatory option -m");
+    crash(options.output.empty(), "missing mandatory option -o");
+
+    run_sweep(options);
+    return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Options of the sweep subcommand
+struct sweep_options_t {
+    std::string checkpoint;         // Stage4 checkpoint of a run with -K
+    std::string input_type;
+    std::string known_fusions;
+    std::string truth;
+    std::string output;
+    int threads = 4;
+    std::vector<std::pair<std::string, std::vector<std::string>>> grid;   // parameter name and its values
+};
+
+// Filter settings of one grid point and the fusions which pass them
+struct sweep_point_t {
+    std::vector<size_t> values;     // index into the values of each grid parameter
+    size_t kept = 0;
+    size_t recovered = 0;
+    size_t discarded = 0;
+    std::vector<size_t> filter_discarded;   // by filter in chain order
+    size_t true_positives = 0;
+    size_t reported_pairs = 0;      // distinct gene pairs of the kept and recovered fusions
+    double milliseconds = 0;
+};
+
+// Names of the filter options which can be swept, as the long options of DenovoFusion
+std::vector<std::string> sweep_parameters();
+
+// Evaluate all combinations of the grid values on the annotated candidates of a Stage4 checkpoint. The candidates,
+// the contig pairs and the known fusions are loaded once, the grid points are evaluated in parallel in memory
+// and written as TSV with recall and precision against the truth, if given
+void run_sweep(const sweep_options_t& options);
+
+// Command line of `DenovoFusion sweep`
+int sweep_main(int argc, char** argv);
+
+#endif //SWEEP_H
@@ -0,0 +1,51 @@
+#include <mutex>
+
+#include "symbol_table.h"
+
+SymbolTable SYMBOLS;
+
+
+SymbolTable::SymbolTable() {
+    intern("");
+}
+
+
+symbol_t SymbolTable::intern(const std::string& value) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto found = ids_.find(value);
+        if (found != ids_.end())
+            return found->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto found = ids_.find(value);
+    if (found != ids_.end())
+        return found->second;
+    symbol_t id = strings_.size();
+    strings_.push_back(value);
+    ids_.emplace(strings_.back(), id);
+    return id;
+}
+
+
+bool SymbolTable::find(const std::string& value, symbol_t& id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto found = ids_.find(value);
+    if (found == ids_.end())
+        return false;
+    id = found->second;
+    return true;
+}
+
+
+const std::string& SymbolTable::str(symbol_t id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return strings_[id];
+}
+
+
+size_t SymbolTable::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return strings_.size();
+}
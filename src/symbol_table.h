@@ -0,0 +1,38 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+typedef unsigned int symbol_t;
+const symbol_t SYMBOL_EMPTY = 0; // the empty string
+
+// Append-only pool of interned strings, e.g. contig, gene and chromosome names.
+// IDs are assigned in order of first appearance and stay valid for the lifetime of the process.
+class SymbolTable {
+public:
+    SymbolTable();
+
+    // Return the ID of the string, adding it to the pool if necessary
+    symbol_t intern(const std::string& value);
+
+    // Look up the ID of the string without adding it
+    bool find(const std::string& value, symbol_t& id) const;
+
+    const std::string& str(symbol_t id) const;
+
+    size_t size() const;
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::deque<std::string> strings_; // deque, so the views in ids_ stay valid when strings are added
+    std::unordered_map<std::string_view, symbol_t> ids_;
+};
+
+// Symbols shared by all stages of the program
+extern SymbolTable SYMBOLS;
+
+#endif //SYMBOL_TABLE_H
@@ -0,0 +1,65 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed number of worker threads which run the submitted tasks in the order of submission
+class ThreadPool {
+public:
+    explicit ThreadPool(int size);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers_.size()); }
+
+    void submit(std::function<void()> task);
+
+    // Block until all submitted tasks are finished, then rethrow the first exception a task threw since the last wait
+    void wait();
+
+private:
+    void work();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable task_available_;
+    std::condition_variable idle_;
+    int running_ = 0;       // tasks taken by a worker and not finished yet
+    bool stopping_ = false;
+    std::exception_ptr error_;
+};
+
+// Tasks of one user of a pool which several users share, e.g. the samples of a batch. wait() only waits for the tasks
+// of the group, so the users do not wait for each other
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool): pool_(pool) {}
+    // Waits for the tasks which are still running, their exceptions are dropped
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Block until the tasks of the group are finished, then rethrow the first exception one of them threw
+    void wait();
+
+private:
+    ThreadPool& pool_;
+    std::mutex mutex_;
+    std::condition_variable idle_;
+    int pending_ = 0;
+    std::exception_ptr error_;
+};
+
+#endif //THREAD_POOL_H
@@ -2,6 +2,46 @@
 # Enter DenovoFusion folder
 cd "$(dirname "$0")"
 
-# run test command
-./DenovoFusion -m blat -q 4 -r 100 -i test/test.psl -a test/test.fa -o test -p test -g test/test.gtf -1 test/test.01.fastq.gz -2 test/test.02.fastq.gz
+# the results are written to a temporary folder and compared with the expected results in test/
+output=$(mktemp -d)
+trap 'rm -rf "$output"' EXIT
+status=0
 
+# run_case <prefix> <compared output files> -- <extra options>
+run_case() {
+    local prefix=$1
+    shift
+    local files=()
+    while [ "$1" != "--" ]; do
+        files+=("$1")
+        shift
+    done
+    shift
+    ./DenovoFusion -m blat -q 4 -r 100 -i test/test.psl -a test/test.fa -o "$output" -p "$prefix" -g test/test.gtf -1 test/test.01.fastq.gz -2 test/test.02.fastq.gz "$@" || exit 1
+
+    # compare the outputs with the expected results
+    for file in "${files[@]}"; do
+        if ! cmp -s "test/$prefix.$file" "$output/$prefix.$file"; then
+            echo "FAILED: $prefix.$file differs from the expected result"
+            diff "test/$prefix.$file" "$output/$prefix.$file" | head -n 20
+            status=1
+        fi
+    done
+}
+
+run_case test fusion_list.tsv discarded_fusions.tsv per_base_coverage.tsv evidence_R1.fq evidence_R2.fq chosen.fasta --
+# The contig aligns to the minus strand of the two genes, the known fusion lists them on the plus strand; the fusion
+# is discarded for its support and recovered
+run_case test_known fusion_list.tsv discarded_fusions.tsv -- -k test/test_known.known_fusions.tsv -P 50
+
+# The candidate of the test is stored twice in the Stage4 checkpoint, the duplicate filter discards the copy at every
+# point of the sweep. The last column, the time of each point, is not compared
+./DenovoFusion sweep -m blat -c test/test_duplicates.Stage4.ckpt -o "$output/test_duplicates.sweep.tsv" \
+    -k test/test_known.known_fusions.tsv -g min-split-reads=1,3,5 > /dev/null || exit 1
+if ! awk 'BEGIN { FS = OFS = "\t" } { NF--; print }' "$output/test_duplicates.sweep.tsv" | cmp -s test/test_duplicates.sweep.tsv -; then
+    echo "FAILED: test_duplicates.sweep.tsv differs from the expected result"
+    status=1
+fi
+
+[ $status -eq 0 ] && echo "All outputs match the expected results"
+exit $status